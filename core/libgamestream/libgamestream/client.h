@@ -51,6 +51,16 @@ typedef struct _SERVER_DATA {
 
 typedef struct GS_CLIENT_T *GS_CLIENT;
 
+/**
+ * Completion callback of async requests. It's invoked on the HTTP thread, so it should return quickly.
+ */
+typedef void (*gs_status_cb)(int result, PSERVER_DATA server, void *userdata);
+
+/**
+ * Polled on the requesting thread while a request is in progress. Returning true aborts the request.
+ */
+typedef bool (*gs_cancel_token_fn)(void *userdata);
+
 GS_CLIENT gs_new(const char *keydir);
 
 int gs_conf_init(const char *keydir);
@@ -59,12 +69,22 @@ void gs_destroy(GS_CLIENT hnd);
 
 void gs_set_timeout(GS_CLIENT hnd, int timeout_secs);
 
+/**
+ * Once the token returns true, requests of this client stop within a few milliseconds instead of running into the
+ * timeout, and fail with GS_CANCELLED. Async requests don't check it.
+ */
+void gs_set_cancel_token(GS_CLIENT hnd, gs_cancel_token_fn token, void *userdata);
+
 int gs_get_status(GS_CLIENT hnd, PSERVER_DATA server, const char *address, uint16_t port, bool unsupported);
 
 int gs_start_app(GS_CLIENT hnd, PSERVER_DATA server, PSTREAM_CONFIGURATION config, int appId, bool is_gfe, bool sops,
                  bool localaudio, int gamepad_mask, const char *surround_params);
 
-int gs_applist(GS_CLIENT hnd, const SERVER_DATA *server, PAPP_LIST *app_list);
+/**
+ * @param item_size Size of each item in the result array, see xml_applist
+ * @param apps Result array, should be released with free()
+ */
+int gs_applist(GS_CLIENT hnd, const SERVER_DATA *server, size_t item_size, PAPP_ARRAY *apps);
 
 int gs_unpair(GS_CLIENT hnd, PSERVER_DATA server);
 
@@ -72,4 +92,17 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin);
 
 int gs_quit_app(GS_CLIENT hnd, PSERVER_DATA server);
 
-int gs_download_cover(GS_CLIENT hnd, const SERVER_DATA *server, int appId, const char *path);
\ No newline at end of file
+int gs_download_cover(GS_CLIENT hnd, const SERVER_DATA *server, int appId, const char *path);
+
+/*
+ * Async variant of gs_get_status. It returns GS_OK once the request is queued, and the callback is then invoked
+ * exactly once. The client handle must stay alive until the callback is invoked.
+ */
+
+int gs_get_status_async(GS_CLIENT hnd, PSERVER_DATA server, const char *address, uint16_t port, bool unsupported,
+                        gs_status_cb cb, void *userdata);
+
+/**
+ * Stop the thread running async requests. Pending callbacks are invoked with GS_CANCELLED before this returns.
+ */
+void gs_async_shutdown();
\ No newline at end of file
@@ -31,5 +31,9 @@
 #define GS_ERROR -9
 #define GS_NOT_SUPPORTED_SOPS_RESOLUTION -10
 #define GS_BAD_CONF -11
+#define GS_CANCELLED -12
 
+/**
+ * @return Last error set on the calling thread. Async callbacks see the error of the request they're called for.
+ */
 int gs_get_error(const char **message);
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdbool.h>
 
 #define CERTIFICATE_FILE_NAME "client.pem"
 #define KEY_FILE_NAME "key.pem"
@@ -31,14 +32,57 @@ typedef struct _HTTP_DATA {
     size_t size;
 } HTTP_DATA;
 
+/**
+ * Called on the async HTTP thread when a request finishes.
+ *
+ * @param result GS_OK on success
+ * @param data Response body, owned by the request and freed after this callback returns
+ */
+typedef void (*http_async_cb)(int result, HTTP_DATA *data, void *userdata);
+
+/**
+ * Polled on the requesting thread while a request is in progress. Returning true aborts the request.
+ */
+typedef bool (*http_cancel_fn)(void *userdata);
+
 HTTP *http_create(const char *keydir);
 
-int http_request(HTTP *http, char *url, HTTP_DATA * data);
+/**
+ * @param idempotent Request can safely reach the host twice. Only then it's retried on a new connection when a
+ *                   pooled one turns out to be broken, as the host may have acted on the first attempt already.
+ */
+int http_request(HTTP *http, char *url, HTTP_DATA * data, bool idempotent);
+
+/**
+ * Queue a request to the shared async HTTP thread. Any number of requests can be in flight at once.
+ *
+ * @param idempotent Same as http_request
+ * @return GS_OK if the request has been queued, and the callback will be invoked exactly once
+ */
+int http_request_async(HTTP *http, const char *url, bool idempotent, http_async_cb cb, void *userdata);
+
+/**
+ * Stop the async HTTP thread. Requests still in flight fail with GS_CANCELLED, and later ones are rejected.
+ */
+void http_async_shutdown();
 
 void http_destroy(HTTP *http);
 
 void http_set_timeout(HTTP *http, int timeout);
 
+/**
+ * Abort synchronous requests of this instance once fn returns true. They fail with GS_CANCELLED within a few
+ * milliseconds, and the connection is closed. Pass NULL to remove. Async requests don't check it.
+ */
+void http_set_cancel(HTTP *http, http_cancel_fn fn, void *userdata);
+
+/**
+ * Drop pooled connections and TLS sessions, so later requests to this host do a full TLS handshake.
+ * Needed when the host's view of our certificate changed, i.e. after pairing. The pool is shared, so other hosts
+ * lose their pooled connections as well.
+ */
+void http_pool_invalidate(const char *address, unsigned short port);
+
 HTTP_DATA * http_data_alloc();
 
 void http_data_free(HTTP_DATA * data);
@@ -17,12 +17,35 @@
  * along with Moonlight; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#pragma once
+
 #include <Limelight.h>
+#include <stddef.h>
 
 #define GS_SPS_BITSTREAM_FIXUP  0x01
 #define GS_SPS_REMOVE_VST_FIXUP 0x02
 #define GS_SPS_REMOVE_CLI_FIXUP 0x04
 
-void gs_sps_init(int width, int height);
-void gs_sps_fix(PLENTRY sps, int flags, uint8_t* out_buf, uint32_t* out_offset);
-void gs_sps_finalize();
\ No newline at end of file
+/**
+ * Upper bound of how much a rewritten SPS can grow.
+ */
+#define GS_SPS_MAX_GROWTH 64
+
+typedef struct GS_SPS_FIXER_T *GS_SPS_FIXER;
+
+/**
+ * Create an SPS rewriter for one stream. Each instance has its own parser state, so different sessions or threads
+ * don't interfere with each other.
+ *
+ * @param videoFormat Only H.264 streams can be rewritten for now. NULL is returned for other formats.
+ */
+GS_SPS_FIXER gs_sps_fixer_new(int videoFormat, int width, int height, int flags);
+
+/**
+ * Write the fixed SPS, including the start code, to out_buf.
+ *
+ * @return Number of bytes written, or 0 if the SPS couldn't be rewritten and should be passed as is
+ */
+size_t gs_sps_fix(GS_SPS_FIXER fixer, const LENTRY *sps, uint8_t *out_buf, size_t out_size);
+
+void gs_sps_fixer_free(GS_SPS_FIXER fixer);
\ No newline at end of file
@@ -28,6 +28,20 @@ typedef struct APP_LIST {
     struct APP_LIST *next;
 } APP_LIST, *PAPP_LIST;
 
+/**
+ * Apps parsed into a single allocation, with all titles interned in the same block.
+ * Release it with a single free().
+ */
+typedef struct APP_ARRAY {
+    size_t count;
+    /** Size of each item. Every item starts with an APP_LIST, remaining bytes are zeroed for the caller to use */
+    size_t item_size;
+    /** Items in document order. APP_LIST.next is always NULL */
+    void *items;
+} APP_ARRAY, *PAPP_ARRAY;
+
+#define APP_ARRAY_ITEM(array, index) ((PAPP_LIST) ((char *) (array)->items + (index) * (array)->item_size))
+
 typedef struct DISPLAY_MODE {
     unsigned int height;
     unsigned int width;
@@ -35,12 +49,55 @@ typedef struct DISPLAY_MODE {
     struct DISPLAY_MODE *next;
 } DISPLAY_MODE, *PDISPLAY_MODE;
 
+typedef enum SERVERINFO_FIELD {
+    SERVERINFO_UNIQUEID,
+    SERVERINFO_MAC,
+    SERVERINFO_HOSTNAME,
+    SERVERINFO_CURRENTGAME,
+    SERVERINFO_PAIRSTATUS,
+    SERVERINFO_APPVERSION,
+    SERVERINFO_STATE,
+    SERVERINFO_CODEC_MODE_SUPPORT,
+    SERVERINFO_GPUTYPE,
+    SERVERINFO_GSVERSION,
+    SERVERINFO_GFEVERSION,
+    SERVERINFO_HTTPSPORT,
+    SERVERINFO_EXTERNALPORT,
+    SERVERINFO_FIELD_COUNT,
+} SERVERINFO_FIELD;
+
+/**
+ * Everything needed from a serverinfo response, collected in one pass.
+ */
+typedef struct SERVERINFO_XML {
+    int status;
+    /** Text of each field, empty string if absent. Set a field to NULL to take ownership of it. */
+    char *fields[SERVERINFO_FIELD_COUNT];
+    PDISPLAY_MODE modes;
+} SERVERINFO_XML;
+
 int xml_search(char *data, size_t len, const char *node, char **result);
 
 int xml_search_ex(char *data, size_t len, const char *node, bool required, char **result);
 
-int xml_applist(char *data, size_t len, PAPP_LIST *app_list);
+/**
+ * Parse status and apps of an applist response.
+ * @param item_size Size of each item in the result array, at least sizeof(APP_LIST)
+ * @return GS_OK on success, GS_ERROR if the host returned a bad status, GS_INVALID if XML is malformed
+ */
+int xml_applist(char *data, size_t len, size_t item_size, PAPP_ARRAY *apps);
 
 int xml_modelist(char *data, size_t len, PDISPLAY_MODE *mode_list);
 
 int xml_status(char *data, size_t len);
+
+/**
+ * Parse status, fields and display modes of a serverinfo response with a single parser.
+ * @return GS_OK on success, GS_ERROR if the host returned a bad status, GS_INVALID if XML is malformed
+ */
+int xml_serverinfo(char *data, size_t len, SERVERINFO_XML *info);
+
+/**
+ * Free remaining fields. The mode list is not freed, as it's usually handed to SERVER_DATA.
+ */
+void xml_serverinfo_clear(SERVERINFO_XML *info);
@@ -56,8 +56,28 @@
 
 static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server);
 
+static int serverinfo_request_error(int attempt, int ret);
+
+static int parse_server_status(PSERVER_DATA server, const HTTP_DATA *data);
+
+static int check_server_version(const SERVER_DATA *server, int ret);
+
 static int resolve_ports(GS_CLIENT hnd, const char *address, uint16_t port, uint16_t *https_port);
 
+static int parse_https_port(const HTTP_DATA *data, uint16_t *https_port);
+
+static int parse_applist(const HTTP_DATA *data, size_t item_size, PAPP_ARRAY *apps);
+
+typedef struct status_async_t status_async_t;
+
+static int status_async_request(status_async_t *ctx);
+
+static void status_async_ports_cb(int result, HTTP_DATA *data, status_async_t *ctx);
+
+static void status_async_info_cb(int result, HTTP_DATA *data, status_async_t *ctx);
+
+static void status_async_finish(status_async_t *ctx, int result);
+
 static bool construct_url(GS_CLIENT, char *url, size_t ulen, bool secure, const char *address, uint16_t port,
                           const char *action, const char *fmt, ...);
 
@@ -67,6 +87,8 @@ static bool append_params_raw(char *url, size_t ulen, const char *params);
 
 static uint16_t server_port(const SERVER_DATA *server, bool secure);
 
+static void invalidate_connections(const SERVER_DATA *server);
+
 static void bytes_to_hex(const unsigned char *in, char *out, size_t len) {
     for (int i = 0; i < len; i++) {
         sprintf(out + i * 2, "%02x", in[i]);
@@ -103,7 +125,7 @@ int gs_unpair(GS_CLIENT hnd, PSERVER_DATA server) {
     }
 
     construct_url(hnd, url, sizeof(url), false, server->serverInfo.address, server_port(server, false), "unpair", NULL);
-    ret = http_request(hnd->http, url, data);
+    ret = http_request(hnd->http, url, data, false);
     if (ret != GS_OK) {
         goto cleanup;
     }
@@ -115,6 +137,7 @@ int gs_unpair(GS_CLIENT hnd, PSERVER_DATA server) {
 
     ret = GS_OK;
     server->paired = false;
+    invalidate_connections(server);
 
     cleanup:
     http_data_free(data);
@@ -196,10 +219,10 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
     // Send the salt and get the server cert. This doesn't have a read timeout
     // because the user must enter the PIN before the server responds
     construct_url(hnd, url, sizeof(url), false, server->serverInfo.address, server_port(server, false), "pair",
-                  "devicename=roth&updateState=1&phrase=getservercert&salt=%s&clientcert=%s", salt_hex, hnd->cert_hex);
+                  "devicename=roth&updateState=1&phrase=getservercert&salt=%s&clientcert=%s", salt_hex, hnd->creds->cert_hex);
     data = http_data_alloc();
 
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         gs_set_error(ret, "Failed to request pairing. Check connection.");
         goto cleanup;
     }
@@ -264,7 +287,7 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
     // Send the encrypted challenge to the server
     construct_url(hnd, url, sizeof(url), false, server->serverInfo.address, server_port(server, false), "pair",
                   "devicename=roth&updateState=1&clientchallenge=%s", encrypted_challenge_hex);
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         goto cleanup;
     }
 
@@ -307,9 +330,9 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
            sizeof(challenge_response.challenge));
 
 #if MBEDTLS_VERSION_NUMBER >= 0x03020100
-    memcpy(challenge_response.signature, hnd->cert.private_sig.p, sizeof(challenge_response.signature));
+    memcpy(challenge_response.signature, hnd->creds->cert.private_sig.p, sizeof(challenge_response.signature));
 #else
-    memcpy(challenge_response.signature, hnd->cert.sig.p, sizeof(challenge_response.signature));
+    memcpy(challenge_response.signature, hnd->creds->cert.sig.p, sizeof(challenge_response.signature));
 #endif
     memcpy(challenge_response.secret, client_secret, sizeof(challenge_response.secret));
 
@@ -326,7 +349,7 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
 
     construct_url(hnd, url, sizeof(url), false, server->serverInfo.address, server_port(server, false), "pair",
                   "devicename=rothupdateState=1&serverchallengeresp=%s", challenge_response_hex);
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         goto cleanup;
     }
 
@@ -385,8 +408,11 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
     struct pairing_secret_t client_pairing_secret;
     memcpy(client_pairing_secret.secret, client_secret, 16);
     size_t s_len = sizeof(client_pairing_secret.signature);
-    if (!generateSignature(client_pairing_secret.secret, 16, client_pairing_secret.signature, &s_len,
-                           (struct mbedtls_pk_context *) &hnd->pk, &ctr_drbg)) {
+    pthread_mutex_lock(&hnd->creds->sign_lock);
+    bool signed_ok = generateSignature(client_pairing_secret.secret, 16, client_pairing_secret.signature, &s_len,
+                                       &hnd->creds->pk, &ctr_drbg);
+    pthread_mutex_unlock(&hnd->creds->sign_lock);
+    if (!signed_ok) {
         ret = gs_set_error(GS_FAILED, "Failed to sign data");
         goto cleanup;
     }
@@ -396,7 +422,7 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
 
     construct_url(hnd, url, sizeof(url), false, server->serverInfo.address, server_port(server, false), "pair",
                   "devicename=roth&updateState=1&clientpairingsecret=%s", client_pairing_secret_hex);
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         goto cleanup;
     }
 
@@ -414,10 +440,13 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
         goto cleanup;
     }
 
+    // Pooled HTTPS connections were authenticated before we got paired
+    invalidate_connections(server);
+
     // Do the initial challenge (seems neccessary for us to show as paired)
     construct_url(hnd, url, sizeof(url), true, server->serverInfo.address, server_port(server, true), "pair",
                   "devicename=roth&updateState=1&phrase=pairchallenge");
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         goto cleanup;
     }
 
@@ -459,7 +488,7 @@ int gs_pair(GS_CLIENT hnd, PSERVER_DATA server, const char *pin) {
     return ret;
 }
 
-int gs_applist(GS_CLIENT hnd, const SERVER_DATA *server, PAPP_LIST *list) {
+int gs_applist(GS_CLIENT hnd, const SERVER_DATA *server, size_t item_size, PAPP_ARRAY *apps) {
     int ret = GS_OK;
     char url[4096];
     HTTP_DATA *data = http_data_alloc();
@@ -468,18 +497,24 @@ int gs_applist(GS_CLIENT hnd, const SERVER_DATA *server, PAPP_LIST *list) {
     }
 
     construct_url(hnd, url, sizeof(url), true, server->serverInfo.address, server_port(server, true), "applist", NULL);
-    if (http_request(hnd->http, url, data) != GS_OK) {
+    if (http_request(hnd->http, url, data, true) != GS_OK) {
         ret = gs_set_error(GS_IO_ERROR, "Failed to get apps list");
-    } else if (xml_status(data->memory, data->size) == GS_ERROR) {
-        ret = GS_ERROR;
-    } else if (xml_applist(data->memory, data->size, list) != GS_OK) {
-        ret = GS_INVALID;
+    } else {
+        ret = parse_applist(data, item_size, apps);
     }
 
     http_data_free(data);
     return ret;
 }
 
+static int parse_applist(const HTTP_DATA *data, size_t item_size, PAPP_ARRAY *apps) {
+    int ret = xml_applist(data->memory, data->size, item_size, apps);
+    if (ret == GS_OK || ret == GS_ERROR || ret == GS_OUT_OF_MEMORY) {
+        return ret;
+    }
+    return GS_INVALID;
+}
+
 int gs_start_app(GS_CLIENT hnd, PSERVER_DATA server, STREAM_CONFIGURATION *config, int appId, bool is_gfe, bool sops,
                  bool localaudio, int gamepad_mask, const char* surround_params) {
     int ret = GS_OK;
@@ -572,7 +607,7 @@ int gs_start_app(GS_CLIENT hnd, PSERVER_DATA server, STREAM_CONFIGURATION *confi
         append_params_raw(url, sizeof(url), LiGetLaunchUrlQueryParameters());
     }
 
-    if ((ret = http_request(hnd->http, url, data)) == GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) == GS_OK) {
         server->currentGame = appId;
     } else {
         goto cleanup;
@@ -619,7 +654,7 @@ int gs_quit_app(GS_CLIENT hnd, PSERVER_DATA server) {
     }
 
     construct_url(hnd, url, sizeof(url), true, server->serverInfo.address, server_port(server, true), "cancel", NULL);
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, false)) != GS_OK) {
         goto cleanup;
     }
 
@@ -658,7 +693,7 @@ int gs_download_cover(GS_CLIENT hnd, const SERVER_DATA *server, int appid, const
 
     construct_url(hnd, url, sizeof(url), true, server->serverInfo.address, server_port(server, true), "appasset",
                   "appid=%d&AssetType=2&AssetIdx=0", appid);
-    ret = http_request(hnd->http, url, data);
+    ret = http_request(hnd->http, url, data, true);
     if (ret != GS_OK) {
         goto cleanup;
     }
@@ -678,16 +713,99 @@ int gs_download_cover(GS_CLIENT hnd, const SERVER_DATA *server, int appid, const
     return ret;
 }
 
+typedef struct status_async_t {
+    GS_CLIENT hnd;
+    PSERVER_DATA server;
+    int attempt;
+    gs_status_cb cb;
+    void *userdata;
+} status_async_t;
+
+int gs_get_status_async(GS_CLIENT hnd, PSERVER_DATA server, const char *address, uint16_t port, bool unsupported,
+                        gs_status_cb cb, void *userdata) {
+    LiInitializeServerInformation(&server->serverInfo);
+    server->serverInfo.address = address;
+    server->extPort = port;
+    server->unsupported = unsupported;
+
+    status_async_t *ctx = calloc(1, sizeof(status_async_t));
+    if (ctx == NULL) {
+        return gs_set_error(GS_OUT_OF_MEMORY, "Out of memory");
+    }
+    ctx->hnd = hnd;
+    ctx->server = server;
+    ctx->cb = cb;
+    ctx->userdata = userdata;
+
+    int ret;
+    if (server->extPort != 0 && server->httpsPort == 0) {
+        char url[4096];
+        construct_url(hnd, url, sizeof(url), false, address, port, "serverinfo", NULL);
+        ret = http_request_async(hnd->http, url, true, (http_async_cb) status_async_ports_cb, ctx);
+    } else {
+        ret = status_async_request(ctx);
+    }
+    if (ret != GS_OK) {
+        free(ctx);
+    }
+    return ret;
+}
+
+void gs_async_shutdown() {
+    http_async_shutdown();
+}
+
+static void status_async_ports_cb(int result, HTTP_DATA *data, status_async_t *ctx) {
+    if (result == GS_OK) {
+        result = parse_https_port(data, &ctx->server->httpsPort);
+    }
+    if (result == GS_OK) {
+        result = status_async_request(ctx);
+    }
+    if (result != GS_OK) {
+        status_async_finish(ctx, result);
+    }
+}
+
+static int status_async_request(status_async_t *ctx) {
+    PSERVER_DATA server = ctx->server;
+    // See load_server_status for why the request is made twice
+    bool secure = ctx->attempt == 0;
+    char url[4096];
+    construct_url(ctx->hnd, url, sizeof(url), secure, server->serverInfo.address, server_port(server, secure),
+                  "serverinfo", NULL);
+    return http_request_async(ctx->hnd->http, url, true, (http_async_cb) status_async_info_cb, ctx);
+}
+
+static void status_async_info_cb(int result, HTTP_DATA *data, status_async_t *ctx) {
+    if (result != GS_OK) {
+        result = serverinfo_request_error(ctx->attempt, result);
+    } else {
+        result = parse_server_status(ctx->server, data);
+    }
+    ctx->attempt++;
+    if (result == GS_ERROR && ctx->attempt < 2 && status_async_request(ctx) == GS_OK) {
+        return;
+    }
+    status_async_finish(ctx, check_server_version(ctx->server, result));
+}
+
+static void status_async_finish(status_async_t *ctx, int result) {
+    ctx->cb(result, ctx->server, ctx->userdata);
+    free(ctx);
+}
+
 GS_CLIENT gs_new(const char *keydir) {
     struct GS_CLIENT_T *hnd = malloc(sizeof(struct GS_CLIENT_T));
     memset(hnd, 0, sizeof(struct GS_CLIENT_T));
-    if (gs_conf_load(hnd, keydir) != GS_OK) {
+    if (gs_conf_load(keydir, &hnd->creds) != GS_OK) {
         free(hnd);
         return NULL;
     }
 
     HTTP *http = http_create(keydir);
     if (http == NULL) {
+        gs_conf_unref(hnd->creds);
         free(hnd);
         return NULL;
     }
@@ -697,8 +815,7 @@ GS_CLIENT gs_new(const char *keydir) {
 }
 
 void gs_destroy(GS_CLIENT hnd) {
-    mbedtls_pk_free(&hnd->pk);
-    mbedtls_x509_crt_free(&hnd->cert);
+    gs_conf_unref(hnd->creds);
     http_destroy(hnd->http);
     free((void *) hnd);
 }
@@ -707,6 +824,10 @@ void gs_set_timeout(GS_CLIENT hnd, int timeout_secs) {
     http_set_timeout(hnd->http, timeout_secs);
 }
 
+void gs_set_cancel_token(GS_CLIENT hnd, gs_cancel_token_fn token, void *userdata) {
+    http_set_cancel(hnd->http, token, userdata);
+}
+
 int gs_get_status(GS_CLIENT hnd, PSERVER_DATA server, const char *address, uint16_t port, bool unsupported) {
     LiInitializeServerInformation(&server->serverInfo);
     server->serverInfo.address = address;
@@ -727,15 +848,6 @@ static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server) {
     char url[4096];
     int i = 0;
     do {
-        char *pairedText = NULL;
-        char *currentGameText = NULL;
-        char *stateText = NULL;
-        char *serverCodecModeSupportText = NULL;
-        char *httpsPortText = NULL;
-        char *externalPortText = NULL;
-
-        ret = GS_INVALID;
-
         // Modern GFE versions don't allow serverinfo to be fetched over HTTPS if the client
         // is not already paired. Since we can't pair without knowing the server version, we
         // make another request over HTTP if the HTTPS request fails. We can't just use HTTP
@@ -747,131 +859,103 @@ static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server) {
         HTTP_DATA *data = http_data_alloc();
         if (data == NULL) {
             ret = GS_OUT_OF_MEMORY;
-            goto cleanup;
+            break;
         }
-        if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
-            if (i == 0 && ret == GS_FAILED) {
-                ret = GS_ERROR;
-            } else {
-                ret = GS_IO_ERROR;
-            }
-            goto cleanup;
-        }
-
-        if (xml_status(data->memory, data->size) == GS_ERROR) {
-            ret = GS_ERROR;
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "uniqueid", (char **) &server->uuid) != GS_OK) {
-            goto cleanup;
-        }
-        if (xml_search(data->memory, data->size, "mac", (char **) &server->mac) != GS_OK) {
-            goto cleanup;
-        }
-        if (xml_search(data->memory, data->size, "hostname", (char **) &server->hostname) != GS_OK) {
-            server->hostname = strdup(server->serverInfo.address);
-        }
-
-        if (xml_search(data->memory, data->size, "currentgame", &currentGameText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "PairStatus", &pairedText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "appversion", (char **) &server->serverInfo.serverInfoAppVersion) !=
-            GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "state", &stateText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "ServerCodecModeSupport", &serverCodecModeSupportText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "gputype", (char **) &server->gpuType) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "GsVersion", (char **) &server->gsVersion) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "GfeVersion", (char **) &server->serverInfo.serverInfoGfeVersion) !=
-            GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "HttpsPort", &httpsPortText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_search(data->memory, data->size, "ExternalPort", &externalPortText) != GS_OK) {
-            goto cleanup;
-        }
-
-        if (xml_modelist(data->memory, data->size, &server->modes) != GS_OK) {
-            goto cleanup;
-        }
-
-        // These fields are present on all version of GFE that this client supports
-        if (!strlen(currentGameText) || !strlen(pairedText) || !strlen(server->serverInfo.serverInfoAppVersion) ||
-            !strlen(stateText)) {
-            goto cleanup;
+        if ((ret = http_request(hnd->http, url, data, true)) != GS_OK) {
+            ret = serverinfo_request_error(i, ret);
+        } else {
+            ret = parse_server_status(server, data);
         }
+        http_data_free(data);
+        i++;
+    } while (ret == GS_ERROR && i < 2);
 
-        int serverCodecModeSupport = serverCodecModeSupportText == NULL ? 0 :
-                                     (int) strtol(serverCodecModeSupportText, NULL, 0);
-
-        server->paired = pairedText != NULL && strcmp(pairedText, "1") == 0;
-        server->currentGame = currentGameText == NULL ? 0 : (int) strtol(currentGameText, NULL, 0);
-        server->supports4K = serverCodecModeSupport != 0;
-        server->supportsHdr = serverCodecModeSupport & 0x200;
-        server->serverMajorVersion = (int) strtol(server->serverInfo.serverInfoAppVersion, NULL, 0);
-        // Real Nvidia host software (GeForce Experience and RTX Experience) both use the 'Mjolnir'
-        // codename in the state field and no version of Sunshine does. We can use this to bypass
-        // some assumptions about Nvidia hardware that don't apply to Sunshine hosts.
-        server->isGfe = strstr(stateText, "MJOLNIR") != NULL;
-        server->httpsPort = httpsPortText == NULL ? 0 : (int) strtol(httpsPortText, NULL, 0);
-        server->extPort = externalPortText == NULL ? 0 : (int) strtol(externalPortText, NULL, 0);
-
-        if (strstr(stateText, "_SERVER_BUSY") == NULL) {
-            // After GFE 2.8, current game remains set even after streaming
-            // has ended. We emulate the old behavior by forcing it to zero
-            // if streaming is not active.
-            server->currentGame = 0;
-        }
-        ret = GS_OK;
+    return check_server_version(server, ret);
+}
 
-        cleanup:
-        if (data != NULL) {
-            http_data_free(data);
-        }
+static int serverinfo_request_error(int attempt, int ret) {
+    if (ret == GS_CANCELLED) {
+        return ret;
+    }
+    if (attempt == 0 && ret == GS_FAILED) {
+        return GS_ERROR;
+    }
+    return GS_IO_ERROR;
+}
 
-        if (pairedText != NULL) {
-            free(pairedText);
-        }
+static int parse_server_status(PSERVER_DATA server, const HTTP_DATA *data) {
+    SERVERINFO_XML info;
+    int ret = xml_serverinfo(data->memory, data->size, &info);
+    if (ret != GS_OK) {
+        return ret;
+    }
 
-        if (currentGameText != NULL) {
-            free(currentGameText);
-        }
+    const char *pairedText = info.fields[SERVERINFO_PAIRSTATUS];
+    const char *currentGameText = info.fields[SERVERINFO_CURRENTGAME];
+    const char *stateText = info.fields[SERVERINFO_STATE];
 
-        if (stateText != NULL) {
-            free(stateText);
-        }
+    // These fields are present on all version of GFE that this client supports
+    if (!strlen(currentGameText) || !strlen(pairedText) || !strlen(info.fields[SERVERINFO_APPVERSION]) ||
+        !strlen(stateText)) {
+        ret = GS_INVALID;
+        goto cleanup;
+    }
 
-        if (serverCodecModeSupportText != NULL) {
-            free(serverCodecModeSupportText);
-        }
+    // Strings are moved into server data, the rest is freed with info
+    server->uuid = info.fields[SERVERINFO_UNIQUEID];
+    info.fields[SERVERINFO_UNIQUEID] = NULL;
+    server->mac = info.fields[SERVERINFO_MAC];
+    info.fields[SERVERINFO_MAC] = NULL;
+    if (strlen(info.fields[SERVERINFO_HOSTNAME])) {
+        server->hostname = info.fields[SERVERINFO_HOSTNAME];
+        info.fields[SERVERINFO_HOSTNAME] = NULL;
+    } else {
+        server->hostname = strdup(server->serverInfo.address);
+    }
+    server->serverInfo.serverInfoAppVersion = info.fields[SERVERINFO_APPVERSION];
+    info.fields[SERVERINFO_APPVERSION] = NULL;
+    server->gpuType = info.fields[SERVERINFO_GPUTYPE];
+    info.fields[SERVERINFO_GPUTYPE] = NULL;
+    server->gsVersion = info.fields[SERVERINFO_GSVERSION];
+    info.fields[SERVERINFO_GSVERSION] = NULL;
+    server->serverInfo.serverInfoGfeVersion = info.fields[SERVERINFO_GFEVERSION];
+    info.fields[SERVERINFO_GFEVERSION] = NULL;
+    server->modes = info.modes;
+
+    int serverCodecModeSupport = (int) strtol(info.fields[SERVERINFO_CODEC_MODE_SUPPORT], NULL, 0);
+
+    server->paired = strcmp(pairedText, "1") == 0;
+    server->currentGame = (int) strtol(currentGameText, NULL, 0);
+    server->supports4K = serverCodecModeSupport != 0;
+    server->supportsHdr = serverCodecModeSupport & 0x200;
+    server->serverMajorVersion = (int) strtol(server->serverInfo.serverInfoAppVersion, NULL, 0);
+    // Real Nvidia host software (GeForce Experience and RTX Experience) both use the 'Mjolnir'
+    // codename in the state field and no version of Sunshine does. We can use this to bypass
+    // some assumptions about Nvidia hardware that don't apply to Sunshine hosts.
+    server->isGfe = strstr(stateText, "MJOLNIR") != NULL;
+    server->httpsPort = (int) strtol(info.fields[SERVERINFO_HTTPSPORT], NULL, 0);
+    server->extPort = (int) strtol(info.fields[SERVERINFO_EXTERNALPORT], NULL, 0);
+
+    if (strstr(stateText, "_SERVER_BUSY") == NULL) {
+        // After GFE 2.8, current game remains set even after streaming
+        // has ended. We emulate the old behavior by forcing it to zero
+        // if streaming is not active.
+        server->currentGame = 0;
+    }
+    xml_serverinfo_clear(&info);
+    return GS_OK;
 
-        i++;
-    } while (ret == GS_ERROR && i < 2);
+    cleanup:
+    xml_serverinfo_clear(&info);
+    while (info.modes != NULL) {
+        PDISPLAY_MODE next = info.modes->next;
+        free(info.modes);
+        info.modes = next;
+    }
+    return ret;
+}
 
+static int check_server_version(const SERVER_DATA *server, int ret) {
     if (ret == GS_OK && !server->unsupported) {
         if (server->serverMajorVersion > MAX_SUPPORTED_GFE_VERSION) {
             ret = gs_set_error(GS_UNSUPPORTED_VERSION, "Ensure you're running the latest version of Moonlight "
@@ -881,7 +965,6 @@ static int load_server_status(GS_CLIENT hnd, PSERVER_DATA server) {
                                                        "Please upgrade GFE on your PC and try again.");
         }
     }
-
     return ret;
 }
 
@@ -894,26 +977,30 @@ static int resolve_ports(GS_CLIENT hnd, const char *address, uint16_t port, uint
     }
 
     construct_url(hnd, url, sizeof(url), false, address, port, "serverinfo", NULL);
-    if ((ret = http_request(hnd->http, url, data)) != GS_OK) {
+    if ((ret = http_request(hnd->http, url, data, true)) != GS_OK) {
         goto cleanup;
     }
 
+    ret = parse_https_port(data, https_port);
+
+    cleanup:
+    http_data_free(data);
+    return ret;
+}
+
+static int parse_https_port(const HTTP_DATA *data, uint16_t *https_port) {
     if (xml_status(data->memory, data->size) == GS_ERROR) {
-        ret = GS_ERROR;
-        goto cleanup;
+        return GS_ERROR;
     }
 
     char *httpsPortText = NULL;
     if (xml_search(data->memory, data->size, "HttpsPort", &httpsPortText) != GS_OK) {
-        ret = GS_INVALID;
-        goto cleanup;
+        return GS_INVALID;
     }
 
     *https_port = (uint16_t) strtol(httpsPortText, NULL, 0);
-
-    cleanup:
-    http_data_free(data);
-    return ret;
+    free(httpsPortText);
+    return GS_OK;
 }
 
 static bool construct_url(GS_CLIENT hnd, char *url, size_t ulen, bool secure, const char *address, uint16_t port,
@@ -933,7 +1020,7 @@ static bool construct_url(GS_CLIENT hnd, char *url, size_t ulen, bool secure, co
     } else {
         w_len += snprintf(url + w_len, ulen - w_len, "%s", address);
     }
-    w_len += snprintf(url + w_len, ulen - w_len, ":%u/%s?uniqueid=%s&uuid=%.*s", port, action, hnd->unique_id, 36,
+    w_len += snprintf(url + w_len, ulen - w_len, ":%u/%s?uniqueid=%s&uuid=%.*s", port, action, hnd->creds->unique_id, 36,
                       uuid.data);
     if (fmt) {
         char params[4096];
@@ -987,3 +1074,8 @@ static bool append_params_raw(char *url, size_t ulen, const char *params) {
 static uint16_t server_port(const SERVER_DATA *server, bool secure) {
     return secure ? server->httpsPort : server->extPort;
 }
+
+static void invalidate_connections(const SERVER_DATA *server) {
+    uint16_t port = server_port(server, true);
+    http_pool_invalidate(server->serverInfo.address, port != 0 ? port : 47984);
+}
@@ -10,6 +10,8 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 #include <mbedtls/version.h>
 #include <mbedtls/pk.h>
@@ -39,28 +41,94 @@ static int mbed_parse_key(mbedtls_pk_context *ctx, const char *path);
 
 static int mkdirtree(const char *directory);
 
-static int load_unique_id(struct GS_CLIENT_T *hnd, const char *keydir);
+static int load_unique_id(GS_CREDENTIALS *creds, const char *keydir);
 
 static int init_unique_id(const char *keydir);
 
-static int load_cert(struct GS_CLIENT_T *hnd, const char *keydir);
+static int load_cert(GS_CREDENTIALS *creds, const char *keydir);
+
+static int load_cert_hex(GS_CREDENTIALS *creds, const char *cert_path);
 
 static int init_cert(const char *keydir);
 
-int gs_conf_load(GS_CLIENT hnd, const char *keydir) {
+static void credentials_free(GS_CREDENTIALS *creds);
+
+static void credentials_invalidate(void);
+
+static pthread_mutex_t credentials_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Credentials of the most recently used key directory. Holds a reference.
+ */
+static GS_CREDENTIALS *credentials_cached = NULL;
+
+int gs_conf_load(const char *keydir, GS_CREDENTIALS **creds) {
     int ret = GS_OK;
-    if ((ret = load_unique_id(hnd, keydir)) != GS_OK) {
-        return ret;
+    pthread_mutex_lock(&credentials_lock);
+    if (credentials_cached != NULL && strncmp(credentials_cached->keydir, keydir, PATH_MAX) == 0) {
+        credentials_cached->refcount++;
+        *creds = credentials_cached;
+        goto unlock;
     }
 
-    if ((ret = load_cert(hnd, keydir)) != GS_OK) {
-        return ret;
+    GS_CREDENTIALS *loaded = calloc(1, sizeof(GS_CREDENTIALS));
+    if (loaded == NULL) {
+        ret = gs_set_error(GS_OUT_OF_MEMORY, "Out of memory");
+        goto unlock;
+    }
+    strncpy(loaded->keydir, keydir, PATH_MAX - 1);
+    if ((ret = load_unique_id(loaded, keydir)) != GS_OK) {
+        free(loaded);
+        goto unlock;
+    }
+    if ((ret = load_cert(loaded, keydir)) != GS_OK) {
+        free(loaded);
+        goto unlock;
     }
+    pthread_mutex_init(&loaded->sign_lock, NULL);
+    commons_log_debug("GameStream", "Loaded credentials from %s", keydir);
+
+    // One reference for the cache, one for the caller
+    loaded->refcount = 2;
+    if (credentials_cached != NULL && --credentials_cached->refcount == 0) {
+        credentials_free(credentials_cached);
+    }
+    credentials_cached = loaded;
+    *creds = loaded;
+
+    unlock:
+    pthread_mutex_unlock(&credentials_lock);
     return ret;
 }
 
+void gs_conf_unref(GS_CREDENTIALS *creds) {
+    pthread_mutex_lock(&credentials_lock);
+    if (--creds->refcount == 0) {
+        credentials_free(creds);
+    }
+    pthread_mutex_unlock(&credentials_lock);
+}
+
+static void credentials_free(GS_CREDENTIALS *creds) {
+    mbedtls_pk_free(&creds->pk);
+    mbedtls_x509_crt_free(&creds->cert);
+    pthread_mutex_destroy(&creds->sign_lock);
+    free(creds);
+}
+
+static void credentials_invalidate(void) {
+    pthread_mutex_lock(&credentials_lock);
+    if (credentials_cached != NULL && --credentials_cached->refcount == 0) {
+        credentials_free(credentials_cached);
+    }
+    credentials_cached = NULL;
+    pthread_mutex_unlock(&credentials_lock);
+}
+
 int gs_conf_init(const char *keydir) {
     commons_log_info("GameStream", "Initializing configuration");
+    // Files are about to be regenerated, clients created after this should not use the old ones
+    credentials_invalidate();
     if (mkdirtree(keydir) != 0) {
         return gs_set_error(GS_IO_ERROR, "Failed to create config directory %s: %s", keydir, strerror(errno));
     }
@@ -87,7 +155,7 @@ int mbed_parse_key(mbedtls_pk_context *ctx, const char *path) {
 #endif
 }
 
-int load_unique_id(struct GS_CLIENT_T *hnd, const char *keydir) {
+int load_unique_id(GS_CREDENTIALS *creds, const char *keydir) {
     char id_path[PATH_MAX];
     snprintf(id_path, PATH_MAX, "%s%c%s", keydir, PATH_SEPARATOR, UNIQUE_FILE_NAME);
 
@@ -95,12 +163,12 @@ int load_unique_id(struct GS_CLIENT_T *hnd, const char *keydir) {
     if (fd == NULL) {
         return gs_set_error(GS_BAD_CONF, "Failed to open unique ID file %s: %s", id_path, strerror(errno));
     }
-    if (fread(hnd->unique_id, 1, UNIQUEID_CHARS, fd) != UNIQUEID_CHARS) {
+    if (fread(creds->unique_id, 1, UNIQUEID_CHARS, fd) != UNIQUEID_CHARS) {
         fclose(fd);
         return gs_set_error(GS_BAD_CONF, "Bad unique ID file");
     }
     fclose(fd);
-    hnd->unique_id[UNIQUEID_CHARS] = 0;
+    creds->unique_id[UNIQUEID_CHARS] = 0;
     return GS_OK;
 }
 
@@ -121,7 +189,7 @@ int init_unique_id(const char *keydir) {
     return GS_OK;
 }
 
-int load_cert(struct GS_CLIENT_T *hnd, const char *keydir) {
+int load_cert(GS_CREDENTIALS *creds, const char *keydir) {
     char cert_path[PATH_MAX];
     snprintf(cert_path, PATH_MAX, "%s%c%s", keydir, PATH_SEPARATOR, CERTIFICATE_FILE_NAME);
 
@@ -129,40 +197,52 @@ int load_cert(struct GS_CLIENT_T *hnd, const char *keydir) {
     snprintf(key_path, PATH_MAX, "%s%c%s", keydir, PATH_SEPARATOR, KEY_FILE_NAME);
 
     int ret;
-    mbedtls_x509_crt_init(&hnd->cert);
-    if ((ret = mbedtls_x509_crt_parse_file(&hnd->cert, cert_path)) != 0) {
+    mbedtls_x509_crt_init(&creds->cert);
+    if ((ret = mbedtls_x509_crt_parse_file(&creds->cert, cert_path)) != 0) {
         char buf[512];
         mbedtls_strerror(ret, buf, 512);
-        mbedtls_x509_crt_free(&hnd->cert);
+        mbedtls_x509_crt_free(&creds->cert);
         return gs_set_error(GS_FAILED, "Failed to parse certificate: %s", buf);
     }
-    FILE *f = fopen(cert_path, "r");
-    if (f == NULL) {
-        mbedtls_x509_crt_free(&hnd->cert);
-        return gs_set_error(GS_IO_ERROR, "Failed to open certFile %s for reading", cert_path);
-    }
-    int c;
-    int length = 0;
-    while ((c = fgetc(f)) != EOF) {
-        sprintf(&hnd->cert_hex[length], "%02x", c);
-        length += 2;
+    if ((ret = load_cert_hex(creds, cert_path)) != GS_OK) {
+        mbedtls_x509_crt_free(&creds->cert);
+        return ret;
     }
-    hnd->cert_hex[length] = 0;
-
-    fclose(f);
 
-    mbedtls_pk_init(&hnd->pk);
-    if ((ret = mbed_parse_key(&hnd->pk, key_path)) != 0) {
+    mbedtls_pk_init(&creds->pk);
+    if ((ret = mbed_parse_key(&creds->pk, key_path)) != 0) {
         char buf[512];
         mbedtls_strerror(ret, buf, 512);
-        mbedtls_x509_crt_free(&hnd->cert);
-        mbedtls_pk_free(&hnd->pk);
+        mbedtls_x509_crt_free(&creds->cert);
+        mbedtls_pk_free(&creds->pk);
         return gs_set_error(GS_FAILED, "Error loading key into memory: %s", buf);
     }
 
     return GS_OK;
 }
 
+int load_cert_hex(GS_CREDENTIALS *creds, const char *cert_path) {
+    static const char hex_digits[] = "0123456789abcdef";
+    FILE *f = fopen(cert_path, "rb");
+    if (f == NULL) {
+        return gs_set_error(GS_IO_ERROR, "Failed to open certFile %s for reading", cert_path);
+    }
+    unsigned char raw[(sizeof(creds->cert_hex) - 1) / 2];
+    size_t length = fread(raw, 1, sizeof(raw), f);
+    bool too_large = length == sizeof(raw) && fgetc(f) != EOF;
+    fclose(f);
+    if (too_large) {
+        return gs_set_error(GS_FAILED, "Certificate %s is too large", cert_path);
+    }
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = raw[i];
+        creds->cert_hex[i * 2] = hex_digits[c >> 4];
+        creds->cert_hex[i * 2 + 1] = hex_digits[c & 0xf];
+    }
+    creds->cert_hex[length * 2] = 0;
+    return GS_OK;
+}
+
 static int init_cert(const char *keydir) {
     commons_log_info("GameStream", "Generating device cert/key pair");
     char cert_path[PATH_MAX];
@@ -1,7 +1,14 @@
 #pragma once
 
 #include "client.h"
+#include "priv.h"
 
-int gs_conf_load(GS_CLIENT hnd, const char *keydir);
+/**
+ * Obtain credentials of the key directory, loading them only if they haven't been loaded yet.
+ * @param creds Reference to the shared credentials, release it with gs_conf_unref
+ */
+int gs_conf_load(const char *keydir, GS_CREDENTIALS **creds);
+
+void gs_conf_unref(GS_CREDENTIALS *creds);
 
 int gs_conf_init(const char *keydir);
@@ -26,7 +26,10 @@
 #include <curl/curl.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
 #include <assert.h>
+#include <unistd.h>
 
 #ifdef __WIN32
 #define PATH_SEPARATOR '\\'
@@ -34,11 +37,123 @@
 #define PATH_SEPARATOR '/'
 #endif
 
+#define HTTP_AUTHORITY_MAX 128
+/** How long a cancellable request may wait for socket activity before checking the cancel callback again */
+#define HTTP_CANCEL_POLL_MS 10
+
 struct HTTP_T {
     CURL *curl;
     pthread_mutex_t mutex;
+    http_cancel_fn cancel_fn;
+    void *cancel_data;
+    /** Drives cancellable requests, as curl_easy_perform only reports progress once a second when idle */
+    CURLM *multi;
 };
 
+/**
+ * Per-host (address:port) state of the shared connection pool.
+ */
+typedef struct http_pool_host_t {
+    char authority[HTTP_AUTHORITY_MAX];
+    /** Reused connections to this host failed before, always use a fresh one */
+    bool reuse_broken;
+    struct http_pool_host_t *next;
+} http_pool_host_t;
+
+/**
+ * Shared connection and TLS session cache. Replaced as a whole on invalidation, and the old one is released once
+ * the last request still using it finishes.
+ */
+typedef struct http_pool_share_t {
+    CURLSH *share;
+    /** Requests attached to this share, guarded by hosts_lock */
+    int refs;
+    bool retired;
+} http_pool_share_t;
+
+typedef struct http_pool_t {
+    http_pool_share_t *share;
+    pthread_mutex_t locks[CURL_LOCK_DATA_LAST];
+    /** Guards hosts and the share reference counts */
+    pthread_mutex_t hosts_lock;
+    http_pool_host_t *hosts;
+} http_pool_t;
+
+static http_pool_t pool;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void pool_init();
+
+static void pool_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+
+static void pool_unlock(CURL *handle, curl_lock_data data, void *userptr);
+
+static http_pool_host_t *pool_host_obtain(const char *authority);
+
+static void url_authority(const char *url, char *authority, size_t len);
+
+static http_pool_share_t *pool_share_create();
+
+static http_pool_share_t *pool_share_attach(CURL *curl);
+
+static void pool_share_detach(CURL *curl, http_pool_share_t *share);
+
+static void pool_host_policy(http_pool_host_t *host, bool idempotent, bool *fresh, bool *no_reuse);
+
+static void pool_host_mark_broken(http_pool_host_t *host);
+
+static bool should_retry_fresh(CURL *curl, CURLcode res, bool idempotent, bool fresh, bool no_reuse);
+
+static void prepare_request(CURL *curl, HTTP_DATA *data, bool fresh, bool no_reuse);
+
+static int request_result(CURL *curl, CURLcode res, HTTP_DATA *data);
+
+static CURLcode perform(HTTP *http);
+
+static int progress_fn(void *userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
+typedef struct http_async_req_t {
+    CURL *curl;
+    HTTP_DATA *data;
+    http_async_cb cb;
+    void *userdata;
+    char authority[HTTP_AUTHORITY_MAX];
+    http_pool_host_t *host;
+    http_pool_share_t *share;
+    bool idempotent, fresh, no_reuse, retried;
+    struct http_async_req_t *next;
+} http_async_req_t;
+
+/**
+ * Single event loop thread driving all asynchronous requests with curl multi.
+ */
+typedef struct http_engine_t {
+    CURLM *multi;
+    pthread_t thread;
+    /** Guards pending, started and stopping */
+    pthread_mutex_t lock;
+    /** Requests submitted but not yet added to the multi handle */
+    http_async_req_t *pending;
+    /** Requests added to the multi handle, only touched by the engine thread */
+    http_async_req_t *active;
+    bool started, stopping;
+} http_engine_t;
+
+static http_engine_t engine = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+
+static void engine_init();
+
+static void *engine_loop(void *arg);
+
+static void engine_wakeup();
+
+static void engine_add(http_async_req_t *req);
+
+static void engine_remove(http_async_req_t *req);
+
+static void engine_complete(http_async_req_t *req, CURLcode res);
+
 static size_t write_fn(void *contents, size_t size, size_t nmemb, void *userp) {
     size_t realsize = size * nmemb;
     HTTP_DATA *mem = (HTTP_DATA *) userp;
@@ -75,18 +190,27 @@ HTTP *http_create(const char *keydir) {
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_fn);
     curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, 0L);
-    // Fix for https://github.com/mariotaku/moonlight-tv/issues/452
-    curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+
+    // Connections and TLS sessions are kept in a process-wide pool, so handles created for every request
+    // can still skip the TCP connect and full client-cert handshake. Handles attach to it per request.
+    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x074100
+    // Hosts drop idle connections silently, don't bother reusing old ones
+    curl_easy_setopt(curl, CURLOPT_MAXAGE_CONN, 30L);
+#endif
 
     struct HTTP_T *http = malloc(sizeof(struct HTTP_T));
     assert(http != NULL);
     http->curl = curl;
+    http->cancel_fn = NULL;
+    http->cancel_data = NULL;
+    http->multi = NULL;
     pthread_mutex_init(&http->mutex, NULL);
     return http;
 }
 
-int http_request(HTTP *http, char *url, HTTP_DATA *data) {
+int http_request(HTTP *http, char *url, HTTP_DATA *data, bool idempotent) {
     assert(http != NULL);
     assert(data != NULL);
     if (data->size > 0) {
@@ -96,6 +220,10 @@ int http_request(HTTP *http, char *url, HTTP_DATA *data) {
         data->memory[0] = 0;
         data->size = 0;
     }
+    char authority[HTTP_AUTHORITY_MAX];
+    url_authority(url, authority, sizeof(authority));
+    http_pool_host_t *host = pool_host_obtain(authority);
+
     pthread_mutex_lock(&http->mutex);
     CURL *curl = http->curl;
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, data);
@@ -103,41 +231,142 @@ int http_request(HTTP *http, char *url, HTTP_DATA *data) {
 
     commons_log_debug("GameStream", "Request %p %s", data, url);
 
-    int ret = GS_FAILED;
-    CURLcode res = curl_easy_perform(curl);
+    bool fresh = false, no_reuse = false;
+    pool_host_policy(host, idempotent, &fresh, &no_reuse);
 
-    if (res == CURLE_HTTP_RETURNED_ERROR) {
-        int http_status = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
-        commons_log_warn("GameStream", "Request %p error HTTP %d", data, http_status);
-        goto finish;
-    } else if (res != CURLE_OK) {
-        const char *errmsg = curl_easy_strerror(res);
-        ret = gs_set_error(GS_IO_ERROR, "cURL error: %s", errmsg);
-        commons_log_debug("GameStream", "Request %p error %d: %s", data, ret, errmsg);
-        goto finish;
+    http_pool_share_t *share = pool_share_attach(curl);
+    prepare_request(curl, data, fresh, no_reuse);
+    CURLcode res = perform(http);
+
+    if (should_retry_fresh(curl, res, idempotent, fresh, no_reuse)) {
+        // Some GFE versions break pooled connections (https://github.com/mariotaku/moonlight-tv/issues/452).
+        // Retry with a brand-new connection, and stop reusing connections to this host if that helps.
+        commons_log_warn("GameStream", "Request %p failed on reused connection to %s: %s, retrying", data,
+                         authority, curl_easy_strerror(res));
+        prepare_request(curl, data, true, true);
+        res = perform(http);
+        if (res == CURLE_OK) {
+            pool_host_mark_broken(host);
+        }
     }
-    assert (data->memory != NULL);
-    int http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &http_code);
-    commons_log_debug("GameStream", "Request %p response %d", data, http_code);
-    commons_log_hexdump(COMMONS_LOG_LEVEL_VERBOSE, "GameStream", data->memory, data->size);
+    pool_share_detach(curl, share);
 
-    ret = GS_OK;
-    finish:
+    int ret = request_result(curl, res, data);
     pthread_mutex_unlock(&http->mutex);
     return ret;
 }
 
+int http_request_async(HTTP *http, const char *url, bool idempotent, http_async_cb cb, void *userdata) {
+    assert(http != NULL);
+    assert(cb != NULL);
+    pthread_once(&engine_once, engine_init);
+
+    http_async_req_t *req = calloc(1, sizeof(http_async_req_t));
+    assert(req != NULL);
+    pthread_mutex_lock(&http->mutex);
+    // Duplicated handle inherits certificate, timeout and pool settings of this instance
+    req->curl = curl_easy_duphandle(http->curl);
+    pthread_mutex_unlock(&http->mutex);
+    if (req->curl == NULL) {
+        free(req);
+        return gs_set_error(GS_OUT_OF_MEMORY, "Failed to create cURL instance");
+    }
+    // Cancel callback is meant for the requesting thread, not the engine thread
+    curl_easy_setopt(req->curl, CURLOPT_NOPROGRESS, 1L);
+    req->data = http_data_alloc();
+    req->cb = cb;
+    req->userdata = userdata;
+    req->idempotent = idempotent;
+    url_authority(url, req->authority, sizeof(req->authority));
+    req->host = pool_host_obtain(req->authority);
+    pool_host_policy(req->host, idempotent, &req->fresh, &req->no_reuse);
+    req->share = pool_share_attach(req->curl);
+
+    curl_easy_setopt(req->curl, CURLOPT_URL, url);
+    curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, req->data);
+    curl_easy_setopt(req->curl, CURLOPT_PRIVATE, req);
+    prepare_request(req->curl, req->data, req->fresh, req->no_reuse);
+
+    commons_log_debug("GameStream", "Request %p %s (async)", req->data, url);
+
+    pthread_mutex_lock(&engine.lock);
+    if (engine.stopping || engine.multi == NULL) {
+        bool stopping = engine.stopping;
+        pthread_mutex_unlock(&engine.lock);
+        pool_share_detach(req->curl, req->share);
+        curl_easy_cleanup(req->curl);
+        http_data_free(req->data);
+        free(req);
+        if (stopping) {
+            return gs_set_error(GS_WRONG_STATE, "Async HTTP engine has been shut down");
+        }
+        return gs_set_error(GS_FAILED, "Async HTTP engine is not available");
+    }
+    req->next = engine.pending;
+    engine.pending = req;
+    // Multi handle is only released after stopping is set, so it's still there
+    engine_wakeup();
+    pthread_mutex_unlock(&engine.lock);
+    return GS_OK;
+}
+
+void http_async_shutdown() {
+    pthread_mutex_lock(&engine.lock);
+    bool started = engine.started;
+    engine.stopping = true;
+    if (started) {
+        engine_wakeup();
+    }
+    pthread_mutex_unlock(&engine.lock);
+    if (!started) {
+        return;
+    }
+    pthread_join(engine.thread, NULL);
+    pthread_mutex_lock(&engine.lock);
+    curl_multi_cleanup(engine.multi);
+    engine.multi = NULL;
+    engine.started = false;
+    pthread_mutex_unlock(&engine.lock);
+}
+
 void http_destroy(HTTP *http) {
     assert(http != NULL);
     pthread_mutex_lock(&http->mutex);
     curl_easy_cleanup(http->curl);
+    if (http->multi != NULL) {
+        curl_multi_cleanup(http->multi);
+    }
     pthread_mutex_unlock(&http->mutex);
     pthread_mutex_destroy(&http->mutex);
     free((void *) http);
 }
 
+void http_pool_invalidate(const char *address, unsigned short port) {
+    char authority[HTTP_AUTHORITY_MAX];
+    if (strchr(address, ':') != NULL) {
+        snprintf(authority, sizeof(authority), "[%s]:%u", address, port);
+    } else {
+        snprintf(authority, sizeof(authority), "%s:%u", address, port);
+    }
+    commons_log_info("GameStream", "Dropping pooled connections and TLS sessions after %s changed", authority);
+    pthread_once(&pool_once, pool_init);
+    // curl can't evict a single host, so start over with an empty pool
+    http_pool_share_t *share = pool_share_create();
+    pthread_mutex_lock(&pool.hosts_lock);
+    http_pool_share_t *old = pool.share;
+    pool.share = share;
+    bool release = false;
+    if (old != NULL) {
+        old->retired = true;
+        release = old->refs == 0;
+    }
+    pthread_mutex_unlock(&pool.hosts_lock);
+    if (release) {
+        curl_share_cleanup(old->share);
+        free(old);
+    }
+}
+
 void http_set_timeout(HTTP *http, int timeout) {
     assert(http != NULL);
     pthread_mutex_lock(&http->mutex);
@@ -145,6 +374,18 @@ void http_set_timeout(HTTP *http, int timeout) {
     pthread_mutex_unlock(&http->mutex);
 }
 
+void http_set_cancel(HTTP *http, http_cancel_fn fn, void *userdata) {
+    assert(http != NULL);
+    pthread_mutex_lock(&http->mutex);
+    http->cancel_fn = fn;
+    http->cancel_data = userdata;
+    // Progress callback aborts transfers between polls, e.g. while a large response keeps arriving
+    curl_easy_setopt(http->curl, CURLOPT_NOPROGRESS, fn != NULL ? 0L : 1L);
+    curl_easy_setopt(http->curl, CURLOPT_XFERINFOFUNCTION, fn != NULL ? progress_fn : NULL);
+    curl_easy_setopt(http->curl, CURLOPT_XFERINFODATA, http);
+    pthread_mutex_unlock(&http->mutex);
+}
+
 HTTP_DATA *http_data_alloc() {
     HTTP_DATA *data = malloc(sizeof(HTTP_DATA));
     assert(data != NULL);
@@ -166,3 +407,373 @@ void http_data_free(HTTP_DATA *data) {
 
     free(data);
 }
+
+static void pool_init() {
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&pool.locks[i], NULL);
+    }
+    pthread_mutex_init(&pool.hosts_lock, NULL);
+    pool.hosts = NULL;
+    pool.share = pool_share_create();
+}
+
+static http_pool_share_t *pool_share_create() {
+    CURLSH *share = curl_share_init();
+    if (share == NULL) {
+        commons_log_warn("GameStream", "Failed to create connection pool, connections will not be reused");
+        return NULL;
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, pool_lock);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, pool_unlock);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+    http_pool_share_t *result = calloc(1, sizeof(http_pool_share_t));
+    assert(result != NULL);
+    result->share = share;
+    return result;
+}
+
+/**
+ * Attach the handle to the current pool for one request. Returns the share to pass to pool_share_detach.
+ */
+static http_pool_share_t *pool_share_attach(CURL *curl) {
+    pthread_once(&pool_once, pool_init);
+    pthread_mutex_lock(&pool.hosts_lock);
+    http_pool_share_t *share = pool.share;
+    if (share != NULL) {
+        share->refs++;
+    }
+    pthread_mutex_unlock(&pool.hosts_lock);
+    curl_easy_setopt(curl, CURLOPT_SHARE, share != NULL ? share->share : NULL);
+    return share;
+}
+
+static void pool_share_detach(CURL *curl, http_pool_share_t *share) {
+    if (share == NULL) {
+        return;
+    }
+    curl_easy_setopt(curl, CURLOPT_SHARE, NULL);
+    pthread_mutex_lock(&pool.hosts_lock);
+    share->refs--;
+    bool release = share->retired && share->refs == 0;
+    pthread_mutex_unlock(&pool.hosts_lock);
+    if (release) {
+        curl_share_cleanup(share->share);
+        free(share);
+    }
+}
+
+static void pool_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    (void) handle;
+    (void) access;
+    (void) userptr;
+    pthread_mutex_lock(&pool.locks[data]);
+}
+
+static void pool_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    (void) handle;
+    (void) userptr;
+    pthread_mutex_unlock(&pool.locks[data]);
+}
+
+static http_pool_host_t *pool_host_obtain(const char *authority) {
+    if (authority[0] == '\0') {
+        return NULL;
+    }
+    pthread_once(&pool_once, pool_init);
+    pthread_mutex_lock(&pool.hosts_lock);
+    http_pool_host_t *host;
+    for (host = pool.hosts; host != NULL; host = host->next) {
+        if (strcmp(host->authority, authority) == 0) {
+            break;
+        }
+    }
+    if (host == NULL) {
+        host = calloc(1, sizeof(http_pool_host_t));
+        assert(host != NULL);
+        strncpy(host->authority, authority, HTTP_AUTHORITY_MAX - 1);
+        host->next = pool.hosts;
+        pool.hosts = host;
+    }
+    pthread_mutex_unlock(&pool.hosts_lock);
+    return host;
+}
+
+/**
+ * Extract "host:port" part of the URL, used as key of the pool.
+ */
+static void url_authority(const char *url, char *authority, size_t len) {
+    authority[0] = '\0';
+    const char *start = strstr(url, "://");
+    if (start == NULL) {
+        return;
+    }
+    start += 3;
+    size_t alen = strcspn(start, "/?");
+    if (alen >= len) {
+        return;
+    }
+    memcpy(authority, start, alen);
+    authority[alen] = '\0';
+}
+
+static void pool_host_policy(http_pool_host_t *host, bool idempotent, bool *fresh, bool *no_reuse) {
+    // Can't be retried if a pooled connection turns out dead (https://github.com/mariotaku/moonlight-tv/issues/452)
+    *fresh = !idempotent;
+    *no_reuse = false;
+    if (host == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool.hosts_lock);
+    *no_reuse = host->reuse_broken;
+    pthread_mutex_unlock(&pool.hosts_lock);
+}
+
+static void pool_host_mark_broken(http_pool_host_t *host) {
+    if (host == NULL) {
+        return;
+    }
+    commons_log_warn("GameStream", "Disabled connection reuse for %s", host->authority);
+    pthread_mutex_lock(&pool.hosts_lock);
+    host->reuse_broken = true;
+    pthread_mutex_unlock(&pool.hosts_lock);
+}
+
+static bool should_retry_fresh(CURL *curl, CURLcode res, bool idempotent, bool fresh, bool no_reuse) {
+    // Host may have handled the request before the connection broke, e.g. launched an app or went on pairing
+    if (!idempotent || fresh || no_reuse) {
+        return false;
+    }
+    switch (res) {
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PARTIAL_FILE:
+            break;
+        default:
+            return false;
+    }
+    long new_connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &new_connects);
+    // Only a failure on a reused connection is worth retrying
+    return new_connects == 0;
+}
+
+static void prepare_request(CURL *curl, HTTP_DATA *data, bool fresh, bool no_reuse) {
+    if (data->size > 0) {
+        data->memory[0] = 0;
+        data->size = 0;
+    }
+    curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, fresh || no_reuse ? 1L : 0L);
+    curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, no_reuse ? 1L : 0L);
+}
+
+static int request_result(CURL *curl, CURLcode res, HTTP_DATA *data) {
+    if (res == CURLE_ABORTED_BY_CALLBACK) {
+        commons_log_debug("GameStream", "Request %p cancelled", data);
+        return gs_set_error(GS_CANCELLED, "Request cancelled");
+    } else if (res == CURLE_HTTP_RETURNED_ERROR) {
+        int http_status = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_status);
+        commons_log_warn("GameStream", "Request %p error HTTP %d", data, http_status);
+        return GS_FAILED;
+    } else if (res != CURLE_OK) {
+        const char *errmsg = curl_easy_strerror(res);
+        int ret = gs_set_error(GS_IO_ERROR, "cURL error: %s", errmsg);
+        commons_log_debug("GameStream", "Request %p error %d: %s", data, ret, errmsg);
+        return ret;
+    }
+    assert (data->memory != NULL);
+    int http_code = 0;
+    curl_easy_getinfo(curl, CURLINFO_HTTP_CODE, &http_code);
+    commons_log_debug("GameStream", "Request %p response %d", data, http_code);
+    commons_log_hexdump(COMMONS_LOG_LEVEL_VERBOSE, "GameStream", data->memory, data->size);
+    return GS_OK;
+}
+
+/**
+ * Run the request with the HTTP mutex held. Cancellable requests wake up every HTTP_CANCEL_POLL_MS to check the
+ * cancel callback, and removing the handle mid-transfer closes its connection.
+ */
+static CURLcode perform(HTTP *http) {
+    if (http->cancel_fn == NULL) {
+        return curl_easy_perform(http->curl);
+    }
+    if (http->cancel_fn(http->cancel_data)) {
+        return CURLE_ABORTED_BY_CALLBACK;
+    }
+    if (http->multi == NULL && (http->multi = curl_multi_init()) == NULL) {
+        // Still cancellable through the progress callback, just not as quickly
+        return curl_easy_perform(http->curl);
+    }
+    if (curl_multi_add_handle(http->multi, http->curl) != CURLM_OK) {
+        return curl_easy_perform(http->curl);
+    }
+    CURLcode res = CURLE_OK;
+    int running = 1;
+    while (running > 0) {
+        if (curl_multi_perform(http->multi, &running) != CURLM_OK) {
+            res = CURLE_FAILED_INIT;
+            break;
+        }
+        if (running == 0) {
+            break;
+        }
+        if (http->cancel_fn(http->cancel_data)) {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+#if LIBCURL_VERSION_NUM >= 0x074200
+        curl_multi_poll(http->multi, NULL, 0, HTTP_CANCEL_POLL_MS, NULL);
+#else
+        int numfds = 0;
+        curl_multi_wait(http->multi, NULL, 0, HTTP_CANCEL_POLL_MS, &numfds);
+        if (numfds == 0) {
+            // Older versions return right away when there's nothing to wait on
+            usleep(HTTP_CANCEL_POLL_MS * 1000);
+        }
+#endif
+    }
+    if (running == 0) {
+        CURLMsg *msg;
+        int msgs_left = 0;
+        while ((msg = curl_multi_info_read(http->multi, &msgs_left)) != NULL) {
+            if (msg->msg == CURLMSG_DONE) {
+                res = msg->data.result;
+            }
+        }
+    }
+    curl_multi_remove_handle(http->multi, http->curl);
+    return res;
+}
+
+static int progress_fn(void *userp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void) dltotal;
+    (void) dlnow;
+    (void) ultotal;
+    (void) ulnow;
+    HTTP *http = (HTTP *) userp;
+    return http->cancel_fn != NULL && http->cancel_fn(http->cancel_data);
+}
+
+static void engine_init() {
+    pthread_mutex_lock(&engine.lock);
+    if (engine.stopping) {
+        pthread_mutex_unlock(&engine.lock);
+        return;
+    }
+    engine.multi = curl_multi_init();
+    if (engine.multi == NULL) {
+        pthread_mutex_unlock(&engine.lock);
+        commons_log_error("GameStream", "Failed to create cURL multi instance");
+        return;
+    }
+    // Don't flood a single host when lots of requests are queued (e.g. a screen of covers)
+    curl_multi_setopt(engine.multi, CURLMOPT_MAX_HOST_CONNECTIONS, 4L);
+    if (pthread_create(&engine.thread, NULL, engine_loop, NULL) != 0) {
+        commons_log_error("GameStream", "Failed to start async HTTP thread");
+        curl_multi_cleanup(engine.multi);
+        engine.multi = NULL;
+    } else {
+        engine.started = true;
+    }
+    pthread_mutex_unlock(&engine.lock);
+}
+
+static void *engine_loop(void *arg) {
+    (void) arg;
+    for (;;) {
+        pthread_mutex_lock(&engine.lock);
+        http_async_req_t *pending = engine.pending;
+        engine.pending = NULL;
+        bool stopping = engine.stopping;
+        pthread_mutex_unlock(&engine.lock);
+        while (pending != NULL) {
+            http_async_req_t *next = pending->next;
+            engine_add(pending);
+            pending = next;
+        }
+        if (stopping) {
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(engine.multi, &running);
+
+        CURLMsg *msg;
+        int msgs_left = 0;
+        while ((msg = curl_multi_info_read(engine.multi, &msgs_left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            http_async_req_t *req = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **) &req);
+            CURLcode res = msg->data.result;
+            engine_remove(req);
+            engine_complete(req, res);
+        }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_poll(engine.multi, NULL, 0, 1000, NULL);
+#else
+        // Without curl_multi_wakeup, poll with a short timeout to pick up new requests
+        curl_multi_wait(engine.multi, NULL, 0, running > 0 ? 10 : 50, NULL);
+#endif
+    }
+    // Callbacks are still invoked exactly once, nothing new can be queued by now
+    while (engine.active != NULL) {
+        http_async_req_t *req = engine.active;
+        engine_remove(req);
+        engine_complete(req, CURLE_ABORTED_BY_CALLBACK);
+    }
+    return NULL;
+}
+
+static void engine_wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(engine.multi);
+#endif
+}
+
+static void engine_add(http_async_req_t *req) {
+    curl_multi_add_handle(engine.multi, req->curl);
+    req->next = engine.active;
+    engine.active = req;
+}
+
+static void engine_remove(http_async_req_t *req) {
+    curl_multi_remove_handle(engine.multi, req->curl);
+    http_async_req_t **link = &engine.active;
+    while (*link != NULL && *link != req) {
+        link = &(*link)->next;
+    }
+    if (*link != NULL) {
+        *link = req->next;
+    }
+    req->next = NULL;
+}
+
+static void engine_complete(http_async_req_t *req, CURLcode res) {
+    if (should_retry_fresh(req->curl, res, req->idempotent, req->fresh, req->no_reuse)) {
+        commons_log_warn("GameStream", "Request %p failed on reused connection to %s: %s, retrying", req->data,
+                         req->authority, curl_easy_strerror(res));
+        req->fresh = req->no_reuse = true;
+        req->retried = true;
+        prepare_request(req->curl, req->data, true, true);
+        engine_add(req);
+        return;
+    }
+    if (req->retried && res == CURLE_OK) {
+        pool_host_mark_broken(req->host);
+    }
+    pool_share_detach(req->curl, req->share);
+    int ret = request_result(req->curl, res, req->data);
+    req->cb(ret, req->data, req->userdata);
+    curl_easy_cleanup(req->curl);
+    http_data_free(req->data);
+    free(req);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "http.h"
+#include <limits.h>
+#include <pthread.h>
 #include <mbedtls/pk.h>
 #include <mbedtls/x509_crt.h>
 
@@ -10,10 +12,21 @@
 #define UNIQUEID_BYTES 8
 #define UNIQUEID_CHARS (UNIQUEID_BYTES * 2)
 
-struct GS_CLIENT_T {
+/**
+ * Client identity loaded from the key directory. Shared by all clients and not modified after loading.
+ */
+typedef struct GS_CREDENTIALS_T {
+    int refcount;
+    char keydir[PATH_MAX];
     char unique_id[UNIQUEID_CHARS + 1];
     mbedtls_pk_context pk;
+    /** RSA blinding state in pk is updated while signing */
+    pthread_mutex_t sign_lock;
     mbedtls_x509_crt cert;
     char cert_hex[8192];
+} GS_CREDENTIALS;
+
+struct GS_CLIENT_T {
+    GS_CREDENTIALS *creds;
     HTTP *http;
 };
@@ -5,8 +5,9 @@
 #include <stdarg.h>
 #include <stdio.h>
 
-static int gs_errno = GS_OK;
-static char gs_errmsg[1024];
+// Requests run on many threads at once (executor workers, async HTTP thread), each reads back its own error
+static _Thread_local int gs_errno = GS_OK;
+static _Thread_local char gs_errmsg[1024];
 
 int gs_get_error(const char **message) {
     if (message != NULL) {
@@ -21,26 +21,49 @@
 
 #include "h264_stream.h"
 
-static h264_stream_t* h264_stream;
-static int initial_width, initial_height;
+#include <stdlib.h>
+#include <string.h>
 
-void gs_sps_init(int width, int height) {
-    h264_stream = h264_new();
-    initial_width = width;
-    initial_height = height;
+struct GS_SPS_FIXER_T {
+    h264_stream_t *h264_stream;
+    int initial_width, initial_height;
+    int flags;
+};
+
+GS_SPS_FIXER gs_sps_fixer_new(int videoFormat, int width, int height, int flags) {
+    if (!(videoFormat & VIDEO_FORMAT_MASK_H264)) {
+        return NULL;
+    }
+    struct GS_SPS_FIXER_T *fixer = calloc(1, sizeof(struct GS_SPS_FIXER_T));
+    if (fixer == NULL) {
+        return NULL;
+    }
+    fixer->h264_stream = h264_new();
+    fixer->initial_width = width;
+    fixer->initial_height = height;
+    fixer->flags = flags;
+    return fixer;
 }
 
-void gs_sps_fix(PLENTRY sps, int flags, uint8_t* out_buf, uint32_t* out_offset) {
-    const char naluHeader[] = {0x00, 0x00, 0x00, 0x01};
+size_t gs_sps_fix(GS_SPS_FIXER fixer, const LENTRY *sps, uint8_t *out_buf, size_t out_size) {
+    const uint8_t naluHeader[] = {0x00, 0x00, 0x00, 0x01};
+    h264_stream_t *h264_stream = fixer->h264_stream;
+    int flags = fixer->flags;
 
-    read_nal_unit(h264_stream, sps->data+4, sps->length-4);
+    if (sps->length <= 4 || out_size <= sizeof(naluHeader)) {
+        return 0;
+    }
+    if (read_nal_unit(h264_stream, (uint8_t *) sps->data + 4, sps->length - 4) < 0 ||
+        h264_stream->nal->nal_unit_type != NAL_UNIT_TYPE_SPS) {
+        return 0;
+    }
 
     // Some decoders rely on H264 level to decide how many buffers are needed
     // Since we only need one frame buffered, we'll set level as low as we can
     // for known resolution combinations. Otherwise leave the profile alone (currently 5.0)
-    if (initial_width == 1280 && initial_height == 720)
+    if (fixer->initial_width == 1280 && fixer->initial_height == 720)
         h264_stream->sps->level_idc = 32; // Max 5 buffered frames at 1280x720x60
-    else if (initial_width == 1920 && initial_height == 1080)
+    else if (fixer->initial_width == 1920 && fixer->initial_height == 1080)
         h264_stream->sps->level_idc = 42; // Max 4 buffered frames at 1920x1080x60
 
     // Some decoders requires a reference frame count of 1 to decode successfully.
@@ -54,6 +77,9 @@ void gs_sps_fix(PLENTRY sps, int flags, uint8_t* out_buf, uint32_t* out_offset)
         h264_stream->sps->vui.chroma_loc_info_present_flag = 0;
 
     if ((flags & GS_SPS_BITSTREAM_FIXUP) == GS_SPS_BITSTREAM_FIXUP) {
+        // Bitstream restriction lives in VUI, add an otherwise empty one if the host didn't send any
+        h264_stream->sps->vui_parameters_present_flag = 1;
+
         // The SPS that comes in the current H264 bytestream doesn't set the bitstream_restriction_flag
         // or the max_dec_frame_buffering which increases decoding latency on some devices.
         // log2_max_mv_length_horizontal and log2_max_mv_length_vertical are set to more
@@ -76,12 +102,19 @@ void gs_sps_fix(PLENTRY sps, int flags, uint8_t* out_buf, uint32_t* out_offset)
         h264_stream->sps->vui.max_bits_per_mb_denom = 1;
     }
 
-    memcpy(out_buf+*out_offset, naluHeader, 4);
-    *out_offset += 4;
-
-    *out_offset += write_nal_unit(h264_stream, out_buf+*out_offset, 128);
+    size_t max_size = sps->length + GS_SPS_MAX_GROWTH;
+    if (max_size > out_size) {
+        max_size = out_size;
+    }
+    memcpy(out_buf, naluHeader, sizeof(naluHeader));
+    int written = write_nal_unit(h264_stream, out_buf + sizeof(naluHeader), (int) (max_size - sizeof(naluHeader)));
+    if (written <= 0) {
+        return 0;
+    }
+    return sizeof(naluHeader) + written;
 }
 
-void gs_sps_finalize() {
-    h264_free(h264_stream);
-}
\ No newline at end of file
+void gs_sps_fixer_free(GS_SPS_FIXER fixer) {
+    h264_free(fixer->h264_stream);
+    free(fixer);
+}
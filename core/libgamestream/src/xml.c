@@ -34,6 +34,28 @@ struct xml_query {
     void *data;
 };
 
+typedef enum applist_field_t {
+    APPLIST_FIELD_NONE,
+    APPLIST_FIELD_ID,
+    APPLIST_FIELD_TITLE,
+    APPLIST_FIELD_HDR,
+} applist_field_t;
+
+struct applist_query {
+    size_t item_size;
+    /** Items being parsed. Titles are stored as offsets, as the pool moves while it grows */
+    char *items;
+    size_t *title_offsets;
+    size_t count, capacity;
+    char *titles;
+    size_t titles_size, titles_capacity;
+    applist_field_t field;
+    char value[16];
+    size_t value_len;
+    int status;
+    bool oom;
+};
+
 static void XMLCALL start_element(void *userData, const char *name, const char **atts);
 
 static void XMLCALL end_element(void *userData, const char *name);
@@ -42,6 +64,10 @@ static void XMLCALL start_applist_element(void *userData, const char *name, cons
 
 static void XMLCALL end_applist_element(void *userData, const char *name);
 
+static void XMLCALL write_applist_cdata(void *userData, const XML_Char *s, int len);
+
+static int applist_titles_reserve(struct applist_query *query, size_t len);
+
 static void XMLCALL start_mode_element(void *userData, const char *name, const char **atts);
 
 static void XMLCALL end_mode_element(void *userData, const char *name);
@@ -50,8 +76,51 @@ static void XMLCALL start_status_element(void *userData, const char *name, const
 
 static void XMLCALL end_status_element(void *userData, const char *name);
 
+static void XMLCALL start_serverinfo_element(void *userData, const char *name, const char **atts);
+
+static void XMLCALL end_serverinfo_element(void *userData, const char *name);
+
+static void XMLCALL write_serverinfo_cdata(void *userData, const XML_Char *s, int len);
+
 static void XMLCALL write_cdata(void *userData, const XML_Char *s, int len);
 
+static void parse_status_attrs(int *status, const char **atts);
+
+static void serverinfo_free(SERVERINFO_XML *info);
+
+static const char *const serverinfo_field_names[SERVERINFO_FIELD_COUNT] = {
+        [SERVERINFO_UNIQUEID] = "uniqueid",
+        [SERVERINFO_MAC] = "mac",
+        [SERVERINFO_HOSTNAME] = "hostname",
+        [SERVERINFO_CURRENTGAME] = "currentgame",
+        [SERVERINFO_PAIRSTATUS] = "PairStatus",
+        [SERVERINFO_APPVERSION] = "appversion",
+        [SERVERINFO_STATE] = "state",
+        [SERVERINFO_CODEC_MODE_SUPPORT] = "ServerCodecModeSupport",
+        [SERVERINFO_GPUTYPE] = "gputype",
+        [SERVERINFO_GSVERSION] = "GsVersion",
+        [SERVERINFO_GFEVERSION] = "GfeVersion",
+        [SERVERINFO_HTTPSPORT] = "HttpsPort",
+        [SERVERINFO_EXTERNALPORT] = "ExternalPort",
+};
+
+typedef enum serverinfo_mode_field_t {
+    SERVERINFO_MODE_NONE,
+    SERVERINFO_MODE_WIDTH,
+    SERVERINFO_MODE_HEIGHT,
+    SERVERINFO_MODE_REFRESH,
+} serverinfo_mode_field_t;
+
+struct serverinfo_query {
+    SERVERINFO_XML *info;
+    /** Field the character data currently belongs to, or -1 */
+    int field;
+    size_t field_len[SERVERINFO_FIELD_COUNT];
+    serverinfo_mode_field_t mode_field;
+    char mode_value[16];
+    size_t mode_value_len;
+};
+
 int xml_search(char *data, size_t len, const char *node, char **result) {
     return xml_search_ex(data, len, node, false, result);
 }
@@ -80,29 +149,59 @@ int xml_search_ex(char *data, size_t len, const char *node, bool required, char
     return GS_OK;
 }
 
-int xml_applist(char *data, size_t len, PAPP_LIST *app_list) {
-    struct xml_query query = {0};
+int xml_applist(char *data, size_t len, size_t item_size, PAPP_ARRAY *apps) {
+    assert(item_size >= sizeof(APP_LIST) && item_size % sizeof(void *) == 0);
+    struct applist_query query = {.item_size = item_size};
+    // Offset 0 of the title pool is an empty string, for apps without a title
+    if (applist_titles_reserve(&query, 1) != GS_OK) {
+        return gs_set_error(GS_OUT_OF_MEMORY, "Out of memory");
+    }
+    query.titles[query.titles_size++] = '\0';
+
     XML_Parser parser = XML_ParserCreate("UTF-8");
     XML_SetUserData(parser, &query);
     XML_SetElementHandler(parser, start_applist_element, end_applist_element);
-    XML_SetCharacterDataHandler(parser, write_cdata);
+    XML_SetCharacterDataHandler(parser, write_applist_cdata);
+    int ret = GS_OK;
     if (!XML_Parse(parser, data, (int) len, 1)) {
         int code = XML_GetErrorCode(parser);
-        const char *error = XML_ErrorString(code);
-        XML_ParserFree(parser);
-        if (query.memory != NULL) {
-            free(query.memory);
-        }
-        return gs_set_error(GS_INVALID, "XML error %d: %s", code, error);
+        ret = gs_set_error(GS_INVALID, "XML error %d: %s", code, XML_ErrorString(code));
+    } else if (query.oom) {
+        ret = gs_set_error(GS_OUT_OF_MEMORY, "Out of memory");
+    } else if (query.status != STATUS_OK) {
+        // Error message has been set by parse_status_attrs
+        ret = GS_ERROR;
     }
-
     XML_ParserFree(parser);
-    if (query.memory != NULL) {
-        free(query.memory);
+    if (ret != GS_OK) {
+        goto cleanup;
     }
-    *app_list = (PAPP_LIST) query.data;
 
-    return GS_OK;
+    // Compact everything into one block, now that the final sizes are known
+    size_t items_size = query.count * item_size;
+    PAPP_ARRAY result = malloc(sizeof(APP_ARRAY) + items_size + query.titles_size);
+    if (result == NULL) {
+        ret = gs_set_error(GS_OUT_OF_MEMORY, "Out of memory");
+        goto cleanup;
+    }
+    result->count = query.count;
+    result->item_size = item_size;
+    result->items = (char *) result + sizeof(APP_ARRAY);
+    char *titles = (char *) result->items + items_size;
+    if (items_size > 0) {
+        memcpy(result->items, query.items, items_size);
+    }
+    memcpy(titles, query.titles, query.titles_size);
+    for (size_t i = 0; i < query.count; i++) {
+        APP_ARRAY_ITEM(result, i)->name = titles + query.title_offsets[i];
+    }
+    *apps = result;
+
+    cleanup:
+    free(query.items);
+    free(query.title_offsets);
+    free(query.titles);
+    return ret;
 }
 
 int xml_modelist(char *data, size_t len, PDISPLAY_MODE *mode_list) {
@@ -147,6 +246,144 @@ int xml_status(char *data, size_t len) {
     return status == STATUS_OK ? GS_OK : GS_ERROR;
 }
 
+int xml_serverinfo(char *data, size_t len, SERVERINFO_XML *info) {
+    memset(info, 0, sizeof(*info));
+    struct serverinfo_query query = {.info = info, .field = -1};
+    XML_Parser parser = XML_ParserCreate("UTF-8");
+    XML_SetUserData(parser, &query);
+    XML_SetElementHandler(parser, start_serverinfo_element, end_serverinfo_element);
+    XML_SetCharacterDataHandler(parser, write_serverinfo_cdata);
+    if (!XML_Parse(parser, data, (int) len, 1)) {
+        int code = XML_GetErrorCode(parser);
+        const char *error = XML_ErrorString(code);
+        XML_ParserFree(parser);
+        serverinfo_free(info);
+        return gs_set_error(GS_INVALID, "XML error %d: %s", code, error);
+    }
+    XML_ParserFree(parser);
+    if (info->status != STATUS_OK) {
+        // Error message has been set by parse_status_attrs
+        serverinfo_free(info);
+        return GS_ERROR;
+    }
+
+    // Same as xml_search, missing fields are empty strings
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        if (info->fields[i] == NULL) {
+            info->fields[i] = calloc(1, 1);
+            assert(info->fields[i] != NULL);
+        }
+    }
+    return GS_OK;
+}
+
+void xml_serverinfo_clear(SERVERINFO_XML *info) {
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        if (info->fields[i] != NULL) {
+            free(info->fields[i]);
+            info->fields[i] = NULL;
+        }
+    }
+}
+
+static void serverinfo_free(SERVERINFO_XML *info) {
+    xml_serverinfo_clear(info);
+    while (info->modes != NULL) {
+        PDISPLAY_MODE next = info->modes->next;
+        free(info->modes);
+        info->modes = next;
+    }
+}
+
+void start_serverinfo_element(void *userData, const char *name, const char **atts) {
+    struct serverinfo_query *query = (struct serverinfo_query *) userData;
+    SERVERINFO_XML *info = query->info;
+    if (strcmp("root", name) == 0) {
+        parse_status_attrs(&info->status, atts);
+        return;
+    }
+    if (strcmp("DisplayMode", name) == 0) {
+        PDISPLAY_MODE mode = calloc(1, sizeof(DISPLAY_MODE));
+        if (mode != NULL) {
+            mode->next = info->modes;
+            info->modes = mode;
+        }
+        return;
+    }
+    if (info->modes != NULL) {
+        if (strcmp("Width", name) == 0) {
+            query->mode_field = SERVERINFO_MODE_WIDTH;
+        } else if (strcmp("Height", name) == 0) {
+            query->mode_field = SERVERINFO_MODE_HEIGHT;
+        } else if (strcmp("RefreshRate", name) == 0) {
+            query->mode_field = SERVERINFO_MODE_REFRESH;
+        }
+        if (query->mode_field != SERVERINFO_MODE_NONE) {
+            query->mode_value_len = 0;
+            return;
+        }
+    }
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        if (strcmp(serverinfo_field_names[i], name) == 0) {
+            query->field = i;
+            if (info->fields[i] == NULL) {
+                info->fields[i] = calloc(1, 1);
+                assert(info->fields[i] != NULL);
+            }
+            return;
+        }
+    }
+}
+
+void end_serverinfo_element(void *userData, const char *name) {
+    struct serverinfo_query *query = (struct serverinfo_query *) userData;
+    (void) name;
+    if (query->mode_field != SERVERINFO_MODE_NONE) {
+        PDISPLAY_MODE mode = query->info->modes;
+        query->mode_value[query->mode_value_len] = '\0';
+        unsigned int value = strtol(query->mode_value, NULL, 10);
+        switch (query->mode_field) {
+            case SERVERINFO_MODE_WIDTH:
+                mode->width = value;
+                break;
+            case SERVERINFO_MODE_HEIGHT:
+                mode->height = value;
+                break;
+            case SERVERINFO_MODE_REFRESH:
+                mode->refresh = value;
+                break;
+            default:
+                break;
+        }
+        query->mode_field = SERVERINFO_MODE_NONE;
+    }
+    query->field = -1;
+}
+
+void write_serverinfo_cdata(void *userData, const XML_Char *s, int len) {
+    struct serverinfo_query *query = (struct serverinfo_query *) userData;
+    if (query->mode_field != SERVERINFO_MODE_NONE) {
+        size_t copy_len = len;
+        if (query->mode_value_len + copy_len >= sizeof(query->mode_value)) {
+            copy_len = sizeof(query->mode_value) - 1 - query->mode_value_len;
+        }
+        memcpy(query->mode_value + query->mode_value_len, s, copy_len);
+        query->mode_value_len += copy_len;
+        return;
+    }
+    if (query->field < 0) {
+        return;
+    }
+    char **field = &query->info->fields[query->field];
+    size_t *field_len = &query->field_len[query->field];
+    void *allocated = realloc(*field, *field_len + len + 1);
+    assert(allocated != NULL);
+    *field = allocated;
+    memcpy(*field + *field_len, s, len);
+    *field_len += len;
+    (*field)[*field_len] = 0;
+}
+
 void start_element(void *userData, const char *name, const char **atts) {
     struct xml_query *search = (struct xml_query *) userData;
     if (strcmp(search->data, name) == 0) {
@@ -162,48 +399,117 @@ void end_element(void *userData, const char *name) {
 }
 
 void start_applist_element(void *userData, const char *name, const char **atts) {
-    struct xml_query *search = (struct xml_query *) userData;
-    if (strcmp("App", name) == 0) {
-        PAPP_LIST app = malloc(sizeof(APP_LIST));
-        if (app == NULL) {
-            return;
+    struct applist_query *query = (struct applist_query *) userData;
+    if (query->oom) {
+        return;
+    }
+    if (strcmp("root", name) == 0) {
+        parse_status_attrs(&query->status, atts);
+    } else if (strcmp("App", name) == 0) {
+        if (query->count == query->capacity) {
+            size_t capacity = query->capacity ? query->capacity * 2 : 64;
+            void *items = realloc(query->items, capacity * query->item_size);
+            if (items == NULL) {
+                query->oom = true;
+                return;
+            }
+            query->items = items;
+            size_t *offsets = realloc(query->title_offsets, capacity * sizeof(size_t));
+            if (offsets == NULL) {
+                query->oom = true;
+                return;
+            }
+            query->title_offsets = offsets;
+            query->capacity = capacity;
         }
-
-        app->id = 0;
-        app->name = NULL;
-        app->hdr = 0;
-        app->next = (PAPP_LIST) search->data;
-        search->data = app;
-    } else if (strcmp("ID", name) == 0 || strcmp("AppTitle", name) == 0 || strcmp("IsHdrSupported", name) == 0) {
-        search->memory = malloc(1);
-        search->size = 0;
-        search->start = 1;
+        memset(query->items + query->count * query->item_size, 0, query->item_size);
+        query->title_offsets[query->count] = 0;
+        query->count++;
+    } else if (query->count == 0) {
+        return;
+    } else if (strcmp("AppTitle", name) == 0) {
+        query->field = APPLIST_FIELD_TITLE;
+        query->title_offsets[query->count - 1] = query->titles_size;
+    } else if (strcmp("ID", name) == 0) {
+        query->field = APPLIST_FIELD_ID;
+        query->value_len = 0;
+    } else if (strcmp("IsHdrSupported", name) == 0) {
+        query->field = APPLIST_FIELD_HDR;
+        query->value_len = 0;
     }
 }
 
 void end_applist_element(void *userData, const char *name) {
-    struct xml_query *search = (struct xml_query *) userData;
-    if (search->start) {
-        PAPP_LIST list = (PAPP_LIST) search->data;
-        if (list == NULL) {
-            return;
-        }
+    struct applist_query *query = (struct applist_query *) userData;
+    if (query->oom || query->field == APPLIST_FIELD_NONE) {
+        return;
+    }
+    PAPP_LIST app = (PAPP_LIST) (query->items + (query->count - 1) * query->item_size);
+    switch (query->field) {
+        case APPLIST_FIELD_TITLE:
+            if (applist_titles_reserve(query, 1) == GS_OK) {
+                query->titles[query->titles_size++] = '\0';
+            }
+            break;
+        case APPLIST_FIELD_ID:
+            query->value[query->value_len] = '\0';
+            app->id = (int) strtol(query->value, NULL, 10);
+            break;
+        case APPLIST_FIELD_HDR:
+            query->value[query->value_len] = '\0';
+            app->hdr = (int) strtol(query->value, NULL, 10);
+            break;
+        default:
+            break;
+    }
+    query->field = APPLIST_FIELD_NONE;
+}
 
-        if (strcmp("ID", name) == 0) {
-            list->id = (int) strtol(search->memory, NULL, 10);
-            free(search->memory);
-            search->memory = NULL;
-        } else if (strcmp("AppTitle", name) == 0) {
-            list->name = search->memory;
-        } else if (strcmp("IsHdrSupported", name) == 0) {
-            list->hdr = (int) strtol(search->memory, NULL, 10);
-            free(search->memory);
-            search->memory = NULL;
+void write_applist_cdata(void *userData, const XML_Char *s, int len) {
+    struct applist_query *query = (struct applist_query *) userData;
+    if (query->oom) {
+        return;
+    }
+    switch (query->field) {
+        case APPLIST_FIELD_TITLE:
+            if (applist_titles_reserve(query, len) == GS_OK) {
+                memcpy(query->titles + query->titles_size, s, len);
+                query->titles_size += len;
+            }
+            break;
+        case APPLIST_FIELD_ID:
+        case APPLIST_FIELD_HDR: {
+            size_t copy_len = len;
+            if (query->value_len + copy_len >= sizeof(query->value)) {
+                copy_len = sizeof(query->value) - 1 - query->value_len;
+            }
+            memcpy(query->value + query->value_len, s, copy_len);
+            query->value_len += copy_len;
+            break;
         }
-        search->start = 0;
+        default:
+            break;
     }
 }
 
+static int applist_titles_reserve(struct applist_query *query, size_t len) {
+    if (query->titles_size + len <= query->titles_capacity) {
+        return GS_OK;
+    }
+    size_t capacity = query->titles_capacity ? query->titles_capacity : 4096;
+    while (capacity < query->titles_size + len) {
+        capacity *= 2;
+    }
+    char *titles = realloc(query->titles, capacity);
+    if (titles == NULL) {
+        query->oom = true;
+        return GS_OUT_OF_MEMORY;
+    }
+    query->titles = titles;
+    query->titles_capacity = capacity;
+    return GS_OK;
+}
+
 void start_mode_element(void *userData, const char *name, const char **atts) {
     struct xml_query *search = (struct xml_query *) userData;
     if (strcmp("DisplayMode", name) == 0) {
@@ -243,7 +549,10 @@ void start_status_element(void *userData, const char *name, const char **atts) {
     if (strcmp("root", name) != 0) {
         return;
     }
-    int *status = (int *) userData;
+    parse_status_attrs((int *) userData, atts);
+}
+
+void parse_status_attrs(int *status, const char **atts) {
     for (int i = 0; atts[i]; i += 2) {
         if (strcmp("status_code", atts[i]) == 0) {
             *status = atoi(atts[i + 1]);
@@ -28,8 +28,16 @@
 
 PCONFIGURATION app_configuration = NULL;
 
+/* Upper bound of sleeping in the main loop, even if no LVGL timer is due */
+#define APP_LOOP_MAX_WAIT_MS 500
+#define APP_LOOP_STATS_INTERVAL_MS 30000
+
 static void quit_confirm_cb(lv_event_t *e);
 
+static void app_wait_events(app_t *app, uint32_t timeout);
+
+static void app_loop_stats_update(app_t *app, bool by_event);
+
 static void libs_init(app_t *app, int argc, char *argv[]);
 
 app_t *global = NULL;
@@ -45,6 +53,7 @@ int app_init(app_t *app, app_settings_loader *settings_loader, int argc, char *a
     commons_log_info("APP", "Start Moonlight. Version %s", APP_VERSION);
     settings_loader(&app->settings);
     app->main_thread_id = SDL_ThreadID();
+    app_bus_init();
     app->running = true;
     app->focused = false;
 #if FEATURE_EMBEDDED_SHELL
@@ -122,6 +131,8 @@ void app_deinit(app_t *app) {
 
     _lv_draw_mask_cleanup();
 
+    app_bus_deinit();
+
     SDL_Quit();
 
     commons_logging_deinit();
@@ -129,8 +140,48 @@ void app_deinit(app_t *app) {
 
 void app_run_loop(app_t *app) {
     app_process_events(app);
-    lv_task_handler();
-    SDL_Delay(1);
+    app_ui_input_update_reading(&app->ui.input, SDL_HasEvents(SDL_FIRSTEVENT, SDL_LASTEVENT));
+    uint32_t next_timer = lv_timer_handler();
+    app_wait_events(app, next_timer);
+}
+
+/**
+ * Sleep until an event arrives, or the next LVGL timer is due
+ */
+static void app_wait_events(app_t *app, uint32_t timeout) {
+    if (timeout > APP_LOOP_MAX_WAIT_MS) {
+        timeout = APP_LOOP_MAX_WAIT_MS;
+    }
+    bool by_event = true;
+    if (timeout > 0) {
+        by_event = SDL_WaitEventTimeout(NULL, (int) timeout) != 0;
+    }
+    app_loop_stats_update(app, by_event);
+}
+
+static void app_loop_stats_update(app_t *app, bool by_event) {
+    if (by_event) {
+        app->loop_stats.event_wakeups++;
+    } else {
+        app->loop_stats.timer_wakeups++;
+    }
+    Uint32 now = SDL_GetTicks();
+    if (app->loop_stats.window_start == 0) {
+        app->loop_stats.window_start = now;
+        return;
+    }
+    Uint32 elapsed = now - app->loop_stats.window_start;
+    if (elapsed < APP_LOOP_STATS_INTERVAL_MS) {
+        return;
+    }
+    uint32_t wakeups = app->loop_stats.event_wakeups + app->loop_stats.timer_wakeups;
+    commons_log_debug("APP", "Main loop %s: %.1f wakeups/s, %u by events, %u by timers",
+                      app->session != NULL ? "streaming" : "launcher", wakeups * 1000.0 / elapsed,
+                      app->loop_stats.event_wakeups, app->loop_stats.timer_wakeups);
+    app_bus_log_stats();
+    app->loop_stats.event_wakeups = 0;
+    app->loop_stats.timer_wakeups = 0;
+    app->loop_stats.window_start = now;
 }
 
 static int app_event_filter(void *userdata, SDL_Event *event) {
@@ -190,9 +241,8 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
             break;
         }
         case SDL_USEREVENT: {
-            if (event->user.code == BUS_INT_EVENT_ACTION) {
-                bus_actionfunc actionfn = event->user.data1;
-                actionfn(event->user.data2);
+            if (event->user.code == BUS_INT_EVENT_WAKEUP) {
+                app_bus_dispatch();
             } else if (event->user.code == USER_INPUT_CONTROLLERDB_UPDATED) {
                 app_input_handle_event(&app->input, event);
             } else {
@@ -219,7 +269,14 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
         case SDL_CONTROLLERDEVICEADDED:
         case SDL_CONTROLLERDEVICEREMOVED:
         case SDL_CONTROLLERDEVICEREMAPPED: {
-            app_input_handle_event(&app->input, event);
+            if (app->session != NULL) {
+                // Gamepad thread may be using the gamepad state
+                session_lock_input(app->session);
+                app_input_handle_event(&app->input, event);
+                session_unlock_input(app->session);
+            } else {
+                app_input_handle_event(&app->input, event);
+            }
             if (app->session != NULL) {
                 session_handle_input_event(app->session, event);
                 return 0;
@@ -247,6 +304,11 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
                 }
             }
             if (!app_ui_is_opened(&app->ui) && app->session != NULL) {
+                if (event->type >= SDL_CONTROLLERAXISMOTION && event->type <= SDL_CONTROLLERSENSORUPDATE &&
+                    session_gamepads_threaded(app->session)) {
+                    // Gamepad thread takes these out of the queue itself
+                    return 1;
+                }
                 session_handle_input_event(app->session, event);
                 return 0;
             }
@@ -257,9 +319,9 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
         case SDL_FINGERMOTION: {
             if (app->session != NULL) {
                 session_handle_input_event(app->session, event);
-                return 0;
             }
-            return 1;
+            // No input device reads touch events, keeping them would wake up the main loop forever
+            return 0;
         }
         default:
             if (event->type == USER_REMOTEBUTTONEVENT) {
@@ -273,6 +335,11 @@ static int app_event_filter(void *userdata, SDL_Event *event) {
 void app_process_events(app_t *app) {
     SDL_PumpEvents();
     SDL_FilterEvents(app_event_filter, app);
+    // In case the wakeup event got lost in a full event queue
+    app_bus_dispatch();
+    if (app->session != NULL) {
+        session_flush_input(app->session);
+    }
 }
 
 void app_quit_confirm() {
@@ -55,6 +55,11 @@ typedef struct app_t {
 #endif
     app_wakelock_t *wakelock;
     session_t *session;
+    struct {
+        Uint32 window_start;
+        /* Main loop woke up because of events, or because an LVGL timer was due */
+        uint32_t event_wakeups, timer_wakeups;
+    } loop_stats;
 } app_t;
 
 int app_init(app_t *app, app_settings_loader *settings_loader, int argc, char *argv[]);
@@ -52,7 +52,9 @@ void settings_initialize(app_settings_t *config, char *conf_dir) {
     set_string(&config->language, "auto");
     set_string(&config->audio_backend, "auto");
     set_string(&config->decoder, "auto");
+    set_string(&config->sps_fixup, "auto");
     config->audio_device = NULL;
+    config->audio_latency_target = 40;
     config->sops = true;
     config->localaudio = false;
     config->fullscreen = true;
@@ -71,6 +73,8 @@ void settings_initialize(app_settings_t *config, char *conf_dir) {
     config->hevc = true;
     config->av1 = false;
     config->stick_deadzone = 7;
+    config->max_frame_size = 8;
+    config->cover_cache_size = 0;
 
     config->conf_dir = conf_dir;
     config->ini_path = path_join(conf_dir, CONF_NAME_MOONLIGHT);
@@ -93,6 +97,7 @@ bool settings_save(app_settings_t *config) {
     ini_write_string(fp, "language", config->language);
     ini_write_bool(fp, "fullscreen", config->fullscreen);
     ini_write_int(fp, "debug_level", config->debug_level);
+    ini_write_int(fp, "cover_cache_size", config->cover_cache_size);
 
     ini_write_section(fp, "streaming");
     ini_write_int(fp, "width", config->stream.width);
@@ -120,9 +125,14 @@ bool settings_save(app_settings_t *config) {
 
     ini_write_section(fp, "video");
     ini_write_string(fp, "decoder", config->decoder);
+    ini_write_string(fp, "sps_fixup", config->sps_fixup);
     ini_write_bool(fp, "hdr", config->hdr);
     ini_write_bool(fp, "hevc", config->hevc);
     ini_write_bool(fp, "av1", config->av1);
+    ini_write_int(fp, "max_frame_size", config->max_frame_size);
+    if (config->record_dir && config->record_dir[0]) {
+        ini_write_string(fp, "record_dir", config->record_dir);
+    }
 
     ini_write_section(fp, "audio");
     ini_write_string(fp, "backend", config->audio_backend);
@@ -130,6 +140,7 @@ bool settings_save(app_settings_t *config) {
         ini_write_string(fp, "device", config->audio_device);
     }
     ini_write_string(fp, "surround", serialize_audio_config(config->stream.audioConfiguration));
+    ini_write_int(fp, "latency_target", config->audio_latency_target);
 
     if (!config->fullscreen) {
         ini_write_section(fp, "window");
@@ -144,6 +155,8 @@ bool settings_save(app_settings_t *config) {
 
 void settings_clear(app_settings_t *config) {
     free_nullable(config->decoder);
+    free_nullable(config->sps_fixup);
+    free_nullable(config->record_dir);
     free_nullable(config->audio_backend);
     free_nullable(config->audio_device);
     free_nullable(config->language);
@@ -271,10 +284,28 @@ static int settings_parse(app_settings_t *config, const char *section, const cha
         config->syskey_capture = INI_IS_TRUE(value);
     } else if (INI_FULL_MATCH("video", "decoder")) {
         set_string(&config->decoder, value);
+    } else if (INI_FULL_MATCH("video", "max_frame_size")) {
+        set_int(&config->max_frame_size, value);
+        if (config->max_frame_size < 1) {
+            config->max_frame_size = 1;
+        } else if (config->max_frame_size > 64) {
+            config->max_frame_size = 64;
+        }
+    } else if (INI_FULL_MATCH("video", "sps_fixup")) {
+        set_string(&config->sps_fixup, value);
+    } else if (INI_FULL_MATCH("video", "record_dir")) {
+        set_string(&config->record_dir, value);
     } else if (INI_FULL_MATCH("audio", "backend")) {
         set_string(&config->audio_backend, value);
     } else if (INI_FULL_MATCH("audio", "device")) {
         set_string(&config->audio_device, value);
+    } else if (INI_FULL_MATCH("audio", "latency_target")) {
+        set_int(&config->audio_latency_target, value);
+        if (config->audio_latency_target < 0) {
+            config->audio_latency_target = 0;
+        } else if (config->audio_latency_target > 500) {
+            config->audio_latency_target = 500;
+        }
     } else if (INI_NAME_MATCH("language")) {
         set_string(&config->language, value);
     } else if (INI_NAME_MATCH("fullscreen")) {
@@ -285,6 +316,13 @@ static int settings_parse(app_settings_t *config, const char *section, const cha
 #endif
     } else if (INI_NAME_MATCH("debug_level")) {
         set_int(&config->debug_level, value);
+    } else if (INI_NAME_MATCH("cover_cache_size")) {
+        set_int(&config->cover_cache_size, value);
+        if (config->cover_cache_size < 0) {
+            config->cover_cache_size = 0;
+        } else if (config->cover_cache_size > 512) {
+            config->cover_cache_size = 512;
+        }
     } else if (INI_FULL_MATCH("window", "x")) {
         set_int(&config->window_state.x, value);
     } else if (INI_FULL_MATCH("window", "y")) {
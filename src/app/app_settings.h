@@ -31,8 +31,12 @@ typedef struct app_settings_t {
     STREAM_CONFIGURATION stream;
     int debug_level;
     char *decoder;
+    /* auto: use decoder module default, on: always rewrite SPS, off: never */
+    char *sps_fixup;
     char *audio_backend;
     char *audio_device;
+    /* Audio to keep queued in ms, 0 disables latency control */
+    int audio_latency_target;
     char *language;
     bool sops;
     bool localaudio;
@@ -51,6 +55,12 @@ typedef struct app_settings_t {
     bool hevc;
     bool av1;
     int stick_deadzone;
+    /* Largest frame in MB that can be submitted to decoders needing contiguous frames */
+    int max_frame_size;
+    /* Record decode units of each session into this directory, for moonlight-replay */
+    char *record_dir;
+    /* Memory for cover art textures in MB, 0 sizes it by system memory */
+    int cover_cache_size;
 
     char *conf_dir;
     char *ini_path;
@@ -3,29 +3,23 @@
 #include "app.h"
 #include "errors.h"
 #include "util/bus.h"
+#include "util/lane_executor.h"
 #include "lazy.h"
 #include "refcounter.h"
 
 #include <errno.h>
+#include <inttypes.h>
+#include <string.h>
 
-#define LINKEDLIST_IMPL
-
-#define LINKEDLIST_MODIFIER static
-#define LINKEDLIST_TYPE APP_LIST
-#define LINKEDLIST_PREFIX applist
-
-#include "linked_list.h"
 #include "logging.h"
 
-#undef LINKEDLIST_TYPE
-#undef LINKEDLIST_PREFIX
-
 struct apploader_task_ctx_t {
     int code;
-    const char *error;
+    /* Copied, message from gs_get_error() is only valid on the worker thread */
+    char *error;
     apploader_list_t *result;
     apploader_t *loader;
-    const executor_task_t *task;
+    lane_task_id_t task;
 };
 
 struct apploader_t {
@@ -34,9 +28,9 @@ struct apploader_t {
     uuidstr_t uuid;
     apploader_cb_t callback;
     lazy_t client;
-    executor_t *executor;
+    lane_executor_t *executor;
     apploader_state_t state;
-    const executor_task_t *task;
+    lane_task_id_t task;
     void *userdata;
 };
 
@@ -54,7 +48,7 @@ static int applist_name_comparator(apploader_item_t *p1, apploader_item_t *p2);
 
 static void task_callback(apploader_task_ctx_t *task);
 
-static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_LIST ll);
+static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_ARRAY apps);
 
 apploader_t *apploader_create(app_t *app, const uuidstr_t *uuid, const apploader_cb_t *cb, void *userdata) {
     apploader_t *loader = calloc(1, sizeof(apploader_t));
@@ -69,8 +63,8 @@ apploader_t *apploader_create(app_t *app, const uuidstr_t *uuid, const apploader
 }
 
 void apploader_load(apploader_t *loader) {
-    executor_task_state_t state = executor_task_state(loader->executor, loader->task);
-    if (state == EXECUTOR_TASK_STATE_PENDING || state == EXECUTOR_TASK_STATE_ACTIVE) {
+    lane_task_state_t state = lane_executor_task_state(loader->executor, loader->task);
+    if (state == LANE_TASK_STATE_PENDING || state == LANE_TASK_STATE_ACTIVE) {
         return;
     }
     if (loader->state == APPLOADER_STATE_LOADING) {
@@ -82,17 +76,17 @@ void apploader_load(apploader_t *loader) {
         loader->callback.start(loader->userdata);
     }
     apploader_task_ctx_t *ctx = task_create(loader);
-    const executor_task_t *task = executor_submit(loader->executor, (executor_action_cb) task_run,
-                                                  (executor_cleanup_cb) task_finalize, ctx);
-    commons_log_debug("AppLoader", "[loader %p] task start, task=%p", loader, task);
+    lane_task_id_t task = lane_executor_submit(loader->executor, EXECUTOR_LANE_NORMAL, (executor_action_cb) task_run,
+                                               (executor_cleanup_cb) task_finalize, ctx);
+    commons_log_debug("AppLoader", "[loader %p] task start, task=%" PRIu64, loader, task);
     ctx->task = task;
     loader->task = task;
 }
 
 void apploader_cancel(apploader_t *loader) {
-    commons_log_debug("AppLoader", "[loader %p] task cancel, task=%p", loader, loader->task);
-    executor_cancel(loader->executor, loader->task);
-    loader->task = NULL;
+    commons_log_debug("AppLoader", "[loader %p] task cancel, task=%" PRIu64, loader, loader->task);
+    lane_executor_cancel(loader->executor, loader->task);
+    loader->task = 0;
 }
 
 void apploader_destroy(apploader_t *loader) {
@@ -137,22 +131,21 @@ static int task_run(apploader_task_ctx_t *task) {
         ret = GS_ERROR;
         goto finish;
     }
-    PAPP_LIST ll = NULL;
+    PAPP_ARRAY apps = NULL;
     GS_CLIENT client = lazy_obtain(&task->loader->client);
-    if ((ret = gs_applist(client, node->server, &ll)) != GS_OK) {
+    if ((ret = gs_applist(client, node->server, sizeof(apploader_item_t), &apps)) != GS_OK) {
         gs_get_error(&error);
         goto finish;
     }
-    if (ll == NULL) {
+    if (apps->count == 0) {
+        free(apps);
         ret = GS_ERROR;
         goto finish;
     }
-    apploader_list_t *result = apps_create(node, ll);
-    applist_free(ll, (applist_nodefree_fn) free);
-    task->result = result;
+    task->result = apps_create(node, apps);
     finish:
     task->code = ret;
-    task->error = error;
+    task->error = error != NULL ? strdup(error) : NULL;
     return ret;
 }
 
@@ -166,12 +159,16 @@ static void task_finalize(apploader_task_ctx_t *task, int result) {
         return;
     }
     apploader_unref(task->loader);
+    free(task->error);
     free(task);
 }
 
 static void task_callback(apploader_task_ctx_t *task) {
     apploader_t *loader = task->loader;
     commons_log_debug("AppLoader", "[loader %p] task callback", loader);
+    if (loader->task == task->task) {
+        loader->task = 0;
+    }
     if (task->code == GS_OK) {
         loader->state = APPLOADER_STATE_IDLE;
         if (loader->callback.data != NULL) {
@@ -184,22 +181,20 @@ static void task_callback(apploader_task_ctx_t *task) {
         }
     }
     apploader_unref(loader);
+    free(task->error);
     free(task);
 }
 
-static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_LIST ll) {
-    int count = applist_len(ll);
-    apploader_list_t *result = malloc(sizeof(apploader_list_t) + count * sizeof(apploader_item_t));
-    result->count = count;
-    result->items = (apploader_item_t *) ((void *) result + sizeof(apploader_list_t));
-    int index = 0;
-    for (PAPP_LIST cur = ll; cur; cur = cur->next) {
-        apploader_item_t *item = &result->items[index];
-        memcpy(&item->base, cur, sizeof(APP_LIST));
-        item->base.next = NULL;
-        item->fav = pcmanager_node_is_app_favorite(node, cur->id);
-        item->hidden = pcmanager_node_is_app_hidden(node, cur->id);
-        index++;
+static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_ARRAY apps) {
+    apploader_list_t *result = malloc(sizeof(apploader_list_t));
+    result->count = apps->count;
+    result->items = apps->items;
+    result->apps = apps;
+    // Items are parsed in place with room for our extra fields, so there's nothing to copy
+    for (size_t i = 0; i < result->count; i++) {
+        apploader_item_t *item = &result->items[i];
+        item->fav = pcmanager_node_is_app_favorite(node, item->base.id);
+        item->hidden = pcmanager_node_is_app_hidden(node, item->base.id);
     }
     qsort(result->items, result->count, sizeof(apploader_item_t),
               (int (*)(const void *, const void *)) applist_name_comparator);
@@ -208,9 +203,7 @@ static apploader_list_t *apps_create(const struct pclist_t *node, PAPP_LIST ll)
 
 void apploader_list_free(apploader_list_t *list) {
     if (!list) { return; }
-    for (int i = 0; i < list->count; i++) {
-        free(list->items[i].base.name);
-    }
+    free(list->apps);
     free(list);
 }
 
@@ -22,6 +22,8 @@ typedef struct apploader_item_t {
 typedef struct apploader_list_t {
     size_t count;
     apploader_item_t *items;
+    /** Block holding items and their names, owned by the list */
+    PAPP_ARRAY apps;
 } apploader_list_t;
 
 typedef struct apploader_t apploader_t;
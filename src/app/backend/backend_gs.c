@@ -4,6 +4,7 @@
 #include "client.h"
 #include "errors.h"
 #include "app_error.h"
+#include "util/lane_executor.h"
 
 GS_CLIENT app_gs_client_new(app_t *app) {
     if (SDL_ThreadID() == app->main_thread_id) {
@@ -34,6 +35,10 @@ GS_CLIENT app_gs_client_new(app_t *app) {
                         "Details: %s", message);
         app_halt(app);
     }
+    if (client != NULL) {
+        // Requests of a cancelled task stop right away, instead of holding the worker until they time out
+        gs_set_cancel_token(client, (gs_cancel_token_fn) lane_executor_current_cancelled, app->backend.executor);
+    }
     SDL_UnlockMutex(app->backend.gs_client_mutex);
     return client;
 }
@@ -6,22 +6,35 @@
 #include <SDL2/SDL_stdinc.h>
 
 #include "app.h"
+#include "client.h"
 #include "executor.h"
+#include "util/lane_executor.h"
 
 pcmanager_t *pcmanager;
 
 
 void backend_init(app_backend_t *backend, app_t *app) {
     backend->app = app;
-    backend->executor = executor_create("moonlight-io", 2 * SDL_min(3, SDL_GetCPUCount()));
+    int workers = 2 * SDL_min(3, SDL_GetCPUCount());
+    // Normal tasks always leave a worker for interactive ones, background tasks leave half of them
+    const int limits[EXECUTOR_LANE_COUNT] = {
+            [EXECUTOR_LANE_INTERACTIVE] = 0,
+            [EXECUTOR_LANE_NORMAL] = SDL_max(1, workers - 1),
+            [EXECUTOR_LANE_BACKGROUND] = SDL_max(1, workers / 2),
+    };
+    backend->executor = lane_executor_create("moonlight-io", workers, limits);
+    backend->commons_executor = executor_create("moonlight-commons", 1);
     backend->gs_client_mutex = SDL_CreateMutex();
     pcmanager = pcmanager_new(app, backend->executor);
 }
 
 void backend_destroy(app_backend_t *backend) {
+    // Aborts status requests of discovered hosts, so pcmanager doesn't wait for them to time out
+    gs_async_shutdown();
     pcmanager_destroy(pcmanager);
     SDL_DestroyMutex(backend->gs_client_mutex);
-    executor_destroy(backend->executor);
+    lane_executor_destroy(backend->executor);
+    executor_destroy(backend->commons_executor);
 }
 
 bool backend_dispatch_userevent(app_backend_t *backend, int which, void *data1, void *data2) {
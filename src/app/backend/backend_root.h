@@ -5,10 +5,13 @@
 
 typedef struct app_t app_t;
 typedef struct executor_t executor_t;
+typedef struct lane_executor_t lane_executor_t;
 
 typedef struct app_backend_t {
     app_t *app;
-    executor_t *executor;
+    lane_executor_t *executor;
+    /* For commons modules, which only take their own executor type */
+    executor_t *commons_executor;
     SDL_mutex *gs_client_mutex;
 } app_backend_t;
 
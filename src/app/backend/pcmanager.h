@@ -12,7 +12,7 @@
 typedef struct app_t app_t;
 typedef struct pcmanager_t pcmanager_t;
 typedef struct worker_context_t worker_context_t;
-typedef struct executor_t executor_t;
+typedef struct lane_executor_t lane_executor_t;
 
 typedef void (*pcmanager_callback_t)(int result, const char *error, const uuidstr_t *uuid, void *userdata);
 
@@ -28,7 +28,7 @@ typedef struct pcmanager_listener_t {
  * @brief Initialize computer manager context
  * 
  */
-pcmanager_t *pcmanager_new(app_t *app, executor_t *executor);
+pcmanager_t *pcmanager_new(app_t *app, lane_executor_t *executor);
 
 /**
  * @brief Free all allocated memories, such as computer_list.
@@ -71,7 +71,7 @@ void pcmanager_auto_discovery_stop(pcmanager_t *manager) {
         return;
     }
     manager->discovery_task = NULL;
-    executor_submit(manager->executor, executor_noop, discovery_finalize, task);
+    lane_executor_submit(manager->executor, EXECUTOR_LANE_BACKGROUND, executor_noop, discovery_finalize, task);
     pcmanager_unlock(manager);
 }
 
@@ -132,7 +132,7 @@ static void resolve_callback(
     discovery_task_t *task = context;
     worker_context_t *ctx = worker_context_new(task->manager, NULL, NULL, NULL);
     ctx->arg1 = strdup(ip);
-    pcmanager_worker_queue(task->manager, worker_host_discovered, ctx);
+    pcmanager_worker_queue(task->manager, EXECUTOR_LANE_BACKGROUND, worker_host_discovered, ctx);
 }
 
 int discovery_worker(discovery_task_t *task) {
@@ -22,34 +22,70 @@
 
 #include "logging.h"
 
+typedef struct lan_status_request_t {
+    pcmanager_t *manager;
+    GS_CLIENT client;
+    sockaddr_t *addr;
+    char ip[64];
+} lan_status_request_t;
+
+static void lan_host_status_cb(int ret, SERVER_DATA *server, lan_status_request_t *req);
+
+static void lan_status_request_free(lan_status_request_t *req);
+
 static void lan_host_status_update(pcmanager_t *manager, SERVER_DATA *server);
 
 static void lan_host_offline(pcmanager_t *manager, const sockaddr_t *addr);
 
 void pcmanager_lan_host_discovered(const sockaddr_t *addr, pcmanager_t *manager) {
-    GS_CLIENT client = app_gs_client_new(manager->app);
+    lan_status_request_t *req = SDL_calloc(1, sizeof(lan_status_request_t));
+    req->manager = manager;
+    req->client = app_gs_client_new(manager->app);
+    req->addr = sockaddr_clone(addr);
+    sockaddr_get_ip_str(addr, req->ip, sizeof(req->ip));
     SERVER_DATA *server = serverdata_new();
-    char ip[64];
-    sockaddr_get_ip_str(addr, ip, sizeof(ip));
-    int ret = gs_get_status(client, server, strndup(ip, sizeof(ip)), sockaddr_get_port(addr),
-                            app_configuration->unsupported);
+    // Status is fetched on the shared HTTP thread, so hosts discovered in a burst are polled concurrently
+    SDL_LockMutex(manager->lan_lock);
+    manager->lan_requests++;
+    SDL_UnlockMutex(manager->lan_lock);
+    int ret = gs_get_status_async(req->client, server, strndup(req->ip, sizeof(req->ip)), sockaddr_get_port(addr),
+                                  app_configuration->unsupported, (gs_status_cb) lan_host_status_cb, req);
+    if (ret != GS_OK) {
+        lan_host_status_cb(ret, server, req);
+    }
+}
+
+static void lan_host_status_cb(int ret, SERVER_DATA *server, lan_status_request_t *req) {
+    pcmanager_t *manager = req->manager;
     if (ret == GS_OK) {
-        commons_log_info("PCManager", "Finished updating status from %s", ip);
+        commons_log_info("PCManager", "Finished updating status from %s", req->ip);
         lan_host_status_update(manager, server);
     } else {
         serverdata_free(server);
         const char *gs_error = NULL;
-        ret = gs_get_error(&gs_error);
-        if (ret == GS_IO_ERROR) {
-            commons_log_warn("PCManager", "Error while updating status from %s. Host seems to be offline", ip);
-            lan_host_offline(manager, addr);
+        gs_get_error(&gs_error);
+        if (ret == GS_CANCELLED) {
+            commons_log_debug("PCManager", "Cancelled updating status from %s", req->ip);
+        } else if (ret == GS_IO_ERROR) {
+            commons_log_warn("PCManager", "Error while updating status from %s. Host seems to be offline", req->ip);
+            lan_host_offline(manager, req->addr);
         } else {
-            commons_log_warn("PCManager", "Error while updating status from %s: %d (%s)", ip, ret, gs_error);
+            commons_log_warn("PCManager", "Error while updating status from %s: %d (%s)", req->ip, ret, gs_error);
         }
     }
-    gs_destroy(client);
+    lan_status_request_free(req);
+    SDL_LockMutex(manager->lan_lock);
+    if (--manager->lan_requests == 0) {
+        SDL_CondBroadcast(manager->lan_idle);
+    }
+    SDL_UnlockMutex(manager->lan_lock);
 }
 
+static void lan_status_request_free(lan_status_request_t *req) {
+    gs_destroy(req->client);
+    sockaddr_free(req->addr);
+    SDL_free(req);
+}
 
 void lan_host_status_update(pcmanager_t *manager, SERVER_DATA *server) {
     SERVER_STATE state = {.code = server->paired ? SERVER_STATE_AVAILABLE : SERVER_STATE_NOT_PAIRED};
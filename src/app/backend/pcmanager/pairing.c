@@ -24,7 +24,7 @@ bool pcmanager_pair(pcmanager_t *manager, const uuidstr_t *uuid, char *pin, pcma
     SDL_snprintf(pin, 5, "%04d", pin_num);
     worker_context_t *ctx = worker_context_new(manager, uuid, callback, userdata);
     ctx->arg1 = strdup(pin);
-    pcmanager_worker_queue(manager, worker_pairing, ctx);
+    pcmanager_worker_queue(manager, EXECUTOR_LANE_INTERACTIVE, worker_pairing, ctx);
     return true;
 }
 
@@ -34,7 +34,7 @@ bool pcmanager_manual_add(pcmanager_t *manager, hostport_t *host, pcmanager_call
     }
     worker_context_t *ctx = worker_context_new(manager, NULL, callback, userdata);
     ctx->arg1 = host;
-    pcmanager_worker_queue(manager, worker_add_by_host, ctx);
+    pcmanager_worker_queue(manager, EXECUTOR_LANE_INTERACTIVE, worker_add_by_host, ctx);
     return true;
 }
 
@@ -7,12 +7,14 @@
 #include "backend/pcmanager/worker/worker.h"
 #include "logging.h"
 
-pcmanager_t *pcmanager_new(app_t *app, executor_t *executor) {
+pcmanager_t *pcmanager_new(app_t *app, lane_executor_t *executor) {
     pcmanager_t *manager = SDL_calloc(1, sizeof(pcmanager_t));
     manager->app = app;
     manager->executor = executor;
     manager->thread_id = SDL_ThreadID();
     manager->lock = SDL_CreateMutex();
+    manager->lan_lock = SDL_CreateMutex();
+    manager->lan_idle = SDL_CreateCond();
     discovery_init(&manager->discovery, (discovery_callback) pcmanager_lan_host_discovered, manager);
     pcmanager_load_known_hosts(manager);
     return manager;
@@ -20,9 +22,16 @@ pcmanager_t *pcmanager_new(app_t *app, executor_t *executor) {
 
 void pcmanager_destroy(pcmanager_t *manager) {
     pcmanager_auto_discovery_stop(manager);
+    SDL_LockMutex(manager->lan_lock);
+    while (manager->lan_requests > 0) {
+        SDL_CondWait(manager->lan_idle, manager->lan_lock);
+    }
+    SDL_UnlockMutex(manager->lan_lock);
     pcmanager_save_known_hosts(manager);
     pclist_free(manager);
     discovery_deinit(&manager->discovery);
+    SDL_DestroyCond(manager->lan_idle);
+    SDL_DestroyMutex(manager->lan_lock);
     SDL_DestroyMutex(manager->lock);
     SDL_free(manager);
 }
@@ -49,7 +58,7 @@ bool pcmanager_quitapp(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_ca
         return false;
     }
     worker_context_t *ctx = worker_context_new(manager, uuid, callback, userdata);
-    pcmanager_worker_queue(manager, worker_quit_app, ctx);
+    pcmanager_worker_queue(manager, EXECUTOR_LANE_INTERACTIVE, worker_quit_app, ctx);
     return true;
 }
 
@@ -57,7 +66,7 @@ void pcmanager_request_update(pcmanager_t *manager, const uuidstr_t *uuid, pcman
                               void *userdata) {
     commons_log_info("PcManager", "Requesting update for %s", (const char *) uuid);
     worker_context_t *ctx = worker_context_new(manager, uuid, callback, userdata);
-    pcmanager_worker_queue(manager, worker_host_update, ctx);
+    pcmanager_worker_queue(manager, EXECUTOR_LANE_NORMAL, worker_host_update, ctx);
 }
 
 void pcmanager_favorite_app(pcmanager_t *manager, const uuidstr_t *uuid, int appid, bool favorite) {
@@ -133,7 +142,9 @@ int pcmanager_node_current_app(const pclist_t *node) {
 bool pcmanager_send_wol(pcmanager_t *manager, const uuidstr_t *uuid, pcmanager_callback_t callback,
                         void *userdata) {
     worker_context_t *ctx = worker_context_new(manager, uuid, callback, userdata);
-    pcmanager_worker_queue(manager, worker_wol, ctx);
+    // User is waiting for the host to wake up, so it can't queue behind covers. It polls the host for up to 15
+    // seconds though, which would hold the worker normal lane leaves free for pairing and launching
+    pcmanager_worker_queue(manager, EXECUTOR_LANE_NORMAL, worker_wol, ctx);
     return true;
 }
 
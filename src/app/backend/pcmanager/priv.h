@@ -2,7 +2,7 @@
 
 #include "../pcmanager.h"
 #include "discovery/discovery.h"
-#include "executor.h"
+#include "util/lane_executor.h"
 #include "uuidstr.h"
 #include <SDL.h>
 
@@ -26,11 +26,16 @@ typedef struct {
 struct pcmanager_t {
     app_t *app;
     SDL_threadID thread_id;
-    executor_t *executor;
+    lane_executor_t *executor;
     pclist_t *servers;
     SDL_mutex *lock;
     pcmanager_listener_list *listeners;
     discovery_t discovery;
+    /** Status requests of discovered hosts still in flight, guarded by lan_lock */
+    int lan_requests;
+    SDL_mutex *lan_lock;
+    /** Signaled when lan_requests drops to 0 */
+    SDL_cond *lan_idle;
 };
 
 void serverdata_free(PSERVER_DATA data);
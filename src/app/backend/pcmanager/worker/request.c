@@ -33,9 +33,10 @@ void worker_context_finalize(worker_context_t *context, int result) {
     free(context);
 }
 
-void pcmanager_worker_queue(pcmanager_t *manager, worker_action action, worker_context_t *context) {
-    executor_submit(manager->executor, (executor_action_cb) action,
-                    (executor_cleanup_cb) worker_context_finalize, context);
+void pcmanager_worker_queue(pcmanager_t *manager, executor_lane_t lane, worker_action action,
+                            worker_context_t *context) {
+    lane_executor_submit(manager->executor, lane, (executor_action_cb) action,
+                         (executor_cleanup_cb) worker_context_finalize, context);
 }
 
 static void worker_callback(worker_context_t *ctx) {
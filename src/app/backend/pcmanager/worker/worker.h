@@ -1,6 +1,7 @@
 #pragma once
 
 #include "backend/pcmanager.h"
+#include "util/lane_executor.h"
 
 typedef struct app_t app_t;
 typedef struct worker_context_t {
@@ -33,4 +34,5 @@ worker_context_t *worker_context_new(pcmanager_t *manager, const uuidstr_t *uuid
 
 void worker_context_finalize(worker_context_t *context, int result);
 
-void pcmanager_worker_queue(pcmanager_t *manager, worker_action action, worker_context_t *context);
\ No newline at end of file
+void pcmanager_worker_queue(pcmanager_t *manager, executor_lane_t lane, worker_action action,
+                            worker_context_t *context);
\ No newline at end of file
@@ -29,7 +29,7 @@ void app_input_init(app_input_t *input, app_t *app) {
 #if !SDL_VERSION_ATLEAST(2, 0, 10)
     SDL_GameControllerAddMappingsFromFile(app->settings.condb_path);
 #endif
-    app_input_init_gamepad_mapping(input, app->backend.executor, &app->settings);
+    app_input_init_gamepad_mapping(input, app->backend.commons_executor, &app->settings);
 }
 
 void app_input_deinit(app_input_t *input) {
@@ -1,18 +1,66 @@
 #include "app.h"
 #include "util/bus.h"
+#include "util/mpsc_queue.h"
+#include "util/latency_histogram.h"
 
 #include <SDL.h>
 #include <assert.h>
 
-typedef struct bus_blocking_action_t {
-    bus_actionfunc action;
-    void *data;
+#include "logging.h"
+
+typedef struct bus_latch_t {
+    struct bus_latch_t *next;
     SDL_mutex *mutex;
     SDL_cond *cond;
     bool done;
-} bus_action_sync_t;
+} bus_latch_t;
+
+typedef struct bus_action_t {
+    mpsc_node_t node;
+    bus_actionfunc action;
+    void *data;
+    /* Set for sync actions, which live on the caller's stack */
+    bus_latch_t *latch;
+    Uint64 enqueued_at;
+} bus_action_t;
 
-static void invoke_action_sync(bus_action_sync_t *sync);
+static mpsc_queue_t queue;
+/* Whether a wakeup event is already in the SDL queue */
+static SDL_atomic_t wakeup_pending;
+static SDL_SpinLock latch_pool_lock;
+static bus_latch_t *latch_pool;
+/* Only touched by the main thread */
+static latency_histogram_t queue_latency;
+static int queue_high_water;
+static uint32_t actions_dispatched;
+
+static void enqueue(bus_action_t *action);
+
+static void dispatch(bus_action_t *action);
+
+static bus_latch_t *latch_obtain();
+
+static void latch_recycle(bus_latch_t *latch);
+
+void app_bus_init() {
+    mpsc_queue_init(&queue);
+    SDL_AtomicSet(&wakeup_pending, 0);
+    latency_histogram_reset(&queue_latency);
+    queue_high_water = 0;
+    actions_dispatched = 0;
+}
+
+void app_bus_deinit() {
+    SDL_AtomicLock(&latch_pool_lock);
+    while (latch_pool != NULL) {
+        bus_latch_t *latch = latch_pool;
+        latch_pool = latch->next;
+        SDL_DestroyMutex(latch->mutex);
+        SDL_DestroyCond(latch->cond);
+        free(latch);
+    }
+    SDL_AtomicUnlock(&latch_pool_lock);
+}
 
 bool bus_pushevent(int which, void *data1, void *data2) {
     SDL_Event ev;
@@ -29,47 +77,127 @@ bool app_bus_post(app_t *app, bus_actionfunc action, void *data) {
     if (!app->running) {
         return false;
     }
-    return bus_pushevent(BUS_INT_EVENT_ACTION, action, data);
+    bus_action_t *item = malloc(sizeof(bus_action_t));
+    if (item == NULL) {
+        return false;
+    }
+    item->action = action;
+    item->data = data;
+    item->latch = NULL;
+    enqueue(item);
+    return true;
 }
 
 bool app_bus_post_sync(app_t *app, bus_actionfunc action, void *data) {
-    bus_action_sync_t sync = {
+    assert(action != NULL);
+    if (!app->running) {
+        return false;
+    }
+    if (SDL_ThreadID() == app->main_thread_id) {
+        // Waiting for the main loop on itself would never return
+        action(data);
+        return true;
+    }
+    bus_latch_t *latch = latch_obtain();
+    if (latch == NULL) {
+        return false;
+    }
+    bus_action_t item = {
             .action = action,
             .data = data,
-            .mutex = SDL_CreateMutex(),
-            .cond = SDL_CreateCond(),
-            .done = false,
+            .latch = latch,
     };
-    if (!app_bus_post(app, (bus_actionfunc) invoke_action_sync, &sync)) {
-        SDL_DestroyMutex(sync.mutex);
-        SDL_DestroyCond(sync.cond);
-        return false;
+    enqueue(&item);
+    SDL_LockMutex(latch->mutex);
+    while (!latch->done) {
+        SDL_CondWait(latch->cond, latch->mutex);
     }
-    SDL_LockMutex(sync.mutex);
-    while (!sync.done) {
-        SDL_CondWait(sync.cond, sync.mutex);
-    }
-    SDL_UnlockMutex(sync.mutex);
-    SDL_DestroyMutex(sync.mutex);
-    SDL_DestroyCond(sync.cond);
+    SDL_UnlockMutex(latch->mutex);
+    latch_recycle(latch);
     return true;
 }
 
+void app_bus_dispatch() {
+    // Clear before popping, so actions posted from now on will wake up the main loop again
+    SDL_AtomicSet(&wakeup_pending, 0);
+    int depth = mpsc_queue_depth(&queue);
+    if (depth > queue_high_water) {
+        queue_high_water = depth;
+    }
+    mpsc_node_t *node;
+    while ((node = mpsc_queue_pop(&queue)) != NULL) {
+        dispatch((bus_action_t *) node);
+    }
+}
+
 void app_bus_drain() {
     SDL_Event event;
     while (SDL_PeepEvents(&event, 1, SDL_GETEVENT, SDL_USEREVENT, SDL_USEREVENT) > 0) {
-        if (event.user.code != BUS_INT_EVENT_ACTION) {
-            continue;
+    }
+    app_bus_dispatch();
+}
+
+void app_bus_log_stats() {
+    if (actions_dispatched == 0) {
+        return;
+    }
+    commons_log_debug("Bus", "%u actions, queue depth max %d, latency avg %u us, p99 %u us, max %u us",
+                      actions_dispatched, queue_high_water, latency_histogram_average(&queue_latency),
+                      latency_histogram_percentile(&queue_latency, 99), queue_latency.max_us);
+    latency_histogram_reset(&queue_latency);
+    queue_high_water = 0;
+    actions_dispatched = 0;
+}
+
+static void enqueue(bus_action_t *action) {
+    action->enqueued_at = SDL_GetPerformanceCounter();
+    mpsc_queue_push(&queue, &action->node);
+    if (SDL_AtomicCAS(&wakeup_pending, 0, 1)) {
+        bus_pushevent(BUS_INT_EVENT_WAKEUP, NULL, NULL);
+    }
+}
+
+static void dispatch(bus_action_t *action) {
+    Uint64 elapsed = SDL_GetPerformanceCounter() - action->enqueued_at;
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    latency_histogram_record(&queue_latency, (uint32_t) (elapsed / freq * 1000000 + elapsed % freq * 1000000 / freq));
+    actions_dispatched++;
+    action->action(action->data);
+    bus_latch_t *latch = action->latch;
+    if (latch == NULL) {
+        free(action);
+        return;
+    }
+    // Caller owns the action, it may be gone as soon as the latch is released
+    SDL_LockMutex(latch->mutex);
+    latch->done = true;
+    SDL_CondSignal(latch->cond);
+    SDL_UnlockMutex(latch->mutex);
+}
+
+static bus_latch_t *latch_obtain() {
+    SDL_AtomicLock(&latch_pool_lock);
+    bus_latch_t *latch = latch_pool;
+    if (latch != NULL) {
+        latch_pool = latch->next;
+    }
+    SDL_AtomicUnlock(&latch_pool_lock);
+    if (latch == NULL) {
+        latch = calloc(1, sizeof(bus_latch_t));
+        if (latch == NULL) {
+            return NULL;
         }
-        bus_actionfunc actionfn = event.user.data1;
-        actionfn(event.user.data2);
+        latch->mutex = SDL_CreateMutex();
+        latch->cond = SDL_CreateCond();
     }
+    latch->next = NULL;
+    latch->done = false;
+    return latch;
 }
 
-static void invoke_action_sync(bus_action_sync_t *sync) {
-    SDL_LockMutex(sync->mutex);
-    sync->action(sync->data);
-    sync->done = true;
-    SDL_CondSignal(sync->cond);
-    SDL_UnlockMutex(sync->mutex);
-}
\ No newline at end of file
+static void latch_recycle(bus_latch_t *latch) {
+    SDL_AtomicLock(&latch_pool_lock);
+    latch->next = latch_pool;
+    latch_pool = latch;
+    SDL_AtomicUnlock(&latch_pool_lock);
+}
@@ -0,0 +1,138 @@
+#include "audio_jitter.h"
+
+#include <string.h>
+
+// Depth measured on each frame is noisy, smooth it over about 16 frames
+#define DEPTH_SMOOTHING 16.0
+// Drift is measured over windows of this length
+#define DRIFT_WINDOW_US 2000000
+// Don't correct within this fraction of the target, to avoid fighting jitter
+#define TARGET_TOLERANCE 4
+// At most 1 in 50 samples are dropped or repeated, which keeps pitch change hardly audible
+#define MAX_CORRECTION_RATIO 50
+// Frames beyond this multiple of the target are a backlog, not drift
+#define BACKLOG_FACTOR 2
+
+static int correction_samples(double distance, int samples);
+
+void audio_jitter_init(audio_jitter_t *jitter, int sample_rate, int target_ms, bool whole_frames) {
+    memset(jitter, 0, sizeof(audio_jitter_t));
+    jitter->sample_rate = sample_rate;
+    jitter->target_samples = sample_rate * target_ms / 1000;
+    jitter->whole_frames = whole_frames;
+}
+
+int audio_jitter_update(audio_jitter_t *jitter, uint64_t now_us, int samples, int *silence) {
+    *silence = 0;
+    if (jitter->window_start_us == 0) {
+        jitter->window_start_us = now_us;
+    }
+    uint64_t window_elapsed = now_us - jitter->window_start_us;
+    if (window_elapsed >= DRIFT_WINDOW_US) {
+        double expected = (double) window_elapsed * jitter->sample_rate / 1000000.0;
+        double drift = ((double) jitter->window_samples / expected - 1.0) * 1000000.0;
+        jitter->drift_ppm = jitter->drift_ppm == 0 ? drift : jitter->drift_ppm + (drift - jitter->drift_ppm) / 4;
+        jitter->window_start_us = now_us;
+        jitter->window_samples = 0;
+    }
+    jitter->window_samples += samples;
+
+    uint64_t played = (now_us - jitter->base_us) * (uint64_t) jitter->sample_rate / 1000000;
+    int64_t depth = (int64_t) jitter->fed_samples - (int64_t) played;
+    if (jitter->base_us == 0 || depth < 0) {
+        // Sink ran dry (or hasn't started), it restarts from an empty queue
+        if (jitter->base_us != 0) {
+            jitter->underruns++;
+        }
+        jitter->base_us = now_us;
+        jitter->fed_samples = 0;
+        jitter->drift_pending = 0;
+        depth = 0;
+        if (!jitter->whole_frames) {
+            *silence = jitter->target_samples;
+            jitter->fed_samples = *silence;
+            depth = *silence;
+        }
+        jitter->depth_avg = (double) depth;
+    }
+    jitter->depth_avg += ((double) depth - jitter->depth_avg) / DEPTH_SMOOTHING;
+
+    int target = jitter->target_samples;
+    int out = samples;
+    int tolerance = target / TARGET_TOLERANCE;
+    if (jitter->whole_frames && tolerance < samples) {
+        tolerance = samples;
+    }
+    if (depth > (int64_t) target * BACKLOG_FACTOR ||
+        (jitter->whole_frames && jitter->depth_avg > target + tolerance)) {
+        jitter->dropped_frames++;
+        // Average lags behind, account the drop right away so following frames aren't dropped for the same excess
+        jitter->depth_avg -= samples;
+        return 0;
+    } else if (jitter->whole_frames) {
+        // Nothing else can be done without decoding
+    } else if (jitter->depth_avg > target + tolerance) {
+        out = samples - correction_samples(jitter->depth_avg - target, samples);
+        jitter->dropped_samples += samples - out;
+    } else if (jitter->depth_avg < target - tolerance) {
+        out = samples + correction_samples(target - jitter->depth_avg, samples);
+        jitter->inserted_samples += out - samples;
+    } else if (jitter->drift_ppm != 0) {
+        // Cancel the measured drift as it accrues, so the depth stays put instead of walking to the tolerance edge
+        jitter->drift_pending += samples * jitter->drift_ppm / 1000000.0;
+        int max = samples / MAX_CORRECTION_RATIO > 0 ? samples / MAX_CORRECTION_RATIO : 1;
+        int correction = (int) jitter->drift_pending;
+        if (correction > max) {
+            correction = max;
+        } else if (correction < -max) {
+            correction = -max;
+        }
+        jitter->drift_pending -= correction;
+        out = samples - correction;
+        if (correction > 0) {
+            jitter->dropped_samples += correction;
+        } else {
+            jitter->inserted_samples += -correction;
+        }
+    }
+    jitter->fed_samples += out;
+    return out;
+}
+
+void audio_jitter_resize(int16_t *pcm, int channels, int in_samples, int out_samples) {
+    if (in_samples == out_samples || in_samples <= 0 || out_samples <= 0) {
+        return;
+    }
+    if (out_samples < in_samples) {
+        // Source index never falls behind destination index, so walk forward
+        for (int i = 0; i < out_samples; i++) {
+            int src = (int) ((int64_t) i * in_samples / out_samples);
+            memmove(&pcm[i * channels], &pcm[src * channels], channels * sizeof(int16_t));
+        }
+    } else {
+        // Source index never gets ahead of destination index, so walk backward
+        for (int i = out_samples - 1; i >= 0; i--) {
+            int src = (int) ((int64_t) i * in_samples / out_samples);
+            memmove(&pcm[i * channels], &pcm[src * channels], channels * sizeof(int16_t));
+        }
+    }
+}
+
+float audio_jitter_depth_ms(const audio_jitter_t *jitter) {
+    if (jitter->sample_rate <= 0) {
+        return 0;
+    }
+    return (float) (jitter->depth_avg * 1000.0 / jitter->sample_rate);
+}
+
+/**
+ * Close 1/8 of the distance to target per frame, but at least one sample and no more than the max ratio
+ */
+static int correction_samples(double distance, int samples) {
+    int max = samples / MAX_CORRECTION_RATIO > 0 ? samples / MAX_CORRECTION_RATIO : 1;
+    int correction = (int) (distance / 8);
+    if (correction < 1) {
+        return 1;
+    }
+    return correction < max ? correction : max;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Keeps the audio queued in the sink close to a latency target.
+ *
+ * The sink is assumed to play at the nominal sample rate on the local clock, so its queue depth is estimated from
+ * samples fed minus time elapsed. Host clock drift is measured from the arrival rate, and cancelled by dropping or
+ * duplicating samples at the same rate. Whatever that misses shows up as a slow change of depth, and is corrected
+ * the same way once it leaves the tolerance around the target. Bursts far above the target drop whole frames.
+ * When the queue runs dry, it's refilled to the target with silence, so jitter is absorbed from the start.
+ */
+typedef struct audio_jitter_t {
+    int sample_rate;
+    int target_samples;
+    /* Frames can only be dropped as a whole, e.g. when the sink decodes them */
+    bool whole_frames;
+    /* Time the sink queue was last known to be empty */
+    uint64_t base_us;
+    /* Samples fed since base_us */
+    uint64_t fed_samples;
+    /* Smoothed queue depth in samples */
+    double depth_avg;
+    /* Smoothed host clock drift against local clock, positive when host is faster */
+    double drift_ppm;
+    /* Drift correction not applied yet, in samples. Only whole samples can be dropped or duplicated */
+    double drift_pending;
+    uint64_t window_start_us;
+    uint64_t window_samples;
+    uint32_t dropped_frames;
+    uint32_t dropped_samples;
+    uint32_t inserted_samples;
+    uint32_t underruns;
+} audio_jitter_t;
+
+void audio_jitter_init(audio_jitter_t *jitter, int sample_rate, int target_ms, bool whole_frames);
+
+/**
+ * Decide how many samples of an incoming frame should be fed to the sink, and account them as fed.
+ * @param now_us Monotonic time in microseconds
+ * @param silence Samples of silence to feed before the frame, always 0 for whole frames mode
+ * @return 0 to drop the frame, fewer samples than the frame to drop some, more to duplicate some
+ */
+int audio_jitter_update(audio_jitter_t *jitter, uint64_t now_us, int samples, int *silence);
+
+/**
+ * Stretch or shrink interleaved PCM in place by evenly repeating or skipping samples.
+ * @param pcm Must have room for out_samples
+ */
+void audio_jitter_resize(int16_t *pcm, int channels, int in_samples, int out_samples);
+
+/**
+ * @return Current smoothed queue depth in milliseconds
+ */
+float audio_jitter_depth_ms(const audio_jitter_t *jitter);
@@ -0,0 +1,84 @@
+#include "audio_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Counters wrap around, so they're compared as unsigned
+#define RING_DISTANCE(head, tail) ((int) ((unsigned int) (head) - (unsigned int) (tail)))
+#define RING_ADVANCE(value, n) ((int) ((unsigned int) (value) + (unsigned int) (n)))
+
+bool audio_ring_init(audio_ring_t *ring, int capacity, int slot_size, audio_ring_overflow_t policy) {
+    memset(ring, 0, sizeof(audio_ring_t));
+    if (capacity <= 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    ring->slots = malloc((size_t) capacity * slot_size);
+    ring->lengths = calloc(capacity, sizeof(int));
+    if (ring->slots == NULL || ring->lengths == NULL) {
+        audio_ring_deinit(ring);
+        return false;
+    }
+    ring->capacity = capacity;
+    ring->slot_size = slot_size;
+    ring->policy = policy;
+    return true;
+}
+
+void audio_ring_deinit(audio_ring_t *ring) {
+    free(ring->slots);
+    free(ring->lengths);
+    ring->slots = NULL;
+    ring->lengths = NULL;
+}
+
+bool audio_ring_push(audio_ring_t *ring, const void *data, int length) {
+    if (length > ring->slot_size) {
+        SDL_AtomicIncRef(&ring->oversized);
+        return false;
+    }
+    int head = SDL_AtomicGet(&ring->head);
+    int depth = RING_DISTANCE(head, SDL_AtomicGet(&ring->tail));
+    if (depth >= ring->capacity) {
+        SDL_AtomicIncRef(&ring->overflows);
+        if (ring->policy == AUDIO_RING_DROP_OLDEST) {
+            SDL_AtomicSet(&ring->overflowed, 1);
+        }
+        return false;
+    }
+    int index = head & (ring->capacity - 1);
+    if (length > 0) {
+        memcpy(ring->slots + (size_t) index * ring->slot_size, data, length);
+    }
+    ring->lengths[index] = length;
+    // Publishes the slot, SDL atomics are full barriers
+    SDL_AtomicSet(&ring->head, RING_ADVANCE(head, 1));
+    if (depth + 1 > SDL_AtomicGet(&ring->high_water)) {
+        SDL_AtomicSet(&ring->high_water, depth + 1);
+    }
+    return true;
+}
+
+const unsigned char *audio_ring_peek(audio_ring_t *ring, int *length) {
+    int tail = SDL_AtomicGet(&ring->tail);
+    int head = SDL_AtomicGet(&ring->head);
+    if (SDL_AtomicSet(&ring->overflowed, 0) != 0 && RING_DISTANCE(head, tail) > ring->capacity / 2) {
+        int discard = RING_DISTANCE(head, tail) - ring->capacity / 2;
+        SDL_AtomicAdd(&ring->discarded, discard);
+        tail = RING_ADVANCE(tail, discard);
+        SDL_AtomicSet(&ring->tail, tail);
+    }
+    if (head == tail) {
+        return NULL;
+    }
+    int index = tail & (ring->capacity - 1);
+    *length = ring->lengths[index];
+    return ring->slots + (size_t) index * ring->slot_size;
+}
+
+void audio_ring_release(audio_ring_t *ring) {
+    SDL_AtomicSet(&ring->tail, RING_ADVANCE(SDL_AtomicGet(&ring->tail), 1));
+}
+
+int audio_ring_depth(audio_ring_t *ring) {
+    return RING_DISTANCE(SDL_AtomicGet(&ring->head), SDL_AtomicGet(&ring->tail));
+}
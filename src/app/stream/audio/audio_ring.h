@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL_atomic.h>
+
+/**
+ * Single producer, single consumer ring of fixed size packet slots. Slots are allocated once, so pushing and
+ * popping never allocates or locks.
+ */
+typedef enum audio_ring_overflow_t {
+    /* Packets arriving to a full ring are dropped */
+    AUDIO_RING_DROP_NEWEST,
+    /* Consumer drops the oldest half of the ring on its next pop after an overflow.
+     * Only the consumer moves the read index, so the packet arriving on overflow is still lost. */
+    AUDIO_RING_DROP_OLDEST,
+} audio_ring_overflow_t;
+
+typedef struct audio_ring_t {
+    unsigned char *slots;
+    int *lengths;
+    int capacity;
+    int slot_size;
+    audio_ring_overflow_t policy;
+    /* Total packets pushed, written by producer only */
+    SDL_atomic_t head;
+    /* Total packets popped or discarded, written by consumer only */
+    SDL_atomic_t tail;
+    SDL_atomic_t overflowed;
+    /* Metrics, updated by producer */
+    SDL_atomic_t high_water;
+    SDL_atomic_t overflows;
+    SDL_atomic_t oversized;
+    /* Updated by consumer */
+    SDL_atomic_t discarded;
+} audio_ring_t;
+
+/**
+ * @param capacity Must be a power of 2
+ */
+bool audio_ring_init(audio_ring_t *ring, int capacity, int slot_size, audio_ring_overflow_t policy);
+
+void audio_ring_deinit(audio_ring_t *ring);
+
+/**
+ * Called by producer. Copies the packet in a free slot. NULL data with 0 length is a valid packet.
+ * @return false if the packet was dropped
+ */
+bool audio_ring_push(audio_ring_t *ring, const void *data, int length);
+
+/**
+ * Called by consumer. The returned slot stays valid until audio_ring_release().
+ * @param length Packet length, 0 for packets pushed without data
+ * @return NULL if ring is empty
+ */
+const unsigned char *audio_ring_peek(audio_ring_t *ring, int *length);
+
+void audio_ring_release(audio_ring_t *ring);
+
+int audio_ring_depth(audio_ring_t *ring);
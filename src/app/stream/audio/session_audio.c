@@ -3,30 +3,66 @@
 
 #include <opus_multistream.h>
 
+#include "session_audio.h"
 #include "ss4s.h"
 #include "stream/connection/session_connection.h"
 #include "stream/session_priv.h"
+#include "audio_jitter.h"
+#include "audio_ring.h"
 #include "logging.h"
 
 #define SAMPLES_PER_FRAME  240
+// About 320 ms of 5 ms packets
+#define PACKET_RING_CAPACITY 64
+// Packets are bound by network MTU
+#define PACKET_MAX_SIZE 1500
 
 static session_t *session = NULL;
 static SS4S_Player *player = NULL;
 static OpusMSDecoder *decoder = NULL;
 static unsigned char *buffer = NULL;
-static int frame_size = 0, unit_size = 0;
+static unsigned char *silence_buffer = NULL;
+static int frame_size = 0, unit_size = 0, channel_count = 0;
+static bool latency_control = false;
+static audio_jitter_t jitter;
+static audio_ring_t ring;
+static SDL_sem *ring_sem = NULL;
+static SDL_Thread *playback_thread = NULL;
+static SDL_atomic_t playback_stopping;
 
 AUDIO_INFO audio_stream_info;
+/* Updated by the playback thread only */
+static AUDIO_STATS audio_summary_stats;
+/* Copy of audio_summary_stats for other threads, guarded by audio_snapshot_lock */
+static AUDIO_STATS audio_snapshot_stats;
+static SDL_SpinLock audio_snapshot_lock = 0;
 
 static size_t opus_head_serialize(const OPUS_MULTISTREAM_CONFIGURATION *config, unsigned char *data);
 
+static uint64_t aud_now_us();
+
+static void aud_stats_update();
+
+static int aud_playback_worker(void *arg);
+
+static void aud_play(const unsigned char *sampleData, int sampleLength);
+
+static void aud_cleanup();
+
 static int aud_init(int audioConfiguration, const POPUS_MULTISTREAM_CONFIGURATION opusConfig, void *context,
                     int arFlags) {
     (void) audioConfiguration;
     (void) arFlags;
     memset(&audio_stream_info, 0, sizeof(audio_stream_info));
+    memset(&audio_summary_stats, 0, sizeof(audio_summary_stats));
     session = context;
-    player = session->player;
+    // Only set once audio is opened, so cleanup knows whether to close it
+    player = NULL;
+    latency_control = session->config.audio_latency_target > 0;
+    audio_summary_stats.latencyTargetMs = session->config.audio_latency_target;
+    SDL_AtomicLock(&audio_snapshot_lock);
+    memcpy(&audio_snapshot_stats, &audio_summary_stats, sizeof(AUDIO_STATS));
+    SDL_AtomicUnlock(&audio_snapshot_lock);
     SS4S_AudioCodec codec = SS4S_AUDIO_PCM_S16LE;
     size_t codecDataLen = 0;
     SS4S_AudioInfo info = {
@@ -42,25 +78,80 @@ static int aud_init(int audioConfiguration, const POPUS_MULTISTREAM_CONFIGURATIO
         buffer = calloc(1024, sizeof(unsigned char));
         assert(buffer != NULL);
         codecDataLen = opus_head_serialize(opusConfig, buffer);
+        frame_size = opusConfig->samplesPerFrame;
     } else {
         int rc;
         decoder = opus_multistream_decoder_create(opusConfig->sampleRate, opusConfig->channelCount, opusConfig->streams,
                                                   opusConfig->coupledStreams, opusConfig->mapping, &rc);
         if (rc != 0) {
+            aud_cleanup();
             return rc;
         }
         frame_size = opusConfig->samplesPerFrame;
+        channel_count = opusConfig->channelCount;
         unit_size = (int) (opusConfig->channelCount * sizeof(int16_t));
-        buffer = calloc(unit_size, frame_size);
+        // Leave room for samples duplicated by latency control
+        buffer = calloc(unit_size, frame_size * 2);
+        if (session->config.audio_latency_target > 0) {
+            silence_buffer = calloc(unit_size, opusConfig->sampleRate * session->config.audio_latency_target / 1000);
+        }
     }
+    audio_jitter_init(&jitter, opusConfig->sampleRate, session->config.audio_latency_target, decoder == NULL);
     audio_stream_info.format = SS4S_AudioCodecName(codec);
     info.codec = codec;
     info.codecData = buffer;
     info.codecDataLen = codecDataLen;
-    return SS4S_PlayerAudioOpen(player, &info);
+    int ret = SS4S_PlayerAudioOpen(session->player, &info);
+    if (ret != 0) {
+        aud_cleanup();
+        return ret;
+    }
+    player = session->player;
+    // Decoding and sink writes happen on playback thread, so slow sinks don't hold up the receive thread
+    if (!audio_ring_init(&ring, PACKET_RING_CAPACITY, PACKET_MAX_SIZE, AUDIO_RING_DROP_OLDEST)) {
+        commons_log_error("Session", "Failed to allocate audio packet queue");
+        aud_cleanup();
+        return -1;
+    }
+    ring_sem = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&playback_stopping, 0);
+    if (ring_sem != NULL) {
+        playback_thread = SDL_CreateThread(aud_playback_worker, "audio", NULL);
+    }
+    if (playback_thread == NULL) {
+        commons_log_error("Session", "Failed to start audio playback thread: %s", SDL_GetError());
+        aud_cleanup();
+        return -1;
+    }
+    return 0;
 }
 
 static void aud_cleanup() {
+    if (playback_thread != NULL) {
+        SDL_AtomicSet(&playback_stopping, 1);
+        SDL_SemPost(ring_sem);
+        SDL_WaitThread(playback_thread, NULL);
+        playback_thread = NULL;
+    }
+    if (ring_sem != NULL) {
+        SDL_DestroySemaphore(ring_sem);
+        ring_sem = NULL;
+    }
+    // Stats are only worth logging if playback got to start
+    if (ring.slots != NULL && session != NULL) {
+        commons_log_info("Session", "Audio packet queue: high water %d of %d, %d overflows, %d discarded",
+                         SDL_AtomicGet(&ring.high_water), ring.capacity, SDL_AtomicGet(&ring.overflows),
+                         SDL_AtomicGet(&ring.discarded));
+        if (latency_control) {
+            commons_log_info("Session", "Audio latency control: %u frames concealed, %u frames dropped, "
+                                        "%u samples dropped, %u samples inserted, %u underruns, drift %.0f ppm",
+                             audio_summary_stats.concealedFrames, jitter.dropped_frames, jitter.dropped_samples,
+                             jitter.inserted_samples, jitter.underruns, jitter.drift_ppm);
+        }
+    }
+    if (ring.slots != NULL) {
+        audio_ring_deinit(&ring);
+    }
     if (player != NULL) {
         SS4S_PlayerAudioClose(player);
         player = NULL;
@@ -73,19 +164,101 @@ static void aud_cleanup() {
         free(buffer);
         buffer = NULL;
     }
+    if (silence_buffer != NULL) {
+        free(silence_buffer);
+        silence_buffer = NULL;
+    }
     session = NULL;
 }
 
 static void aud_feed(char *sampleData, int sampleLength) {
+    // Lost packets are queued too, they will be concealed in order
+    if (audio_ring_push(&ring, sampleData, sampleData != NULL ? sampleLength : 0)) {
+        SDL_SemPost(ring_sem);
+    }
+}
+
+static int aud_playback_worker(void *arg) {
+    (void) arg;
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+    while (SDL_SemWait(ring_sem) == 0 && !SDL_AtomicGet(&playback_stopping)) {
+        int length = 0;
+        const unsigned char *packet = audio_ring_peek(&ring, &length);
+        if (packet == NULL) {
+            // Semaphore is posted for packets discarded on overflow as well
+            continue;
+        }
+        aud_play(length > 0 ? packet : NULL, length);
+        audio_ring_release(&ring);
+        aud_stats_update();
+    }
+    return 0;
+}
+
+static void aud_play(const unsigned char *sampleData, int sampleLength) {
     if (decoder != NULL) {
-        int decode_len = opus_multistream_decode(decoder, (unsigned char *) sampleData, sampleLength,
+        // Lost packets come without data, which makes Opus conceal them
+        if (sampleData == NULL) {
+            audio_summary_stats.concealedFrames++;
+        }
+        int decode_len = opus_multistream_decode(decoder, sampleData, sampleLength,
                                                  (opus_int16 *) buffer, frame_size, 0);
+        if (decode_len <= 0) {
+            return;
+        }
+        if (latency_control) {
+            int silence = 0;
+            int out_len = audio_jitter_update(&jitter, aud_now_us(), decode_len, &silence);
+            if (silence > 0) {
+                SS4S_PlayerAudioFeed(player, silence_buffer, unit_size * silence);
+            }
+            if (out_len == 0) {
+                return;
+            }
+            audio_jitter_resize((int16_t *) buffer, channel_count, decode_len, out_len);
+            decode_len = out_len;
+        }
         SS4S_PlayerAudioFeed(player, buffer, unit_size * decode_len);
-    } else {
-        SS4S_PlayerAudioFeed(player, (unsigned char *) sampleData, sampleLength);
+    } else if (sampleData != NULL) {
+        // Sink decodes Opus itself, so only whole packets can be dropped
+        if (latency_control) {
+            int silence = 0;
+            int out_len = audio_jitter_update(&jitter, aud_now_us(), frame_size, &silence);
+            if (out_len == 0) {
+                return;
+            }
+        }
+        SS4S_PlayerAudioFeed(player, sampleData, sampleLength);
     }
 }
 
+static uint64_t aud_now_us() {
+    uint64_t counter = SDL_GetPerformanceCounter(), frequency = SDL_GetPerformanceFrequency();
+    // Multiplying the counter directly may overflow
+    return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
+static void aud_stats_update() {
+    audio_summary_stats.queueDepthMs = audio_jitter_depth_ms(&jitter);
+    audio_summary_stats.driftPpm = (float) jitter.drift_ppm;
+    audio_summary_stats.droppedFrames = jitter.dropped_frames;
+    audio_summary_stats.droppedSamples = jitter.dropped_samples;
+    audio_summary_stats.insertedSamples = jitter.inserted_samples;
+    audio_summary_stats.underruns = jitter.underruns;
+    audio_summary_stats.packetQueueDepth = audio_ring_depth(&ring);
+    audio_summary_stats.packetQueueHighWater = SDL_AtomicGet(&ring.high_water);
+    audio_summary_stats.packetQueueOverflows = SDL_AtomicGet(&ring.overflows) + SDL_AtomicGet(&ring.discarded);
+    SDL_AtomicLock(&audio_snapshot_lock);
+    memcpy(&audio_snapshot_stats, &audio_summary_stats, sizeof(AUDIO_STATS));
+    SDL_AtomicUnlock(&audio_snapshot_lock);
+}
+
+void audio_stats_snapshot(struct AUDIO_STATS *stats) {
+    SDL_AtomicLock(&audio_snapshot_lock);
+    memcpy(stats, &audio_snapshot_stats, sizeof(struct AUDIO_STATS));
+    SDL_AtomicUnlock(&audio_snapshot_lock);
+}
+
 static size_t opus_head_serialize(const OPUS_MULTISTREAM_CONFIGURATION *config, unsigned char *data) {
     unsigned char *ptr = data;
     // 1. Magic Signature:
@@ -19,5 +19,12 @@
 #pragma once
 #include "Limelight.h"
 
+struct AUDIO_STATS;
+
 extern AUDIO_RENDERER_CALLBACKS ss4s_aud_callbacks;
 
+/**
+ * Copy the latest audio stats. Safe to call from any thread while audio is playing.
+ */
+void audio_stats_snapshot(struct AUDIO_STATS *stats);
+
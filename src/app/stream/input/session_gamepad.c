@@ -4,8 +4,6 @@
 
 #include "stream/input/session_input.h"
 
-#include "util/bus.h"
-#include "util/user_event.h"
 #include "input/input_gamepad.h"
 #include "stream/session.h"
 #include "stream/input/session_virt_mouse.h"
@@ -28,6 +26,8 @@ static bool vmouse_intercepted(stream_input_t *input, const app_gamepad_state_t
 
 static bool filter_deadzone_2axis(stream_input_t *input, short *x, short *y);
 
+static void send_gamepad_state(stream_input_t *input, app_gamepad_state_t *gamepad);
+
 void stream_input_handle_cbutton(stream_input_t *input, const SDL_ControllerButtonEvent *event) {
     app_gamepad_state_t *gamepad = app_input_gamepad_state_by_instance_id(input->input, event->which);
     if (gamepad == NULL) {
@@ -119,7 +119,7 @@ void stream_input_handle_cbutton(stream_input_t *input, const SDL_ControllerButt
         if (quit_combo_pressed) {
             quit_combo_pressed = false;
             release_buttons(input, gamepad);
-            bus_pushevent(USER_OPEN_OVERLAY, NULL, NULL);
+            input->overlay_requested = true;
             return;
         } else if (vmouse_combo_pressed) {
             vmouse_combo_pressed = false;
@@ -132,6 +132,8 @@ void stream_input_handle_cbutton(stream_input_t *input, const SDL_ControllerButt
     if (input->view_only) {
         return;
     }
+    // Button edges go out right away, with pending axis changes merged in
+    input->gamepads_dirty &= ~(1 << gamepad->gs_id);
     LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons, gamepad->leftTrigger,
                                gamepad->rightTrigger, gamepad->leftStickX, gamepad->leftStickY, gamepad->rightStickX,
                                gamepad->rightStickY);
@@ -185,14 +187,27 @@ void stream_input_handle_caxis(stream_input_t *input, const SDL_ControllerAxisEv
     if (vmouse_intercepted(input, gamepad)) {
         vmouse_set_vector(&input->vmouse, gamepad->rightStickX, gamepad->rightStickY);
         vmouse_set_trigger(&input->vmouse, gamepad->leftTrigger, gamepad->rightTrigger);
-        LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons, 0, 0,
-                                   gamepad->leftStickX, gamepad->leftStickY, 0, 0);
-    } else {
-        LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons,
-                                   gamepad->leftTrigger,
-                                   gamepad->rightTrigger, gamepad->leftStickX, gamepad->leftStickY,
-                                   gamepad->rightStickX, gamepad->rightStickY);
     }
+    // Sent by stream_input_flush_gamepads() after all pending events are handled
+    uint32_t bit = 1 << gamepad->gs_id;
+    if (input->gamepads_dirty & bit) {
+        input->gamepad_packets_saved++;
+    }
+    input->gamepads_dirty |= bit;
+}
+
+void stream_input_flush_gamepads(stream_input_t *input) {
+    if (input->gamepads_dirty == 0) {
+        return;
+    }
+    for (int i = 0, j = app_input_get_max_gamepads(input->input); i < j; ++i) {
+        app_gamepad_state_t *gamepad = app_input_gamepad_state_by_index(input->input, i);
+        if (gamepad == NULL || (input->gamepads_dirty & (1 << gamepad->gs_id)) == 0) {
+            continue;
+        }
+        send_gamepad_state(input, gamepad);
+    }
+    input->gamepads_dirty = 0;
 }
 
 void stream_input_handle_csensor(stream_input_t *input, const SDL_ControllerSensorEvent *event) {
@@ -345,11 +360,25 @@ static void release_buttons(stream_input_t *input, app_gamepad_state_t *gamepad)
     gamepad->leftStickY = 0;
     gamepad->rightStickX = 0;
     gamepad->rightStickY = 0;
+    input->gamepads_dirty &= ~(1 << gamepad->gs_id);
     LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons, gamepad->leftTrigger,
                                gamepad->rightTrigger, gamepad->leftStickX, gamepad->leftStickY, gamepad->rightStickX,
                                gamepad->rightStickY);
 }
 
+static void send_gamepad_state(stream_input_t *input, app_gamepad_state_t *gamepad) {
+    if (vmouse_intercepted(input, gamepad)) {
+        // Right stick and triggers are driving virtual mouse
+        LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons, 0, 0,
+                                   gamepad->leftStickX, gamepad->leftStickY, 0, 0);
+    } else {
+        LiSendMultiControllerEvent(gamepad->gs_id, input->input->activeGamepadMask, gamepad->buttons,
+                                   gamepad->leftTrigger,
+                                   gamepad->rightTrigger, gamepad->leftStickX, gamepad->leftStickY,
+                                   gamepad->rightStickX, gamepad->rightStickY);
+    }
+}
+
 
 static bool gamepad_combo_check(int buttons, short combo) {
     return (buttons & combo) == combo;
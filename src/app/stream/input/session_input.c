@@ -20,11 +20,13 @@
 #include "stream/session.h"
 #include "stream/session_priv.h"
 #include "session_evmouse.h"
+#include "logging.h"
 
 void session_input_init(stream_input_t *input, session_t *session, app_input_t *app_input,
                         const session_config_t *config) {
     input->session = session;
     input->input = app_input;
+    input->lock = SDL_CreateMutex();
     input->view_only = config->view_only;
     input->stick_deadzone = config->stick_deadzone;
     input->no_sdl_mouse = config->hardware_mouse;
@@ -36,12 +38,15 @@ void session_input_init(stream_input_t *input, session_t *session, app_input_t *
 }
 
 void session_input_deinit(stream_input_t *input) {
+    session_pad_thread_stop(&input->pad_thread);
 #if FEATURE_INPUT_EVMOUSE
     const session_config_t *config = &input->session->config;
     if (!config->view_only && config->hardware_mouse) {
         session_evmouse_deinit(&input->evmouse);
     }
 #endif
+    SDL_DestroyMutex(input->lock);
+    input->lock = NULL;
 }
 
 void session_input_interrupt(stream_input_t *input) {
@@ -62,10 +67,14 @@ void session_input_started(stream_input_t *input) {
         }
         stream_input_send_gamepad_arrive(input, gamepad);
     }
+    session_pad_thread_start(&input->pad_thread, input->session);
 }
 
 void session_input_stopped(stream_input_t *input) {
+    session_pad_thread_stop(&input->pad_thread);
     input->started = false;
+    input->gamepads_dirty = 0;
+    commons_log_info("Input", "Gamepad axis packets saved by coalescing: %u", input->gamepad_packets_saved);
 }
 
 void session_input_screen_keyboard_opened(stream_input_t *input) {
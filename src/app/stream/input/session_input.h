@@ -4,9 +4,11 @@
 #include <Limelight.h>
 #include <SDL_events.h>
 #include <SDL_timer.h>
+#include <SDL_mutex.h>
 
 #include "config.h"
 #include "input/input_gamepad.h"
+#include "session_pad_thread.h"
 
 #if FEATURE_INPUT_EVMOUSE
 
@@ -32,9 +34,19 @@ typedef struct stream_input_t {
     session_t *session;
     app_input_t *input;
     bool started;
+    /* Serializes input handling between the main loop and the gamepad thread */
+    SDL_mutex *lock;
     bool view_only, no_sdl_mouse;
     uint8_t stick_deadzone;
+    /* Gamepads with axis changes not sent yet, by gs_id */
+    uint32_t gamepads_dirty;
+    /* Axis events merged into a later state packet */
+    uint32_t gamepad_packets_saved;
+    /* Overlay combo was pressed. Pushed to the event queue once the lock is released, as the main loop holds the
+     * queue lock while it takes ours */
+    bool overlay_requested;
     session_input_vmouse_t vmouse;
+    session_pad_thread_t pad_thread;
 #if FEATURE_INPUT_EVMOUSE
     session_evmouse_t evmouse;
 #endif
@@ -65,6 +77,11 @@ void stream_input_handle_cbutton(stream_input_t *input, const SDL_ControllerButt
 
 void stream_input_handle_caxis(stream_input_t *input, const SDL_ControllerAxisEvent *event);
 
+/**
+ * Send merged state of gamepads with axis changes. Called once per event pump cycle.
+ */
+void stream_input_flush_gamepads(stream_input_t *input);
+
 void stream_input_handle_csensor(stream_input_t *input, const SDL_ControllerSensorEvent *event);
 
 void stream_input_handle_ctouchpad(stream_input_t *input, const SDL_ControllerTouchpadEvent *event);
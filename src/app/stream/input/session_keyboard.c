@@ -6,8 +6,6 @@
 #include <Limelight.h>
 #include <SDL.h>
 
-#include "util/bus.h"
-#include "util/user_event.h"
 
 #include "vk.h"
 
@@ -102,7 +100,7 @@ void performPendingSpecialKeyCombo(stream_input_t *input) {
         case KeyComboToggleStatsOverlay:
             SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
                         "Detected stats toggle combo");
-            bus_pushevent(USER_OPEN_OVERLAY, NULL, NULL);
+            input->overlay_requested = true;
             break;
 
         case KeyComboToggleMouseMode:
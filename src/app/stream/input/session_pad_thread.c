@@ -0,0 +1,92 @@
+#include "session_pad_thread.h"
+#include "stream/session_priv.h"
+#include "stream/session_events.h"
+
+#include <SDL_events.h>
+#include <SDL_hints.h>
+#include <SDL_joystick.h>
+#include <SDL_timer.h>
+
+#include "logging.h"
+
+#define PAD_EVENTS_BATCH 64
+#define PAD_POLL_INTERVAL_MS 1
+
+static int pad_worker(session_pad_thread_t *pad);
+
+static int pad_take_events(SDL_Event *events, int max);
+
+bool session_pad_thread_start(session_pad_thread_t *pad, session_t *session) {
+#ifdef SDL_HINT_AUTO_UPDATE_JOYSTICKS
+    if (pad->thread != NULL) {
+        return true;
+    }
+    pad->session = session;
+    pad->events_handled = 0;
+    SDL_AtomicSet(&pad->running, 1);
+    // From now on only this thread updates gamepads, and SDL_PumpEvents in the main loop leaves them alone
+    SDL_SetHint(SDL_HINT_AUTO_UPDATE_JOYSTICKS, "0");
+    pad->thread = SDL_CreateThread((SDL_ThreadFunction) pad_worker, "sesspad", pad);
+    if (pad->thread == NULL) {
+        commons_log_warn("Input", "Failed to create gamepad thread: %s", SDL_GetError());
+        SDL_SetHint(SDL_HINT_AUTO_UPDATE_JOYSTICKS, "1");
+        SDL_AtomicSet(&pad->running, 0);
+        return false;
+    }
+    return true;
+#else
+    (void) pad;
+    (void) session;
+    commons_log_info("Input", "Gamepads will be polled by the event loop");
+    return false;
+#endif
+}
+
+void session_pad_thread_stop(session_pad_thread_t *pad) {
+    if (pad->thread == NULL) {
+        return;
+    }
+    SDL_AtomicSet(&pad->running, 0);
+    SDL_WaitThread(pad->thread, NULL);
+    pad->thread = NULL;
+#ifdef SDL_HINT_AUTO_UPDATE_JOYSTICKS
+    SDL_SetHint(SDL_HINT_AUTO_UPDATE_JOYSTICKS, "1");
+#endif
+    commons_log_info("Input", "Gamepad thread stopped, %u events handled", pad->events_handled);
+}
+
+bool session_pad_thread_running(const session_pad_thread_t *pad) {
+    return pad->thread != NULL;
+}
+
+static int pad_worker(session_pad_thread_t *pad) {
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+    commons_log_info("Input", "Gamepad thread started");
+    SDL_Event events[PAD_EVENTS_BATCH];
+    while (SDL_AtomicGet(&pad->running)) {
+        SDL_JoystickUpdate();
+        // While the overlay is shown, controller events are left in the queue for UI navigation
+        if (session_accepting_input(pad->session)) {
+            int count;
+            while ((count = pad_take_events(events, PAD_EVENTS_BATCH)) > 0) {
+                session_handle_input_events(pad->session, events, count);
+                pad->events_handled += count;
+            }
+        }
+        SDL_Delay(PAD_POLL_INTERVAL_MS);
+    }
+    return 0;
+}
+
+/**
+ * Take controller input events out of the SDL queue. Device added/removed events stay for the main loop.
+ */
+static int pad_take_events(SDL_Event *events, int max) {
+    int count = SDL_PeepEvents(events, max, SDL_GETEVENT, SDL_CONTROLLERAXISMOTION, SDL_CONTROLLERBUTTONUP);
+    if (count < 0) {
+        return count;
+    }
+    int more = SDL_PeepEvents(events + count, max - count, SDL_GETEVENT, SDL_CONTROLLERTOUCHPADDOWN,
+                              SDL_CONTROLLERSENSORUPDATE);
+    return more < 0 ? count : count + more;
+}
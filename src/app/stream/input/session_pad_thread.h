@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <SDL_atomic.h>
+#include <SDL_thread.h>
+
+typedef struct session_t session_t;
+
+/**
+ * Polls gamepads and sends their input on its own thread, so UI rendering in the main loop doesn't delay it.
+ */
+typedef struct session_pad_thread_t {
+    session_t *session;
+    SDL_Thread *thread;
+    SDL_atomic_t running;
+    /* Controller events handled by the thread */
+    uint32_t events_handled;
+} session_pad_thread_t;
+
+/**
+ * Start polling gamepads. Must be called from the main thread.
+ * @return false if this SDL version can't move gamepad polling off the event loop
+ */
+bool session_pad_thread_start(session_pad_thread_t *pad, session_t *session);
+
+void session_pad_thread_stop(session_pad_thread_t *pad);
+
+bool session_pad_thread_running(const session_pad_thread_t *pad);
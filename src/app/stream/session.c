@@ -17,6 +17,8 @@
 #include "app_session.h"
 #include "session_worker.h"
 #include "stream/input/session_virt_mouse.h"
+#include "stream/video/session_video.h"
+#include "util/nullable.h"
 
 // Expected luminance values in SEI are in units of 0.0001 cd/m2
 #define LUMINANCE_SCALE 10000
@@ -88,6 +90,7 @@ void session_destroy(session_t *session) {
     SDL_DestroyMutex(session->mutex);
     SDL_DestroyMutex(session->state_lock);
     free(session->app_name);
+    free_nullable(session->config.record_dir);
     free(session);
 }
 
@@ -263,6 +266,12 @@ void session_config_init(app_t *app, session_config_t *config, const SERVER_DATA
         config->stick_deadzone = (uint8_t) app_config->stick_deadzone;
     }
 
+    config->max_frame_size = (size_t) app_config->max_frame_size * 1024 * 1024;
+    config->audio_latency_target = app_config->audio_latency_target;
+    config->record_dir = str_null_or_empty(app_config->record_dir) ? NULL : strdup(app_config->record_dir);
+    config->sps_fixup = vdec_sps_fixup_flags(SS4S_ModuleInfoGetId(app->ss4s.selection.video_module),
+                                             app_config->sps_fixup);
+
     SS4S_VideoCapabilities video_cap = app->ss4s.video_cap;
     SS4S_AudioCapabilities audio_cap = app->ss4s.audio_cap;
 
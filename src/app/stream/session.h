@@ -3,6 +3,7 @@
 #include <stdbool.h>
 
 #include "backend/pcmanager.h"
+#include "util/latency_histogram.h"
 
 enum STREAMING_STATE {
     STREAMING_NONE,
@@ -29,6 +30,12 @@ typedef struct VIDEO_STATS {
     uint32_t receivedFrames;
     uint32_t networkDroppedFrames;
     uint32_t submittedFrames;
+    /* Frames copied into a contiguous buffer before submission */
+    uint32_t copiedFrames;
+    /* Frames larger than the decode buffer cap */
+    uint32_t oversizedFrames;
+    /* Frames not submitted to decoder, including oversized ones */
+    uint32_t droppedFrames;
     uint32_t totalReassemblyTime;
     uint32_t totalSubmitTime;
     unsigned long measurementStartTimestamp;
@@ -38,6 +45,10 @@ typedef struct VIDEO_STATS {
     float decodedFps;
     float avgDecoderLatency;
     uint32_t rtt, rttVariance;
+    /* Per frame distributions for this window */
+    latency_histogram_t captureLatency;
+    latency_histogram_t reassemblyTime;
+    latency_histogram_t submitTime;
 } VIDEO_STATS;
 
 typedef struct VIDEO_INFO {
@@ -52,6 +63,25 @@ typedef struct AUDIO_INFO {
     const char *format;
 } AUDIO_INFO;
 
+typedef struct AUDIO_STATS {
+    /* Estimated audio queued in the sink */
+    float queueDepthMs;
+    int latencyTargetMs;
+    /* Host clock against local clock, positive when host is faster */
+    float driftPpm;
+    /* Lost packets replaced by Opus packet loss concealment */
+    uint32_t concealedFrames;
+    uint32_t droppedFrames;
+    uint32_t droppedSamples;
+    uint32_t insertedSamples;
+    uint32_t underruns;
+    /* Packets waiting for playback thread */
+    int packetQueueDepth;
+    int packetQueueHighWater;
+    /* Packets dropped because playback thread fell behind */
+    int packetQueueOverflows;
+} AUDIO_STATS;
+
 typedef struct session_config_t {
     STREAM_CONFIGURATION stream;
     bool sops;
@@ -60,6 +90,14 @@ typedef struct session_config_t {
     bool hardware_mouse;
     bool vmouse;
     uint8_t stick_deadzone;
+    /* GS_SPS_* flags, 0 to submit SPS as is */
+    int sps_fixup;
+    /* Cap of the decode buffer in bytes */
+    size_t max_frame_size;
+    /* Audio queued in the sink to aim for, 0 to feed audio as it comes */
+    int audio_latency_target;
+    /* Directory to record decode units into, NULL to disable */
+    char *record_dir;
 } session_config_t;
 
 extern int streaming_errno;
@@ -1,12 +1,68 @@
 #include "session_events.h"
 #include "session_priv.h"
 
+#include "util/bus.h"
+#include "util/user_event.h"
+
+static bool handle_input_event(stream_input_t *input, const SDL_Event *event);
+
+static void unlock_input(stream_input_t *input);
 
 bool session_handle_input_event(session_t *session, const SDL_Event *event) {
     if (!session_accepting_input(session)) {
         return false;
     }
     stream_input_t *input = &session->input;
+    SDL_LockMutex(input->lock);
+    bool handled = handle_input_event(input, event);
+    unlock_input(input);
+    return handled;
+}
+
+void session_handle_input_events(session_t *session, const SDL_Event *events, int count) {
+    stream_input_t *input = &session->input;
+    SDL_LockMutex(input->lock);
+    for (int i = 0; i < count; i++) {
+        handle_input_event(input, &events[i]);
+    }
+    stream_input_flush_gamepads(input);
+    unlock_input(input);
+}
+
+void session_flush_input(session_t *session) {
+    if (!session_accepting_input(session)) {
+        return;
+    }
+    SDL_LockMutex(session->input.lock);
+    stream_input_flush_gamepads(&session->input);
+    SDL_UnlockMutex(session->input.lock);
+}
+
+bool session_gamepads_threaded(session_t *session) {
+    return session_pad_thread_running(&session->input.pad_thread) && session_accepting_input(session);
+}
+
+void session_lock_input(session_t *session) {
+    SDL_LockMutex(session->input.lock);
+}
+
+void session_unlock_input(session_t *session) {
+    SDL_UnlockMutex(session->input.lock);
+}
+
+/**
+ * Release the input lock, then push events requested while handling input
+ */
+static void unlock_input(stream_input_t *input) {
+    bool open_overlay = input->overlay_requested;
+    input->overlay_requested = false;
+    SDL_UnlockMutex(input->lock);
+    if (open_overlay) {
+        bus_pushevent(USER_OPEN_OVERLAY, NULL, NULL);
+    }
+}
+
+static bool handle_input_event(stream_input_t *input, const SDL_Event *event) {
     switch (event->type) {
         case SDL_KEYDOWN:
         case SDL_KEYUP: {
@@ -6,3 +6,25 @@
 typedef struct session_t session_t;
 
 bool session_handle_input_event(session_t *session, const SDL_Event *event);
+
+/**
+ * Handle a batch of input events and send merged gamepad state. Used by the gamepad thread.
+ */
+void session_handle_input_events(session_t *session, const SDL_Event *events, int count);
+
+/**
+ * @return Whether controller input events belong to the gamepad thread, and must be left in the queue for it
+ */
+bool session_gamepads_threaded(session_t *session);
+
+/**
+ * Send input merged while handling events of this cycle
+ */
+void session_flush_input(session_t *session);
+
+/**
+ * Hold off input handling on other threads, e.g. while a gamepad is being removed
+ */
+void session_lock_input(session_t *session);
+
+void session_unlock_input(session_t *session);
@@ -9,6 +9,10 @@
 #include "stream/session.h"
 #include "embed_wrapper.h"
 
+#if FEATURE_SPS_FIXUP
+#include "sps.h"
+#endif
+
 typedef struct app_t app_t;
 
 struct session_t {
@@ -37,6 +41,9 @@ struct session_t {
     SDL_mutex *mutex;
     SDL_Thread *thread;
     SS4S_Player *player;
+#if FEATURE_SPS_FIXUP
+    GS_SPS_FIXER sps_fixer;
+#endif
 };
 
 void session_set_state(session_t *session, STREAMING_STATE state);
@@ -5,9 +5,11 @@
 #include "stream/session.h"
 
 #include "sps_parser.h"
+#include "vdec_recorder.h"
 
 #include "ui/streaming/streaming.controller.h"
 #include "util/bus.h"
+#include "util/path.h"
 #include "logging.h"
 #include "ss4s.h"
 #include "stream/connection/session_connection.h"
@@ -16,17 +18,38 @@
 
 #include <SDL.h>
 #include <assert.h>
+#include <string.h>
+#include <time.h>
 
-// 2MB decode size should be fairly enough for everything
-#define DECODER_BUFFER_SIZE (2048 * 1024)
+#if !SDL_VERSION_ATLEAST(2, 0, 10)
+#define SDL_SIMDAlloc SDL_malloc
+#define SDL_SIMDFree SDL_free
+#endif
+
+// Most frames fit in 1MB, the buffer grows up to max_frame_size for larger IDR frames
+#define DECODER_BUFFER_INITIAL_SIZE (1024 * 1024)
+// Parameter sets are tiny, this leaves plenty of room for a rewritten one
+#define PARAM_SET_BUFFER_SIZE 1024
 
 static session_t *session = NULL;
 static SS4S_Player *player = NULL;
+/* Kept across sessions, so the grown buffer is reused */
 static unsigned char *buffer = NULL;
+static size_t buffer_capacity = 0;
+static uint32_t vdec_session_copied = 0, vdec_session_oversized = 0, vdec_session_dropped = 0;
+static unsigned char param_set_buffer[PARAM_SET_BUFFER_SIZE];
+static bool vdec_scatter_gather = false;
+static vdec_recorder_t *vdec_recorder = NULL;
 static int lastFrameNumber;
 static struct VIDEO_STATS vdec_temp_stats;
 static int vdec_stream_format = 0;
-VIDEO_STATS vdec_summary_stats;
+/* Whole session distributions, logged at cleanup */
+static latency_histogram_t vdec_session_capture, vdec_session_reassembly, vdec_session_submit;
+/* Decoder latency is sampled once per stats window */
+static latency_histogram_t vdec_session_decoder;
+/* Last complete stats window, copied out by the UI thread under vdec_summary_lock */
+static VIDEO_STATS vdec_summary_stats;
+static SDL_SpinLock vdec_summary_lock = 0;
 VIDEO_INFO vdec_stream_info;
 
 static int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate, void *context, int drFlags);
@@ -39,6 +62,47 @@ static void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now);
 
 static void stream_info_parse_size(PDECODE_UNIT decodeUnit, struct VIDEO_INFO *info);
 
+static SS4S_VideoFeedResult vdec_feed_entries(PDECODE_UNIT decodeUnit, SS4S_VideoFeedFlags frameFlags);
+
+static SS4S_VideoFeedResult vdec_feed_copy(PDECODE_UNIT decodeUnit, SS4S_VideoFeedFlags frameFlags);
+
+static bool vdec_buffer_reserve(size_t size);
+
+static void vdec_log_histogram(const char *name, const latency_histogram_t *histogram);
+
+static vdec_recorder_t *vdec_recorder_create(const char *dir, const vdec_recording_info_t *info);
+
+static size_t vdec_rewrite_entry(const LENTRY *entry, unsigned char *dest, size_t capacity, bool keyframe);
+
+/**
+ * Decoder modules that accept a frame fed in multiple parts, delimited by FRAME_START and FRAME_END flags.
+ * Other modules get contiguous frames, which costs a copy for frames with more than one buffer.
+ *
+ * The hardware modules (ndl, lgnc, smp, mmal, steamlink) and ffmpeg hand every feed call to the decoder as a whole
+ * access unit, so they can't be listed until they assemble parts themselves. They still skip the copy for single
+ * buffer frames, which covers most P-frames.
+ */
+static const char *const scatter_gather_modules[] = {
+        "dummy",
+        NULL,
+};
+
+#if FEATURE_SPS_FIXUP
+typedef struct sps_fixup_module_t {
+    const char *module;
+    int flags;
+} sps_fixup_module_t;
+
+/**
+ * Decoders known to buffer less with a rewritten SPS. Modules not listed here keep the host SPS by default.
+ */
+static const sps_fixup_module_t sps_fixup_modules[] = {
+        {"mmal", GS_SPS_BITSTREAM_FIXUP},
+        {"ffmpeg", GS_SPS_BITSTREAM_FIXUP},
+        {NULL, 0},
+};
+#endif
+
 DECODER_RENDERER_CALLBACKS ss4s_dec_callbacks = {
         .setup = vdec_delegate_setup,
         .cleanup = vdec_delegate_cleanup,
@@ -68,12 +132,32 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
     (void) drFlags;
     session = context;
     player = session->player;
-    buffer = malloc(DECODER_BUFFER_SIZE);
+    if (buffer_capacity > session->config.max_frame_size) {
+        SDL_SIMDFree(buffer);
+        buffer = NULL;
+        buffer_capacity = 0;
+    }
     memset(&vdec_temp_stats, 0, sizeof(vdec_temp_stats));
     memset(&vdec_stream_info, 0, sizeof(vdec_stream_info));
     vdec_stream_format = videoFormat;
     vdec_stream_info.format = video_format_name(videoFormat);
     lastFrameNumber = 0;
+    latency_histogram_reset(&vdec_session_capture);
+    latency_histogram_reset(&vdec_session_reassembly);
+    latency_histogram_reset(&vdec_session_submit);
+    latency_histogram_reset(&vdec_session_decoder);
+    vdec_session_copied = vdec_session_oversized = vdec_session_dropped = 0;
+    vdec_scatter_gather = false;
+    const char *module = SS4S_ModuleInfoGetId(session->app->ss4s.selection.video_module);
+    for (const char *const *item = scatter_gather_modules; module != NULL && *item != NULL; item++) {
+        if (strcmp(*item, module) == 0) {
+            vdec_scatter_gather = true;
+            break;
+        }
+    }
+#if FEATURE_SPS_FIXUP
+    session->sps_fixer = NULL;
+#endif
     SS4S_VideoInfo info = {
             .width = width,
             .height = height,
@@ -105,6 +189,24 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
 
     switch (SS4S_PlayerVideoOpen(player, &info)) {
         case SS4S_VIDEO_OPEN_OK: {
+            // Cleanup isn't called if setup fails, so only allocate once nothing can fail anymore
+#if FEATURE_SPS_FIXUP
+            if (session->config.sps_fixup) {
+                session->sps_fixer = gs_sps_fixer_new(videoFormat, width, height, session->config.sps_fixup);
+                commons_log_info("Session", "SPS fixup %s (flags 0x%x)",
+                                 session->sps_fixer != NULL ? "enabled" : "not supported for this format",
+                                 session->config.sps_fixup);
+            }
+#endif
+            if (session->config.record_dir != NULL) {
+                vdec_recording_info_t recording_info = {
+                        .video_format = videoFormat,
+                        .width = width,
+                        .height = height,
+                        .redraw_rate = redrawRate,
+                };
+                vdec_recorder = vdec_recorder_create(session->config.record_dir, &recording_info);
+            }
             return 0;
         }
         case SS4S_VIDEO_OPEN_UNSUPPORTED_CODEC:
@@ -116,15 +218,37 @@ int vdec_delegate_setup(int videoFormat, int width, int height, int redrawRate,
 
 void vdec_delegate_cleanup() {
     assert(player != NULL);
-    free(buffer);
+    // Fold in the last, partial window
+    latency_histogram_merge(&vdec_session_capture, &vdec_temp_stats.captureLatency);
+    latency_histogram_merge(&vdec_session_reassembly, &vdec_temp_stats.reassemblyTime);
+    latency_histogram_merge(&vdec_session_submit, &vdec_temp_stats.submitTime);
+    vdec_log_histogram("Host processing latency", &vdec_session_capture);
+    vdec_log_histogram("Reassembly time", &vdec_session_reassembly);
+    vdec_log_histogram("Submit time", &vdec_session_submit);
+    if (vdec_session_decoder.count > 0) {
+        // Compare sessions with and without SPS fixup to see its effect on decoder buffering
+        commons_log_info("Session", "SPS fixup %s", session->config.sps_fixup ? "on" : "off");
+        vdec_log_histogram("Decoder latency", &vdec_session_decoder);
+    }
+    commons_log_info("Session", "Video frames copied: %u, oversized: %u, dropped: %u", vdec_session_copied,
+                     vdec_session_oversized, vdec_session_dropped);
+    if (vdec_recorder != NULL) {
+        if (!vdec_recorder_close(vdec_recorder)) {
+            commons_log_warn("Session", "Video recording is incomplete");
+        }
+        vdec_recorder = NULL;
+    }
+#if FEATURE_SPS_FIXUP
+    if (session->sps_fixer != NULL) {
+        gs_sps_fixer_free(session->sps_fixer);
+        session->sps_fixer = NULL;
+    }
+#endif
     SS4S_PlayerVideoClose(player);
     session = NULL;
 }
 
 int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
-    if (decodeUnit->fullLength > DECODER_BUFFER_SIZE) {
-        return 0;
-    }
     unsigned long ticksms = SDL_GetTicks();
     if (lastFrameNumber <= 0) {
         vdec_temp_stats.measurementStartTimestamp = ticksms;
@@ -139,6 +263,10 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
     if (ticksms - vdec_temp_stats.measurementStartTimestamp > 1000) {
         vdec_stat_submit(&vdec_temp_stats, ticksms);
 
+        latency_histogram_merge(&vdec_session_capture, &vdec_temp_stats.captureLatency);
+        latency_histogram_merge(&vdec_session_reassembly, &vdec_temp_stats.reassemblyTime);
+        latency_histogram_merge(&vdec_session_submit, &vdec_temp_stats.submitTime);
+
         // Move this window into the last window slot and clear it for next window
         memset(&vdec_temp_stats, 0, sizeof(vdec_temp_stats));
         vdec_temp_stats.measurementStartTimestamp = ticksms;
@@ -147,27 +275,62 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
     vdec_temp_stats.receivedFrames++;
     vdec_temp_stats.totalFrames++;
 
+    if (vdec_recorder != NULL && !vdec_recorder_write(vdec_recorder, decodeUnit)) {
+        commons_log_error("Session", "Failed to record frame %d, recording stopped", decodeUnit->frameNumber);
+        vdec_recorder_close(vdec_recorder);
+        vdec_recorder = NULL;
+    }
+
+    uint32_t reassemblyTime = decodeUnit->enqueueTimeMs - decodeUnit->receiveTimeMs;
     vdec_temp_stats.totalCaptureLatency += decodeUnit->frameHostProcessingLatency;
-    vdec_temp_stats.totalReassemblyTime += decodeUnit->enqueueTimeMs - decodeUnit->receiveTimeMs;
-    vdec_stream_info.has_host_latency |= decodeUnit->frameHostProcessingLatency > 0;
-    size_t length = 0;
-    for (PLENTRY entry = decodeUnit->bufferList; entry != NULL; entry = entry->next) {
-        memcpy(buffer + length, entry->data, entry->length);
-        length += entry->length;
+    vdec_temp_stats.totalReassemblyTime += reassemblyTime;
+    latency_histogram_record(&vdec_temp_stats.reassemblyTime, reassemblyTime * 1000);
+    if (decodeUnit->frameHostProcessingLatency > 0) {
+        // Host processing latency is in units of 0.1 ms
+        latency_histogram_record(&vdec_temp_stats.captureLatency, decodeUnit->frameHostProcessingLatency * 100);
     }
-    SS4S_VideoFeedFlags flags = SS4S_VIDEO_FEED_DATA_FRAME_START | SS4S_VIDEO_FEED_DATA_FRAME_END;
+    vdec_stream_info.has_host_latency |= decodeUnit->frameHostProcessingLatency > 0;
+    SS4S_VideoFeedFlags flags = 0;
     if (decodeUnit->frameType == FRAME_TYPE_IDR) {
         flags |= SS4S_VIDEO_FEED_DATA_KEYFRAME;
     }
-    SS4S_VideoFeedResult result = SS4S_PlayerVideoFeed(player, buffer, length, flags);
+    // Limit applies to every frame, whether it's copied or not. Copies need room for a rewritten parameter set.
+    size_t required = decodeUnit->fullLength + PARAM_SET_BUFFER_SIZE;
+    if (required > session->config.max_frame_size) {
+        commons_log_warn("Session", "Frame %d is too large (%d bytes), requesting IDR frame",
+                         decodeUnit->frameNumber, decodeUnit->fullLength);
+        vdec_temp_stats.oversizedFrames++;
+        vdec_temp_stats.droppedFrames++;
+        vdec_session_oversized++;
+        vdec_session_dropped++;
+        return DR_NEED_IDR;
+    }
+    SS4S_VideoFeedResult result;
+    // Parameter sets only come with IDR frames, so single buffer frames can always be passed through
+    if (vdec_scatter_gather || decodeUnit->bufferList->next == NULL) {
+        result = vdec_feed_entries(decodeUnit, flags);
+    } else {
+        if (!vdec_buffer_reserve(required)) {
+            vdec_temp_stats.droppedFrames++;
+            vdec_session_dropped++;
+            return DR_NEED_IDR;
+        }
+        result = vdec_feed_copy(decodeUnit, flags);
+        vdec_temp_stats.copiedFrames++;
+        vdec_session_copied++;
+    }
     if (result == SS4S_VIDEO_FEED_OK) {
         if (vdec_stream_info.width == 0 || vdec_stream_info.height == 0) {
             stream_info_parse_size(decodeUnit, &vdec_stream_info);
         }
-        vdec_temp_stats.totalSubmitTime += LiGetMillis() - decodeUnit->enqueueTimeMs;
+        uint32_t submitTime = LiGetMillis() - decodeUnit->enqueueTimeMs;
+        vdec_temp_stats.totalSubmitTime += submitTime;
+        latency_histogram_record(&vdec_temp_stats.submitTime, submitTime * 1000);
         vdec_temp_stats.submittedFrames++;
         return DR_OK;
     } else if (result == SS4S_VIDEO_FEED_REQUEST_KEYFRAME) {
+        vdec_temp_stats.droppedFrames++;
+        vdec_session_dropped++;
         return DR_NEED_IDR;
     } else {
         commons_log_error("Session", "Video feed error %d", result);
@@ -176,8 +339,16 @@ int vdec_delegate_submit(PDECODE_UNIT decodeUnit) {
     }
 }
 
+void vdec_stats_snapshot(struct VIDEO_STATS *stats) {
+    SDL_AtomicLock(&vdec_summary_lock);
+    memcpy(stats, &vdec_summary_stats, sizeof(struct VIDEO_STATS));
+    SDL_AtomicUnlock(&vdec_summary_lock);
+}
+
 void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now) {
-    struct VIDEO_STATS *dst = &vdec_summary_stats;
+    // Filled in locally, so the lock is only held for the copy
+    struct VIDEO_STATS summary;
+    struct VIDEO_STATS *dst = &summary;
     memcpy(dst, src, sizeof(struct VIDEO_STATS));
     unsigned long delta = now - dst->measurementStartTimestamp;
     if (delta <= 0) { return; }
@@ -185,16 +356,20 @@ void vdec_stat_submit(const struct VIDEO_STATS *src, unsigned long now) {
     dst->receivedFps = (float) dst->receivedFrames / ((float) delta / 1000);
     dst->decodedFps = (float) dst->submittedFrames / ((float) delta / 1000);
     LiGetEstimatedRttInfo(&dst->rtt, &dst->rttVariance);
-    if (!streaming_stats_shown()) {
-        return;
-    }
     int latencyUs = 0;
     if (SS4S_PlayerGetVideoLatency(player, 0, &latencyUs)) {
         dst->avgDecoderLatency = (float) latencyUs / 1000.0f;
         vdec_stream_info.has_decoder_latency = true;
+        latency_histogram_record(&vdec_session_decoder, latencyUs > 0 ? latencyUs : 0);
     } else {
         dst->avgDecoderLatency = 0;
     }
+    SDL_AtomicLock(&vdec_summary_lock);
+    memcpy(&vdec_summary_stats, dst, sizeof(struct VIDEO_STATS));
+    SDL_AtomicUnlock(&vdec_summary_lock);
+    if (!streaming_stats_shown()) {
+        return;
+    }
     app_bus_post(session->app, (bus_actionfunc) streaming_refresh_stats, NULL);
 }
 
@@ -215,4 +390,131 @@ void stream_info_parse_size(PDECODE_UNIT decodeUnit, struct VIDEO_INFO *info) {
         info->height = dimension.height;
         return;
     }
-}
\ No newline at end of file
+}
+
+int vdec_sps_fixup_flags(const char *module, const char *setting) {
+#if FEATURE_SPS_FIXUP
+    if (setting != NULL && strcmp(setting, "off") == 0) {
+        return 0;
+    } else if (setting != NULL && strcmp(setting, "on") == 0) {
+        return GS_SPS_BITSTREAM_FIXUP;
+    }
+    if (module == NULL) {
+        return 0;
+    }
+    for (const sps_fixup_module_t *item = sps_fixup_modules; item->module != NULL; item++) {
+        if (strcmp(item->module, module) == 0) {
+            return item->flags;
+        }
+    }
+#else
+    (void) module;
+    (void) setting;
+#endif
+    return 0;
+}
+
+static SS4S_VideoFeedResult vdec_feed_entries(PDECODE_UNIT decodeUnit, SS4S_VideoFeedFlags frameFlags) {
+    bool keyframe = decodeUnit->frameType == FRAME_TYPE_IDR;
+    SS4S_VideoFeedResult result = SS4S_VIDEO_FEED_OK;
+    for (PLENTRY entry = decodeUnit->bufferList; entry != NULL && result == SS4S_VIDEO_FEED_OK; entry = entry->next) {
+        SS4S_VideoFeedFlags flags = frameFlags;
+        if (entry == decodeUnit->bufferList) {
+            flags |= SS4S_VIDEO_FEED_DATA_FRAME_START;
+        }
+        if (entry->next == NULL) {
+            flags |= SS4S_VIDEO_FEED_DATA_FRAME_END;
+        }
+        size_t rewritten = vdec_rewrite_entry(entry, param_set_buffer, sizeof(param_set_buffer), keyframe);
+        if (rewritten > 0) {
+            result = SS4S_PlayerVideoFeed(player, param_set_buffer, rewritten, flags);
+        } else {
+            result = SS4S_PlayerVideoFeed(player, (const unsigned char *) entry->data, entry->length, flags);
+        }
+    }
+    return result;
+}
+
+static SS4S_VideoFeedResult vdec_feed_copy(PDECODE_UNIT decodeUnit, SS4S_VideoFeedFlags frameFlags) {
+    bool keyframe = decodeUnit->frameType == FRAME_TYPE_IDR;
+    size_t length = 0;
+    for (PLENTRY entry = decodeUnit->bufferList; entry != NULL; entry = entry->next) {
+        size_t rewritten = vdec_rewrite_entry(entry, buffer + length, buffer_capacity - length, keyframe);
+        if (rewritten > 0) {
+            length += rewritten;
+        } else {
+            memcpy(buffer + length, entry->data, entry->length);
+            length += entry->length;
+        }
+    }
+    SS4S_VideoFeedFlags flags = frameFlags | SS4S_VIDEO_FEED_DATA_FRAME_START | SS4S_VIDEO_FEED_DATA_FRAME_END;
+    return SS4S_PlayerVideoFeed(player, buffer, length, flags);
+}
+
+static bool vdec_buffer_reserve(size_t size) {
+    if (size <= buffer_capacity) {
+        return true;
+    }
+    size_t capacity = buffer_capacity > 0 ? buffer_capacity : DECODER_BUFFER_INITIAL_SIZE;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    if (capacity > session->config.max_frame_size) {
+        capacity = session->config.max_frame_size;
+    }
+    // Contents don't need to be preserved, so avoid realloc copying them
+    unsigned char *allocated = SDL_SIMDAlloc(capacity);
+    if (allocated == NULL) {
+        commons_log_error("Session", "Failed to allocate %u bytes for decode buffer", (unsigned int) capacity);
+        return false;
+    }
+    SDL_SIMDFree(buffer);
+    buffer = allocated;
+    buffer_capacity = capacity;
+    commons_log_debug("Session", "Decode buffer grown to %u bytes", (unsigned int) capacity);
+    return true;
+}
+
+/**
+ * @return Size of the rewritten entry in dest, or 0 if the entry should be submitted as is
+ */
+static size_t vdec_rewrite_entry(const LENTRY *entry, unsigned char *dest, size_t capacity, bool keyframe) {
+#if FEATURE_SPS_FIXUP
+    if (keyframe && entry->bufferType == BUFFER_TYPE_SPS && session->sps_fixer != NULL) {
+        return gs_sps_fix(session->sps_fixer, entry, dest, capacity);
+    }
+#else
+    (void) entry;
+    (void) dest;
+    (void) capacity;
+    (void) keyframe;
+#endif
+    return 0;
+}
+
+static void vdec_log_histogram(const char *name, const latency_histogram_t *histogram) {
+    if (histogram->count == 0) {
+        return;
+    }
+    commons_log_info("Session", "%s: avg %.2f ms, p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.2f ms (%u samples)",
+                     name, latency_histogram_average(histogram) / 1000.0,
+                     latency_histogram_percentile(histogram, 50) / 1000.0,
+                     latency_histogram_percentile(histogram, 95) / 1000.0,
+                     latency_histogram_percentile(histogram, 99) / 1000.0,
+                     histogram->max_us / 1000.0, histogram->count);
+}
+
+static vdec_recorder_t *vdec_recorder_create(const char *dir, const vdec_recording_info_t *info) {
+    char name[64];
+    time_t now = time(NULL);
+    strftime(name, sizeof(name), "video-%Y%m%d-%H%M%S.mldu", localtime(&now));
+    char *path = path_join(dir, name);
+    vdec_recorder_t *recorder = vdec_recorder_open(path, info);
+    if (recorder != NULL) {
+        commons_log_info("Session", "Recording decode units to %s", path);
+    } else {
+        commons_log_error("Session", "Failed to open %s for recording", path);
+    }
+    free(path);
+    return recorder;
+}
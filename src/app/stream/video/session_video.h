@@ -2,9 +2,19 @@
 
 #include <Limelight.h>
 
-extern struct VIDEO_STATS vdec_summary_stats;
 extern struct VIDEO_INFO vdec_stream_info;
 extern struct AUDIO_INFO audio_stream_info;
 
 extern DECODER_RENDERER_CALLBACKS ss4s_dec_callbacks;
 
+/**
+ * Copy stats of the last complete window. Safe to call from any thread while the decoder keeps submitting.
+ */
+void vdec_stats_snapshot(struct VIDEO_STATS *stats);
+
+/**
+ * Resolve SPS rewriting flags for a decoder module.
+ * @param setting "auto" to use module default, "on" or "off"
+ */
+int vdec_sps_fixup_flags(const char *module, const char *setting);
+
@@ -0,0 +1,318 @@
+#include "vdec_recorder.h"
+
+#include <SDL.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDING_MAGIC "MLDU"
+#define HEADER_SIZE 24
+#define FRAME_HEADER_SIZE 36
+#define ENTRY_HEADER_SIZE 8
+// Frames are queued here by the decoder thread, and written to disk by the recorder thread
+#define RECORDER_RING_SIZE (16 * 1024 * 1024)
+// Caps a single fwrite, so closing after an error doesn't wait for the whole ring to be written
+#define RECORDER_CHUNK_SIZE (256 * 1024)
+
+struct vdec_recorder_t {
+    FILE *fp;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    unsigned char *ring;
+    size_t head, tail, used;
+    bool closing;
+    bool error;
+};
+
+struct vdec_replay_t {
+    FILE *fp;
+    DECODE_UNIT unit;
+    LENTRY *entries;
+    size_t entries_capacity;
+    char *data;
+    size_t data_capacity;
+};
+
+static void write_u16(unsigned char *dest, uint16_t value);
+
+static void write_u32(unsigned char *dest, uint32_t value);
+
+static void write_u64(unsigned char *dest, uint64_t value);
+
+static uint16_t read_u16(const unsigned char *src);
+
+static uint32_t read_u32(const unsigned char *src);
+
+static uint64_t read_u64(const unsigned char *src);
+
+static bool replay_reserve(vdec_replay_t *replay, size_t entries, size_t data);
+
+static int recorder_worker(void *arg);
+
+static size_t recorder_put(vdec_recorder_t *recorder, size_t offset, const void *data, size_t length);
+
+vdec_recorder_t *vdec_recorder_open(const char *path, const vdec_recording_info_t *info) {
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    unsigned char header[HEADER_SIZE];
+    memcpy(header, RECORDING_MAGIC, 4);
+    write_u16(&header[4], VDEC_RECORDING_VERSION);
+    write_u16(&header[6], 0);
+    write_u32(&header[8], (uint32_t) info->video_format);
+    write_u32(&header[12], (uint32_t) info->width);
+    write_u32(&header[16], (uint32_t) info->height);
+    write_u32(&header[20], (uint32_t) info->redraw_rate);
+    unsigned char *ring = malloc(RECORDER_RING_SIZE);
+    if (ring == NULL || fwrite(header, HEADER_SIZE, 1, fp) != 1) {
+        free(ring);
+        fclose(fp);
+        return NULL;
+    }
+    vdec_recorder_t *recorder = calloc(1, sizeof(vdec_recorder_t));
+    recorder->fp = fp;
+    recorder->ring = ring;
+    recorder->lock = SDL_CreateMutex();
+    recorder->cond = SDL_CreateCond();
+    recorder->thread = SDL_CreateThread(recorder_worker, "vdec_recorder", recorder);
+    if (recorder->thread == NULL) {
+        vdec_recorder_close(recorder);
+        return NULL;
+    }
+    return recorder;
+}
+
+bool vdec_recorder_write(vdec_recorder_t *recorder, const DECODE_UNIT *unit) {
+    uint16_t entries = 0;
+    size_t size = FRAME_HEADER_SIZE;
+    for (PLENTRY entry = unit->bufferList; entry != NULL; entry = entry->next) {
+        entries++;
+        size += ENTRY_HEADER_SIZE + (size_t) entry->length;
+    }
+    SDL_LockMutex(recorder->lock);
+    if (!recorder->error && RECORDER_RING_SIZE - recorder->used < size) {
+        // Disk can't keep up. A recording with frames missing wouldn't decode, so stop here
+        recorder->error = true;
+        SDL_CondSignal(recorder->cond);
+    }
+    bool error = recorder->error;
+    size_t offset = recorder->head;
+    SDL_UnlockMutex(recorder->lock);
+    if (error) {
+        return false;
+    }
+    // Space between head and tail is only touched by this thread until it's published below
+    unsigned char header[FRAME_HEADER_SIZE];
+    write_u32(&header[0], (uint32_t) unit->frameNumber);
+    write_u32(&header[4], (uint32_t) unit->frameType);
+    write_u16(&header[8], unit->frameHostProcessingLatency);
+    write_u16(&header[10], entries);
+    write_u64(&header[12], unit->receiveTimeMs);
+    write_u64(&header[20], unit->enqueueTimeMs);
+    write_u32(&header[28], unit->presentationTimeMs);
+    write_u32(&header[32], (uint32_t) unit->fullLength);
+    offset = recorder_put(recorder, offset, header, FRAME_HEADER_SIZE);
+    for (PLENTRY entry = unit->bufferList; entry != NULL; entry = entry->next) {
+        unsigned char entry_header[ENTRY_HEADER_SIZE];
+        write_u32(&entry_header[0], (uint32_t) entry->bufferType);
+        write_u32(&entry_header[4], (uint32_t) entry->length);
+        offset = recorder_put(recorder, offset, entry_header, ENTRY_HEADER_SIZE);
+        offset = recorder_put(recorder, offset, entry->data, (size_t) entry->length);
+    }
+    SDL_LockMutex(recorder->lock);
+    recorder->head = offset;
+    recorder->used += size;
+    SDL_CondSignal(recorder->cond);
+    SDL_UnlockMutex(recorder->lock);
+    return true;
+}
+
+bool vdec_recorder_close(vdec_recorder_t *recorder) {
+    if (recorder->thread != NULL) {
+        SDL_LockMutex(recorder->lock);
+        recorder->closing = true;
+        SDL_CondSignal(recorder->cond);
+        SDL_UnlockMutex(recorder->lock);
+        SDL_WaitThread(recorder->thread, NULL);
+    }
+    bool ok = !recorder->error && recorder->thread != NULL;
+    if (fclose(recorder->fp) != 0) {
+        ok = false;
+    }
+    SDL_DestroyCond(recorder->cond);
+    SDL_DestroyMutex(recorder->lock);
+    free(recorder->ring);
+    free(recorder);
+    return ok;
+}
+
+vdec_replay_t *vdec_replay_open(const char *path, vdec_recording_info_t *info) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    unsigned char header[HEADER_SIZE];
+    if (fread(header, HEADER_SIZE, 1, fp) != 1 || memcmp(header, RECORDING_MAGIC, 4) != 0 ||
+        read_u16(&header[4]) != VDEC_RECORDING_VERSION) {
+        fclose(fp);
+        return NULL;
+    }
+    info->video_format = (int) read_u32(&header[8]);
+    info->width = (int) read_u32(&header[12]);
+    info->height = (int) read_u32(&header[16]);
+    info->redraw_rate = (int) read_u32(&header[20]);
+    vdec_replay_t *replay = calloc(1, sizeof(vdec_replay_t));
+    replay->fp = fp;
+    return replay;
+}
+
+PDECODE_UNIT vdec_replay_read(vdec_replay_t *replay) {
+    unsigned char header[FRAME_HEADER_SIZE];
+    if (fread(header, FRAME_HEADER_SIZE, 1, replay->fp) != 1) {
+        return NULL;
+    }
+    PDECODE_UNIT unit = &replay->unit;
+    memset(unit, 0, sizeof(DECODE_UNIT));
+    unit->frameNumber = (int) read_u32(&header[0]);
+    unit->frameType = (int) read_u32(&header[4]);
+    unit->frameHostProcessingLatency = read_u16(&header[8]);
+    uint16_t entries = read_u16(&header[10]);
+    unit->receiveTimeMs = read_u64(&header[12]);
+    unit->enqueueTimeMs = read_u64(&header[20]);
+    unit->presentationTimeMs = read_u32(&header[28]);
+    unit->fullLength = (int) read_u32(&header[32]);
+    if (entries == 0 || !replay_reserve(replay, entries, (size_t) unit->fullLength)) {
+        return NULL;
+    }
+    size_t offset = 0;
+    for (uint16_t i = 0; i < entries; i++) {
+        unsigned char entry_header[ENTRY_HEADER_SIZE];
+        if (fread(entry_header, ENTRY_HEADER_SIZE, 1, replay->fp) != 1) {
+            return NULL;
+        }
+        uint32_t length = read_u32(&entry_header[4]);
+        // Entries should add up to fullLength, don't trust the file on that
+        if (!replay_reserve(replay, entries, offset + length)) {
+            return NULL;
+        }
+        if (fread(replay->data + offset, 1, length, replay->fp) != length) {
+            return NULL;
+        }
+        LENTRY *entry = &replay->entries[i];
+        entry->bufferType = (int) read_u32(&entry_header[0]);
+        entry->length = (int) length;
+        // Data buffer may move while reading, so store offsets and resolve them later
+        entry->data = (char *) (uintptr_t) offset;
+        entry->next = i + 1 < entries ? &replay->entries[i + 1] : NULL;
+        offset += length;
+    }
+    for (uint16_t i = 0; i < entries; i++) {
+        replay->entries[i].data = replay->data + (uintptr_t) replay->entries[i].data;
+    }
+    unit->bufferList = replay->entries;
+    return unit;
+}
+
+bool vdec_replay_rewind(vdec_replay_t *replay) {
+    return fseek(replay->fp, HEADER_SIZE, SEEK_SET) == 0;
+}
+
+void vdec_replay_close(vdec_replay_t *replay) {
+    fclose(replay->fp);
+    free(replay->entries);
+    free(replay->data);
+    free(replay);
+}
+
+static bool replay_reserve(vdec_replay_t *replay, size_t entries, size_t data) {
+    if (entries > replay->entries_capacity) {
+        LENTRY *allocated = realloc(replay->entries, entries * sizeof(LENTRY));
+        if (allocated == NULL) {
+            return false;
+        }
+        replay->entries = allocated;
+        replay->entries_capacity = entries;
+    }
+    if (data > replay->data_capacity) {
+        size_t capacity = replay->data_capacity > 0 ? replay->data_capacity : 1024 * 1024;
+        while (capacity < data) {
+            capacity *= 2;
+        }
+        char *allocated = realloc(replay->data, capacity);
+        if (allocated == NULL) {
+            return false;
+        }
+        replay->data = allocated;
+        replay->data_capacity = capacity;
+    }
+    return true;
+}
+
+static int recorder_worker(void *arg) {
+    vdec_recorder_t *recorder = arg;
+    SDL_LockMutex(recorder->lock);
+    while (!recorder->error) {
+        if (recorder->used == 0) {
+            if (recorder->closing) {
+                break;
+            }
+            SDL_CondWait(recorder->cond, recorder->lock);
+            continue;
+        }
+        size_t tail = recorder->tail;
+        size_t length = recorder->used;
+        if (length > RECORDER_RING_SIZE - tail) {
+            length = RECORDER_RING_SIZE - tail;
+        }
+        if (length > RECORDER_CHUNK_SIZE) {
+            length = RECORDER_CHUNK_SIZE;
+        }
+        SDL_UnlockMutex(recorder->lock);
+        bool written = fwrite(recorder->ring + tail, 1, length, recorder->fp) == length;
+        SDL_LockMutex(recorder->lock);
+        recorder->tail = (tail + length) % RECORDER_RING_SIZE;
+        recorder->used -= length;
+        if (!written) {
+            recorder->error = true;
+        }
+    }
+    SDL_UnlockMutex(recorder->lock);
+    return 0;
+}
+
+static size_t recorder_put(vdec_recorder_t *recorder, size_t offset, const void *data, size_t length) {
+    size_t first = length < RECORDER_RING_SIZE - offset ? length : RECORDER_RING_SIZE - offset;
+    memcpy(recorder->ring + offset, data, first);
+    memcpy(recorder->ring, (const unsigned char *) data + first, length - first);
+    return (offset + length) % RECORDER_RING_SIZE;
+}
+
+static void write_u16(unsigned char *dest, uint16_t value) {
+    dest[0] = value & 0xFF;
+    dest[1] = (value >> 8) & 0xFF;
+}
+
+static void write_u32(unsigned char *dest, uint32_t value) {
+    write_u16(dest, value & 0xFFFF);
+    write_u16(dest + 2, (value >> 16) & 0xFFFF);
+}
+
+static void write_u64(unsigned char *dest, uint64_t value) {
+    write_u32(dest, value & 0xFFFFFFFF);
+    write_u32(dest + 4, (value >> 32) & 0xFFFFFFFF);
+}
+
+static uint16_t read_u16(const unsigned char *src) {
+    return (uint16_t) (src[0] | src[1] << 8);
+}
+
+static uint32_t read_u32(const unsigned char *src) {
+    return read_u16(src) | (uint32_t) read_u16(src + 2) << 16;
+}
+
+static uint64_t read_u64(const unsigned char *src) {
+    return read_u32(src) | (uint64_t) read_u32(src + 4) << 32;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdbool.h>
+#include <Limelight.h>
+
+/**
+ * Recording of decode units as received from moonlight-common-c, used by moonlight-replay.
+ *
+ * Everything is little endian. The file starts with a header:
+ * "MLDU", u16 version, u16 reserved, i32 video format, i32 width, i32 height, i32 redraw rate.
+ * Then for each frame: i32 frame number, i32 frame type, u16 host processing latency, u16 entry count,
+ * u64 receive time, u64 enqueue time, u32 presentation time, u32 full length,
+ * followed by the entries, each as i32 buffer type, u32 length and data.
+ */
+#define VDEC_RECORDING_VERSION 1
+
+typedef struct vdec_recording_info_t {
+    int video_format;
+    int width;
+    int height;
+    int redraw_rate;
+} vdec_recording_info_t;
+
+typedef struct vdec_recorder_t vdec_recorder_t;
+
+typedef struct vdec_replay_t vdec_replay_t;
+
+vdec_recorder_t *vdec_recorder_open(const char *path, const vdec_recording_info_t *info);
+
+/**
+ * Queue a decode unit to be written by the recorder thread. Only copies memory, so it's fine on decoder thread.
+ * Must be called from one thread at a time.
+ * @return false if recording has failed, e.g. when the disk can't keep up with the stream
+ */
+bool vdec_recorder_write(vdec_recorder_t *recorder, const DECODE_UNIT *unit);
+
+/**
+ * Waits for queued decode units to be written, unless recording has already failed.
+ * @return false if anything failed to be written
+ */
+bool vdec_recorder_close(vdec_recorder_t *recorder);
+
+vdec_replay_t *vdec_replay_open(const char *path, vdec_recording_info_t *info);
+
+/**
+ * Read next decode unit. The returned unit and its buffers are owned by the replay,
+ * and stay valid until next read.
+ * @return NULL at the end of recording, or if the recording is truncated
+ */
+PDECODE_UNIT vdec_replay_read(vdec_replay_t *replay);
+
+/**
+ * Restart from the first decode unit
+ */
+bool vdec_replay_rewind(vdec_replay_t *replay);
+
+void vdec_replay_close(vdec_replay_t *replay);
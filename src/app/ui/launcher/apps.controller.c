@@ -58,6 +58,10 @@ static void applist_focus_enter(lv_event_t *event);
 
 static void applist_focus_leave(lv_event_t *event);
 
+static void applist_scroll_cb(lv_event_t *event);
+
+static void apps_prefetch_covers(apps_fragment_t *controller);
+
 static void update_view_state(apps_fragment_t *controller);
 
 static void appitem_bind(apps_fragment_t *controller, lv_obj_t *item, apploader_item_t *app);
@@ -122,6 +126,11 @@ static void show_error(apps_fragment_t *fragment, const char *title, const char
 
 static apps_fragment_t *current_instance = NULL;
 
+/* Rows of covers to load ahead in scroll direction */
+#define COVER_PREFETCH_ROWS 2
+/* Matches the column limit in update_grid_config() */
+#define APPLIST_MAX_COLS 5
+
 const static lv_gridview_adapter_t apps_adapter = {
         .item_count = adapter_item_count,
         .create_view = adapter_create_view,
@@ -250,6 +259,7 @@ static void on_view_created(lv_fragment_t *self, lv_obj_t *view) {
     lv_obj_add_event_cb(applist, applist_focus_enter, LV_EVENT_FOCUSED, controller);
     lv_obj_add_event_cb(applist, applist_focus_leave, LV_EVENT_DEFOCUSED, controller);
     lv_obj_add_event_cb(applist, applist_focus_leave, LV_EVENT_LEAVE, controller);
+    lv_obj_add_event_cb(applist, applist_scroll_cb, LV_EVENT_SCROLL, controller);
     lv_obj_add_event_cb(controller->actions, actions_click_cb, LV_EVENT_VALUE_CHANGED, controller);
 
     update_grid_config(controller);
@@ -277,7 +287,7 @@ static void update_grid_config(apps_fragment_t *controller) {
     lv_obj_t *applist = controller->applist;
     lv_obj_update_layout(applist);
     lv_coord_t applist_width = lv_obj_get_width(applist);
-    int col_count = LV_CLAMP(2, applist_width / lv_dpx(120), 5);
+    int col_count = LV_CLAMP(2, applist_width / lv_dpx(120), APPLIST_MAX_COLS);
     lv_coord_t col_width = (applist_width - lv_obj_get_style_pad_left(applist, 0) -
                             lv_obj_get_style_pad_right(applist, 0) -
                             lv_obj_get_style_pad_column(applist, 0) * (col_count - 1)) / col_count;
@@ -503,6 +513,7 @@ static void appload_loaded(apploader_list_t *apps, void *userdata) {
     apploader_list_free(fragment->apploader_apps);
     fragment->apploader_apps = apps;
     update_view_state(fragment);
+    apps_prefetch_covers(fragment);
 
     if (fragment->def_app > 0 && !fragment->def_app_launched) {
         fragment->def_app_launched = true;
@@ -650,6 +661,59 @@ static void applist_focus_leave(lv_event_t *event) {
     lv_gridview_focus(controller->applist, -1);
 }
 
+static void applist_scroll_cb(lv_event_t *event) {
+    apps_fragment_t *controller = lv_event_get_user_data(event);
+    apps_prefetch_covers(controller);
+}
+
+/**
+ * Prefetch covers of rows next to the viewport in scroll direction. Cells are only bound when they come into view,
+ * so without this fast scrolling shows empty placeholders.
+ */
+static void apps_prefetch_covers(apps_fragment_t *controller) {
+    const apploader_list_t *apps = controller->apploader_apps;
+    if (apps == NULL || apps->count == 0 || controller->col_count <= 0) {
+        return;
+    }
+    lv_obj_t *applist = controller->applist;
+    lv_coord_t scroll_y = lv_obj_get_scroll_y(applist);
+    if (scroll_y != controller->last_scroll_y) {
+        controller->scrolling_up = scroll_y < controller->last_scroll_y;
+        controller->last_scroll_y = scroll_y;
+    }
+    int col_count = controller->col_count;
+    lv_coord_t row_span = controller->col_height + lv_obj_get_style_pad_row(applist, 0);
+    if (row_span <= 0) {
+        return;
+    }
+    lv_coord_t top = scroll_y - lv_obj_get_style_pad_top(applist, 0);
+    int first_row = LV_MAX(0, top / row_span);
+    int last_row = LV_MAX(0, (top + lv_obj_get_height(applist)) / row_span);
+    int row_count = (apps->count + col_count - 1) / col_count;
+    int from, to;
+    if (controller->scrolling_up) {
+        from = LV_MAX(0, first_row - COVER_PREFETCH_ROWS);
+        to = first_row - 1;
+    } else {
+        from = last_row + 1;
+        to = LV_MIN(row_count - 1, last_row + COVER_PREFETCH_ROWS);
+    }
+    int ids[COVER_PREFETCH_ROWS * APPLIST_MAX_COLS];
+    int count = 0;
+    for (int row = from; row <= to; row++) {
+        for (int col = 0; col < col_count; col++) {
+            int position = row * col_count + col;
+            if (position >= apps->count || count >= (int) (sizeof(ids) / sizeof(int))) {
+                break;
+            }
+            ids[count++] = apps->items[position].base.id;
+        }
+    }
+    coverloader_prefetch(controller->coverloader, &controller->uuid, ids, count, controller->col_width,
+                         controller->col_height);
+    coverloader_update_priorities(controller->coverloader);
+}
+
 static void quitgame_cb(int result, const char *error, const uuidstr_t *uuid, void *userdata) {
     apps_fragment_t *controller = userdata;
     if (controller->quit_progress) {
@@ -45,6 +45,9 @@ typedef struct {
     int col_count;
     lv_coord_t col_width, col_height;
     int focus_backup;
+    /* To tell scroll direction for cover prefetch */
+    lv_coord_t last_scroll_y;
+    bool scrolling_up;
 } apps_fragment_t;
 
 typedef struct {
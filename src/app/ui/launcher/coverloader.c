@@ -14,20 +14,40 @@
 #include "draw/sdl/lv_draw_sdl.h"
 #include "misc/lv_lru.h"
 #include "util/img_loader.h"
+#include "util/img_scale.h"
+#if FEATURE_COVER_JPEG_SCALING
+#include "util/jpeg_scaled.h"
+#endif
+#include "util/thumbcache.h"
 #include "refcounter.h"
 
 #include "res.h"
 
+/* Default cover cache budget is 1/64 of system memory, within these bounds */
+#define MEMCACHE_AUTO_MIN_MB 8
+#define MEMCACHE_AUTO_MAX_MB 64
+/* Roughly a 200x300 cover in 32bpp */
+#define MEMCACHE_AVG_ITEM_SIZE (240 * 1024)
+/* Leave executor threads for other work, and let visible covers jump ahead of queued prefetches */
+#define LOADER_MAX_IN_FLIGHT 4
+/* Same cadence as the main loop stats */
+#define STATS_LOG_INTERVAL_MS 30000
+
 typedef struct memcache_key_t {
+    /* App IDs are only unique within the same host */
+    uuidstr_t server_id;
     int id;
     lv_coord_t target_width, target_height;
 } memcache_key_t;
 
 typedef struct memcache_item_t {
+    coverloader_t *loader;
     lv_img_dsc_t src;
     lv_sdl_img_data_t data;
     lv_ll_t objs;
     lv_coord_t target_width, target_height, target_radius;
+    /* Texture memory, as weighted in memory cache */
+    size_t bytes;
 } memcache_item_t;
 
 typedef struct img_loader_req_t {
@@ -38,6 +58,11 @@ typedef struct img_loader_req_t {
     lv_coord_t target_width, target_height;
     memcache_item_t *src;
     bool finished;
+    /* Requested by coverloader_prefetch(), has no target until a display request adopts it */
+    bool prefetch;
+    /* Decoded, waiting for texture upload. Callbacks are deferred until it's uploaded */
+    bool upload_pending;
+    bool cancelled;
     SDL_Surface *cached;
     img_loader_task_t *task;
     struct img_loader_req_t *prev;
@@ -63,12 +88,18 @@ typedef struct img_loader_req_t {
 #define DEBUG 0
 #endif
 
+/* Texture uploads done in one frame. At least one cover is uploaded per frame. */
+#define UPLOAD_BUDGET_US 4000
+#define UPLOAD_BUDGET_BYTES (4 * 1024 * 1024)
+
 static const char *coverloader_cache_dir(coverloader_t *loader);
 
 static GS_CLIENT coverloader_gs_client(coverloader_t *loader);
 
 static void coverloader_cache_item_path(char path[4096], const coverloader_req_t *req);
 
+static void coverloader_thumb_path(char path[4096], const coverloader_req_t *req);
+
 static bool coverloader_memcache_get(coverloader_req_t *req);
 
 static void coverloader_memcache_put(coverloader_req_t *req);
@@ -79,6 +110,10 @@ static void coverloader_filecache_put(coverloader_req_t *req);
 
 static bool coverloader_fetch(coverloader_req_t *req);
 
+static bool coverloader_decode_cover(coverloader_req_t *req);
+
+static void cover_surface_free(SDL_Surface *surface);
+
 static void coverloader_run_on_main(img_loader_t *loader, img_loader_run_on_main_fn fn, void *args);
 
 static void img_loader_start_cb(coverloader_req_t *req);
@@ -94,15 +129,27 @@ static void img_loader_cancel_cb(coverloader_req_t *req);
  */
 static void img_set_cover(lv_obj_t *obj, memcache_item_t *src);
 
-static struct memcache_item_t *memcache_item_new();
+static struct memcache_item_t *memcache_item_new(coverloader_t *loader);
 
 static void memcache_item_free(memcache_item_t *item);
 
 static void coverloader_req_free(coverloader_req_t *req);
 
+static void memcache_key_init(memcache_key_t *key, const coverloader_req_t *req);
+
+static size_t memcache_budget(const app_settings_t *settings);
+
+static size_t texture_bytes(SDL_Texture *texture, const SDL_Surface *surface);
+
 static int reqlist_find_by_target(coverloader_req_t *p, const void *v);
 
-static bool cover_is_placeholder(const SDL_Surface *surface);
+static coverloader_req_t *reqlist_find_same_cover(coverloader_req_t *head, const uuidstr_t *uuid, int id,
+                                                  lv_coord_t target_width, lv_coord_t target_height);
+
+static coverloader_req_t *coverloader_req_new(coverloader_t *loader, const uuidstr_t *uuid, int id,
+                                              lv_coord_t target_width, lv_coord_t target_height);
+
+static bool cover_is_placeholder(int width, int height);
 
 static void target_deleted_cb(lv_event_t *e);
 
@@ -116,6 +163,24 @@ static void purge_img_cache(lv_draw_sdl_ctx_t *ctx, const memcache_item_t *item)
 
 static void purge_corners_cache(lv_draw_sdl_ctx_t *ctx, const memcache_item_t *item);
 
+static SDL_Renderer *coverloader_renderer();
+
+static Uint32 renderer_texture_format(SDL_Renderer *renderer);
+
+static SDL_Texture *create_texture(SDL_Renderer *renderer, SDL_Surface *surface, bool alpha);
+
+static void upload_enqueue(coverloader_t *loader, coverloader_req_t *req);
+
+static void upload_timer_cb(lv_timer_t *timer);
+
+static void stats_timer_cb(lv_timer_t *timer);
+
+static void stats_log(coverloader_t *loader, bool final);
+
+static size_t upload_cover(coverloader_req_t *req);
+
+static bool upload_take(coverloader_t *loader, coverloader_req_t **out, bool visible_only);
+
 static const img_loader_impl_t coverloader_impl = {
         .memcache_get = coverloader_memcache_get,
         .memcache_put = coverloader_memcache_put,
@@ -138,22 +203,47 @@ struct coverloader_t {
     lazy_t client;
     lazy_t cache_dir;
     coverloader_req_t *reqlist;
+    /* Texture format of the renderer, decoded covers are converted to it by workers */
+    Uint32 texture_format;
+    /* Requests waiting for texture upload */
+    lv_ll_t upload_queue;
+    lv_timer_t *upload_timer;
+    coverloader_stats_t stats;
+    lv_timer_t *stats_timer;
+    /* Lookups at the last periodic log, nothing is logged while the launcher is idle */
+    unsigned int stats_logged_lookups;
+    /* Items freed while destroying aren't evictions */
+    bool destroying;
     refcounter_t refcounter;
 };
 
 typedef struct subimage_info_t {
     int w, h;
     SDL_Rect rect;
+    bool alpha;
+    bool from_thumbcache;
 } subimage_info_t;
 
 coverloader_t *coverloader_new(app_t *app) {
     coverloader_t *loader = malloc(sizeof(coverloader_t));
     refcounter_init(&loader->refcounter);
-    loader->mem_cache = lv_lru_create(1024 * 1024 * 32, 720 * 1024, (lv_lru_free_t *) memcache_item_free, NULL);
-    loader->base_loader = img_loader_create(&coverloader_impl, app->backend.executor);
+    memset(&loader->stats, 0, sizeof(coverloader_stats_t));
+    loader->stats_logged_lookups = 0;
+    loader->stats.budget = memcache_budget(&app->settings);
+    loader->destroying = false;
+    loader->mem_cache = lv_lru_create(loader->stats.budget, MEMCACHE_AVG_ITEM_SIZE,
+                                      (lv_lru_free_t *) memcache_item_free, NULL);
+    commons_log_debug("CoverLoader", "Memory cache budget: %zu KB", loader->stats.budget / 1024);
+    loader->base_loader = img_loader_create(&coverloader_impl, app->backend.executor, EXECUTOR_LANE_BACKGROUND,
+                                            LOADER_MAX_IN_FLIGHT);
     lazy_init(&loader->client, (lazy_supplier) app_gs_client_new, app);
     lazy_init(&loader->cache_dir, (lazy_supplier) path_cache, NULL);
     loader->reqlist = NULL;
+    loader->texture_format = renderer_texture_format(coverloader_renderer());
+    _lv_ll_init(&loader->upload_queue, sizeof(coverloader_req_t *));
+    loader->upload_timer = lv_timer_create(upload_timer_cb, LV_DISP_DEF_REFR_PERIOD, loader);
+    lv_timer_pause(loader->upload_timer);
+    loader->stats_timer = lv_timer_create(stats_timer_cb, STATS_LOG_INTERVAL_MS, loader);
     return loader;
 }
 
@@ -170,6 +260,12 @@ void coverloader_unref(coverloader_t *loader) {
         free(cache_dir);
     }
     img_loader_destroy(loader->base_loader);
+    // Every queued upload holds a reference, so the queue is empty here
+    lv_timer_del(loader->upload_timer);
+    _lv_ll_clear(&loader->upload_queue);
+    lv_timer_del(loader->stats_timer);
+    stats_log(loader, true);
+    loader->destroying = true;
     lv_lru_del(loader->mem_cache);
     refcounter_destroy(&loader->refcounter);
     free(loader);
@@ -178,27 +274,78 @@ void coverloader_unref(coverloader_t *loader) {
 void coverloader_display(coverloader_t *loader, const uuidstr_t *uuid, int id, lv_obj_t *target,
                          lv_coord_t target_width, lv_coord_t target_height) {
     coverloader_req_t *existing = reqlist_find_by(loader->reqlist, target, reqlist_find_by_target);
-    if (existing && existing->task) {
+    if (existing && existing->task && !existing->cancelled) {
         img_loader_cancel(loader->base_loader, existing->task);
+        // So it won't be picked up by prefetch or display of the same cover
+        existing->cancelled = true;
+    } else if (existing && existing->upload_pending) {
+        // Still goes into memory cache, but shouldn't replace the cover being requested now
+        existing->cancelled = true;
     }
 
-    coverloader_req_t *req = reqlist_new();
-    req->loader = loader;
-    req->server_id = *uuid;
-    req->id = id;
+    coverloader_req_t *prefetched = reqlist_find_same_cover(loader->reqlist, uuid, id, target_width, target_height);
+    if (prefetched != NULL && prefetched->prefetch) {
+        // Already on its way, let it display on this target when done
+        prefetched->prefetch = false;
+        prefetched->target = target;
+        lv_obj_add_event_cb(target, target_deleted_cb, LV_EVENT_DELETE, prefetched);
+        img_loader_start_cb(prefetched);
+        if (prefetched->task != NULL) {
+            img_loader_set_priority(loader->base_loader, prefetched->task, IMG_LOADER_PRIORITY_VISIBLE);
+        }
+        return;
+    }
+
+    coverloader_req_t *req = coverloader_req_new(loader, uuid, id, target_width, target_height);
     req->target = target;
-    req->target_width = target_width;
-    req->target_height = target_height;
-    req->finished = false;
     lv_obj_add_event_cb(target, target_deleted_cb, LV_EVENT_DELETE, req);
-    loader->reqlist = reqlist_append(loader->reqlist, req);
-    refcounter_ref(&loader->refcounter);
-    img_loader_task_t *task = img_loader_load(loader->base_loader, req, &coverloader_cb);
+    img_loader_task_t *task = img_loader_load(loader->base_loader, req, &coverloader_cb, IMG_LOADER_PRIORITY_VISIBLE);
     /* If no task returned, then the request has been freed already */
     if (!task) { return; }
     req->task = task;
 }
 
+void coverloader_prefetch(coverloader_t *loader, const uuidstr_t *uuid, const int *ids, int count,
+                          lv_coord_t target_width, lv_coord_t target_height) {
+    // Drop prefetches that are no longer wanted, if they haven't finished loading
+    for (coverloader_req_t *cur = loader->reqlist; cur != NULL; cur = cur->next) {
+        if (!cur->prefetch || cur->task == NULL || cur->cancelled) {
+            continue;
+        }
+        bool wanted = false;
+        for (int i = 0; i < count && !wanted; i++) {
+            wanted = cur->id == ids[i] && uuidstr_t_equals_t(&cur->server_id, uuid) &&
+                     cur->target_width == target_width && cur->target_height == target_height;
+        }
+        if (!wanted) {
+            img_loader_cancel(loader->base_loader, cur->task);
+            cur->cancelled = true;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        if (reqlist_find_same_cover(loader->reqlist, uuid, ids[i], target_width, target_height) != NULL) {
+            continue;
+        }
+        coverloader_req_t *req = coverloader_req_new(loader, uuid, ids[i], target_width, target_height);
+        req->prefetch = true;
+        img_loader_task_t *task = img_loader_load(loader->base_loader, req, &coverloader_cb,
+                                                  IMG_LOADER_PRIORITY_PREFETCH);
+        if (!task) { continue; }
+        req->task = task;
+    }
+}
+
+void coverloader_update_priorities(coverloader_t *loader) {
+    for (coverloader_req_t *cur = loader->reqlist; cur != NULL; cur = cur->next) {
+        if (cur->task == NULL || cur->prefetch) {
+            continue;
+        }
+        bool visible = cur->target != NULL && lv_obj_is_visible(cur->target);
+        img_loader_set_priority(loader->base_loader, cur->task,
+                                visible ? IMG_LOADER_PRIORITY_VISIBLE : IMG_LOADER_PRIORITY_PREFETCH);
+    }
+}
+
 static const char *coverloader_cache_dir(coverloader_t *loader) {
     return lazy_obtain(&loader->cache_dir);
 }
@@ -218,16 +365,15 @@ static bool coverloader_memcache_get(coverloader_req_t *req) {
     // Uses result cache instead
     memcache_item_t *result = NULL;
     memcache_key_t key;
-    memset(&key, 0, sizeof(key));
-    key.id = req->id;
-    key.target_width = req->target_width;
-    key.target_height = req->target_height;
-
-    (void) key.target_width;
-    (void) key.target_height;
+    memcache_key_init(&key, req);
 
     lv_lru_get(req->loader->mem_cache, &key, sizeof(key), (void **) &result);
     req->src = result;
+    if (result != NULL) {
+        req->loader->stats.hits++;
+    } else {
+        req->loader->stats.misses++;
+    }
 
     return result != NULL;
 }
@@ -238,49 +384,26 @@ static void coverloader_memcache_put(coverloader_req_t *req) {
         return;
     }
     memcache_item_t *result = NULL;
-    memcache_key_t key = {
-            .id = req->id,
-            .target_width = req->target_width,
-            .target_height = req->target_height
-    };
+    memcache_key_t key;
+    memcache_key_init(&key, req);
     lv_lru_get(req->loader->mem_cache, &key, sizeof(key), (void **) &result);
     if (result == NULL) {
-        lv_draw_sdl_drv_param_t *param = lv_disp_get_default()->driver->user_data;
-        SDL_Renderer *renderer = param->renderer;
-
-        result = memcache_item_new();
-        result->target_width = req->target_width;
-        result->target_height = req->target_height;
-        result->target_radius = lv_obj_get_style_radius(req->target, 0);
-        lv_img_dsc_t *src = &result->src;
-        lv_sdl_img_data_t *data = &result->data;
-        data->type = LV_SDL_IMG_TYPE_TEXTURE;
-        src->header.cf = LV_IMG_CF_TRUE_COLOR;
-        if (SDL_ISPIXELFORMAT_ALPHA(cached->format->format)) {
-            src->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
-        }
-        int value_length = cached->w * cached->h;
-        if (cached->userdata) {
-            subimage_info_t *info = cached->userdata;
-            data->rect = info->rect;
-            value_length = info->w * info->h;
-            src->header.w = info->w;
-            src->header.h = info->h;
-        } else {
-            src->header.w = cached->w;
-            src->header.h = cached->h;
-        }
-        data->data.texture = SDL_CreateTextureFromSurface(renderer, cached);
-        src->data_size = sizeof(lv_sdl_img_data_t);
-        src->data = (const uint8_t *) data;
-        lv_lru_set(req->loader->mem_cache, &key, sizeof(key), result, value_length);
+        // Uploading is spread across frames, callbacks will be invoked after that
+        upload_enqueue(req->loader, req);
+        return;
     }
     req->src = result;
     req->finished = true;
-    if (cached->userdata) {
-        SDL_free(cached->userdata);
-    }
-    SDL_FreeSurface(cached);
+    req->cached = NULL;
+    cover_surface_free(cached);
+}
+
+static void coverloader_thumb_path(char path[4096], const coverloader_req_t *req) {
+    const char *cachedir = coverloader_cache_dir(req->loader);
+    char basename[128];
+    SDL_snprintf(basename, 128, "%s_%d_%dx%d.thumb", (char *) &req->server_id, req->id, req->target_width,
+                 req->target_height);
+    path_join_to(path, 4096, cachedir, basename);
 }
 
 static bool coverloader_filecache_get(coverloader_req_t *req) {
@@ -292,80 +415,130 @@ static bool coverloader_filecache_get(coverloader_req_t *req) {
     }
 #endif
     char path[4096];
-    coverloader_cache_item_path(path, req);
-    SDL_Surface *decoded = IMG_Load(path);
-    if (!decoded) {
-        commons_log_warn("CoverLoader", "Failed to load cover from %s: %s", path, IMG_GetError());
-        return false;
-    }
-    if (cover_is_placeholder(decoded)) {
-        SDL_FreeSurface(decoded);
-        return false;
+    coverloader_thumb_path(path, req);
+    SDL_Surface *thumb = NULL;
+    thumbcache_meta_t meta;
+    switch (thumbcache_read(path, &thumb, &meta)) {
+        case THUMBCACHE_HIT: {
+            subimage_info_t *info = SDL_malloc(sizeof(subimage_info_t));
+            info->w = meta.width;
+            info->h = meta.height;
+            info->rect = meta.rect;
+            info->alpha = meta.alpha;
+            info->from_thumbcache = true;
+            thumb->userdata = info;
+            req->cached = thumb;
+            return true;
+        }
+        case THUMBCACHE_PLACEHOLDER:
+            return false;
+        default:
+            return coverloader_decode_cover(req);
     }
-    // Indexed images needs to be converted to true color before scaling
-    if (decoded->format->palette != NULL) {
-#if !SDL_VERSION_ATLEAST(2, 30, 0)
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-#define SDL_PIXELFORMAT_RGBX32 SDL_PIXELFORMAT_RGBX8888
-#else
-#define SDL_PIXELFORMAT_RGBX32 SDL_PIXELFORMAT_XBGR8888
-#endif
+}
+
+/**
+ * Decode downloaded cover, scale it down and save the result as thumbnail
+ */
+static bool coverloader_decode_cover(coverloader_req_t *req) {
+    char path[4096];
+    coverloader_cache_item_path(path, req);
+    Uint64 decode_start = SDL_GetPerformanceCounter();
+    int full_width = 0, full_height = 0;
+    SDL_Surface *decoded = NULL;
+#if FEATURE_COVER_JPEG_SCALING
+    // Decode JPEGs at reduced size, other formats go through SDL_image
+    decoded = jpeg_decode_scaled(path, req->target_width, req->target_height, &full_width, &full_height);
 #endif
-        SDL_Surface *true_color = SDL_ConvertSurfaceFormat(decoded, SDL_PIXELFORMAT_RGBX32, 0);
-        SDL_FreeSurface(decoded);
-        if (true_color == NULL) {
+    if (decoded == NULL) {
+        decoded = IMG_Load(path);
+        if (!decoded) {
+            commons_log_warn("CoverLoader", "Failed to load cover from %s: %s", path, IMG_GetError());
             return false;
         }
-        decoded = true_color;
-    }
-    int sw = decoded->w, sh = decoded->h;
-    while (sw > req->target_width * 1.5 || sh > req->target_height * 1.5) {
-        sw /= 2;
-        sh /= 2;
+        full_width = decoded->w;
+        full_height = decoded->h;
     }
-    if (!sw || !sh) {
-        // Image is too small to display
+    // Decoded image is the peak allocation of this task
+    int decoded_width = decoded->w, decoded_height = decoded->h;
+    size_t decoded_bytes = (size_t) decoded->pitch * decoded->h;
+    char thumb_path[4096];
+    coverloader_thumb_path(thumb_path, req);
+    if (cover_is_placeholder(full_width, full_height)) {
         SDL_FreeSurface(decoded);
+        thumbcache_write_placeholder(thumb_path);
         return false;
     }
-    double srcratio = sw / (double) sh, dstratio = req->target_width / (double) req->target_height;
+    double srcratio = decoded->w / (double) decoded->h;
+    double dstratio = req->target_width / (double) req->target_height;
     SDL_Rect srcrect;
     if (srcratio > dstratio) {
         // Source is wider than destination
-        srcrect.h = sh;
-        srcrect.w = (int) (sh * dstratio);
+        srcrect.h = decoded->h;
+        srcrect.w = (int) (decoded->h * dstratio);
         srcrect.y = 0;
-        srcrect.x = (sw - srcrect.w) / 2;
+        srcrect.x = (decoded->w - srcrect.w) / 2;
     } else {
         // Destination is wider than source
-        srcrect.w = sw;
-        srcrect.h = (int) (sw / dstratio);
+        srcrect.w = decoded->w;
+        srcrect.h = (int) (decoded->w / dstratio);
         srcrect.x = 0;
-        srcrect.y = (sh - srcrect.h) / 2;
+        srcrect.y = (decoded->h - srcrect.h) / 2;
     }
+    if (srcrect.w <= 0 || srcrect.h <= 0) {
+        // Image is too small to display
+        SDL_FreeSurface(decoded);
+        return false;
+    }
+    bool alpha = SDL_ISPIXELFORMAT_ALPHA(decoded->format->format);
+    // Crop and scale to the exact display size in one pass
+    SDL_Surface *result = img_scale_surface(decoded, &srcrect, req->target_width, req->target_height,
+                                            IMG_SCALE_AUTO);
+    SDL_FreeSurface(decoded);
+    if (result == NULL) {
+        commons_log_warn("CoverLoader", "Failed to scale cover %s: %s", path, SDL_GetError());
+        return false;
+    }
+    commons_log_debug("CoverLoader", "Decoded %dx%d cover as %dx%d (%zu KB) and scaled it in %.1f ms",
+                      full_width, full_height, decoded_width, decoded_height, decoded_bytes / 1024,
+                      (double) (SDL_GetPerformanceCounter() - decode_start) * 1000.0 / SDL_GetPerformanceFrequency());
     subimage_info_t *info = SDL_malloc(sizeof(subimage_info_t));
     info->w = req->target_width;
     info->h = req->target_height;
-    info->rect = srcrect;
-
-    if (sw == decoded->w && sh == decoded->h) {
-        decoded->userdata = info;
-        req->cached = decoded;
-        return true;
+    info->rect = (SDL_Rect) {0, 0, req->target_width, req->target_height};
+    info->alpha = alpha;
+    info->from_thumbcache = false;
+
+    // Convert here, so the texture can be uploaded as is on main thread
+    Uint32 texture_format = req->loader->texture_format;
+    if (texture_format != SDL_PIXELFORMAT_UNKNOWN && result->format->format != texture_format) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(result, texture_format, 0);
+        if (converted != NULL) {
+            SDL_FreeSurface(result);
+            result = converted;
+        }
     }
-
-    const SDL_PixelFormat *format = decoded->format;
-    SDL_Surface *scaled = SDL_CreateRGBSurface(0, sw, sh, format->BitsPerPixel,
-                                               format->Rmask, format->Gmask, format->Bmask, format->Amask);
-    SDL_BlitScaled(decoded, NULL, scaled, NULL);
-    SDL_FreeSurface(decoded);
-    scaled->userdata = info;
-    req->cached = scaled;
+    thumbcache_meta_t meta = {.width = info->w, .height = info->h, .rect = info->rect, .alpha = info->alpha};
+    thumbcache_write(thumb_path, result, &meta);
+    result->userdata = info;
+    req->cached = result;
     return true;
 }
 
-static bool cover_is_placeholder(const SDL_Surface *surface) {
-    return (surface->w == 130 && surface->h == 180) || (surface->w == 628 && surface->h == 888);
+static void cover_surface_free(SDL_Surface *surface) {
+    subimage_info_t *info = surface->userdata;
+    bool from_thumbcache = info != NULL && info->from_thumbcache;
+    SDL_free(info);
+    surface->userdata = NULL;
+    if (from_thumbcache) {
+        thumbcache_surface_free(surface);
+    } else {
+        SDL_FreeSurface(surface);
+    }
+}
+
+static bool cover_is_placeholder(int width, int height) {
+    return (width == 130 && height == 180) || (width == 628 && height == 888);
 }
 
 static void coverloader_filecache_put(coverloader_req_t *req) {
@@ -391,7 +564,8 @@ static bool coverloader_fetch(coverloader_req_t *req) {
     if (gs_download_cover(client, node->server, req->id, path) != GS_OK) {
         return false;
     }
-    return coverloader_filecache_get(req);
+    // Thumbnail may be outdated, decode the new cover
+    return coverloader_decode_cover(req);
 }
 
 static void coverloader_run_on_main(img_loader_t *loader, img_loader_run_on_main_fn fn, void *args) {
@@ -400,6 +574,9 @@ static void coverloader_run_on_main(img_loader_t *loader, img_loader_run_on_main
 }
 
 static void img_loader_start_cb(coverloader_req_t *req) {
+    if (req->target == NULL) {
+        return;
+    }
     appitem_viewholder_t *holder = req->target->user_data;
     img_set_cover(req->target, NULL);
     lv_obj_add_flag(holder->title, LV_OBJ_FLAG_HIDDEN);
@@ -407,12 +584,20 @@ static void img_loader_start_cb(coverloader_req_t *req) {
 
 static void img_loader_result_cb(coverloader_req_t *req) {
     req->task = NULL;
+    if (req->upload_pending) {
+        return;
+    }
     coverloader_t *loader = req->loader;
     if (req->target == NULL) {
         goto done;
     }
 
-    lv_obj_remove_event_cb(req->target, target_deleted_cb);
+    // Target may have been recycled, and hold callbacks of a newer request
+    lv_obj_remove_event_cb_with_user_data(req->target, target_deleted_cb, req);
+    if (req->cancelled) {
+        // Finished before cancellation was handled, the target may show another app by now
+        goto done;
+    }
     appitem_viewholder_t *holder = req->target->user_data;
     img_set_cover(req->target, req->src);
     if (req->src) {
@@ -427,8 +612,13 @@ static void img_loader_result_cb(coverloader_req_t *req) {
 }
 
 static void img_loader_cancel_cb(coverloader_req_t *req) {
+    req->task = NULL;
+    if (req->upload_pending) {
+        req->cancelled = true;
+        return;
+    }
     if (req->target) {
-        lv_obj_remove_event_cb(req->target, target_deleted_cb);
+        lv_obj_remove_event_cb_with_user_data(req->target, target_deleted_cb, req);
     }
     req->task = NULL;
     coverloader_t *loader = req->loader;
@@ -465,8 +655,9 @@ static void img_set_cover(lv_obj_t *obj, memcache_item_t *src) {
     }
 }
 
-struct memcache_item_t *memcache_item_new() {
+struct memcache_item_t *memcache_item_new(coverloader_t *loader) {
     memcache_item_t *item = calloc(1, sizeof(memcache_item_t));
+    item->loader = loader;
     _lv_ll_init(&item->objs, sizeof(lv_obj_t *));
     return item;
 }
@@ -493,9 +684,47 @@ static void memcache_item_free(memcache_item_t *item) {
 
     /* unref all objs to this item */
     _lv_ll_clear(&item->objs);
+
+    coverloader_stats_t *stats = &item->loader->stats;
+    stats->bytes -= item->bytes;
+    if (!item->loader->destroying) {
+        stats->evictions++;
+    }
     free(item);
 }
 
+static void memcache_key_init(memcache_key_t *key, const coverloader_req_t *req) {
+    // Key is hashed as raw bytes, so padding must be zeroed
+    memset(key, 0, sizeof(memcache_key_t));
+    key->server_id = req->server_id;
+    key->id = req->id;
+    key->target_width = req->target_width;
+    key->target_height = req->target_height;
+}
+
+static size_t memcache_budget(const app_settings_t *settings) {
+    if (settings->cover_cache_size > 0) {
+        return (size_t) settings->cover_cache_size * 1024 * 1024;
+    }
+    int mb = SDL_GetSystemRAM() / 64;
+    if (mb < MEMCACHE_AUTO_MIN_MB) {
+        mb = MEMCACHE_AUTO_MIN_MB;
+    } else if (mb > MEMCACHE_AUTO_MAX_MB) {
+        mb = MEMCACHE_AUTO_MAX_MB;
+    }
+    return (size_t) mb * 1024 * 1024;
+}
+
+static size_t texture_bytes(SDL_Texture *texture, const SDL_Surface *surface) {
+    Uint32 format;
+    int w, h;
+    if (texture != NULL && SDL_QueryTexture(texture, &format, NULL, &w, &h) == 0 &&
+        !SDL_ISPIXELFORMAT_FOURCC(format)) {
+        return (size_t) w * h * SDL_BYTESPERPIXEL(format);
+    }
+    return (size_t) surface->pitch * surface->h;
+}
+
 static void purge_img_cache(lv_draw_sdl_ctx_t *ctx, const memcache_item_t *item) {
     struct __attribute__ ((__packed__)) {
         lv_draw_sdl_cache_key_head_img_t header;
@@ -544,12 +773,192 @@ static void memcache_item_unref_obj(memcache_item_t *item, const lv_obj_t *obj)
     lv_mem_free(i);
 }
 
+static SDL_Renderer *coverloader_renderer() {
+    lv_draw_sdl_drv_param_t *param = lv_disp_get_default()->driver->user_data;
+    return param->renderer;
+}
+
+/**
+ * @return 32-bit format with alpha channel the renderer supports natively, or SDL_PIXELFORMAT_UNKNOWN
+ */
+static Uint32 renderer_texture_format(SDL_Renderer *renderer) {
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) != 0) {
+        return SDL_PIXELFORMAT_UNKNOWN;
+    }
+    for (Uint32 i = 0; i < info.num_texture_formats; i++) {
+        Uint32 format = info.texture_formats[i];
+        if (!SDL_ISPIXELFORMAT_FOURCC(format) && SDL_BITSPERPIXEL(format) == 32 && SDL_ISPIXELFORMAT_ALPHA(format)) {
+            return format;
+        }
+    }
+    return SDL_PIXELFORMAT_UNKNOWN;
+}
+
+static SDL_Texture *create_texture(SDL_Renderer *renderer, SDL_Surface *surface, bool alpha) {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, surface->format->format, SDL_TEXTUREACCESS_STATIC,
+                                             surface->w, surface->h);
+    if (texture == NULL) {
+        // Not a format the renderer takes as is
+        return SDL_CreateTextureFromSurface(renderer, surface);
+    }
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_LockSurface(surface);
+    }
+    SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_UnlockSurface(surface);
+    }
+    SDL_SetTextureBlendMode(texture, alpha ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+    return texture;
+}
+
+static void upload_enqueue(coverloader_t *loader, coverloader_req_t *req) {
+    req->upload_pending = true;
+    coverloader_req_t **node = _lv_ll_ins_tail(&loader->upload_queue);
+    *node = req;
+    lv_timer_resume(loader->upload_timer);
+}
+
+static void stats_timer_cb(lv_timer_t *timer) {
+    coverloader_t *loader = timer->user_data;
+    unsigned int lookups = loader->stats.hits + loader->stats.misses;
+    if (lookups == loader->stats_logged_lookups) {
+        return;
+    }
+    loader->stats_logged_lookups = lookups;
+    stats_log(loader, false);
+}
+
+static void stats_log(coverloader_t *loader, bool final) {
+    const coverloader_stats_t *stats = &loader->stats;
+    if (final) {
+        commons_log_info("CoverLoader", "Memory cache: %u hits, %u misses, %u evictions, %zu/%zu KB in use",
+                         stats->hits, stats->misses, stats->evictions, stats->bytes / 1024, stats->budget / 1024);
+    } else {
+        commons_log_debug("CoverLoader", "Memory cache: %u hits, %u misses, %u evictions, %zu/%zu KB in use",
+                          stats->hits, stats->misses, stats->evictions, stats->bytes / 1024, stats->budget / 1024);
+    }
+}
+
+static void upload_timer_cb(lv_timer_t *timer) {
+    coverloader_t *loader = timer->user_data;
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    size_t bytes = 0;
+    coverloader_req_t *req;
+    // Covers on screen go first
+    while (upload_take(loader, &req, true) || upload_take(loader, &req, false)) {
+        bytes += upload_cover(req);
+        req->upload_pending = false;
+        bool empty = _lv_ll_get_head(&loader->upload_queue) == NULL;
+        if (empty) {
+            lv_timer_pause(timer);
+        }
+        // May free the loader if this was the last request
+        if (req->cancelled) {
+            img_loader_cancel_cb(req);
+        } else {
+            img_loader_result_cb(req);
+        }
+        if (empty) {
+            return;
+        }
+        Uint64 elapsed_us = (SDL_GetPerformanceCounter() - start) * 1000000 / freq;
+        if (elapsed_us >= UPLOAD_BUDGET_US || bytes >= UPLOAD_BUDGET_BYTES) {
+            return;
+        }
+    }
+}
+
+static bool upload_take(coverloader_t *loader, coverloader_req_t **out, bool visible_only) {
+    coverloader_req_t **node;
+    _LV_LL_READ(&loader->upload_queue, node) {
+        coverloader_req_t *req = *node;
+        if (visible_only && (req->target == NULL || !lv_obj_is_visible(req->target))) {
+            continue;
+        }
+        _lv_ll_remove(&loader->upload_queue, node);
+        lv_mem_free(node);
+        *out = req;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Create texture for the decoded cover and put it into memory cache
+ * @return Number of bytes uploaded
+ */
+static size_t upload_cover(coverloader_req_t *req) {
+    SDL_Surface *cached = req->cached;
+    subimage_info_t *info = cached->userdata;
+    memcache_key_t key;
+    memcache_key_init(&key, req);
+    memcache_item_t *result = NULL;
+    size_t bytes = 0;
+    // Same cover may have been queued twice
+    lv_lru_get(req->loader->mem_cache, &key, sizeof(key), (void **) &result);
+    if (result == NULL) {
+        result = memcache_item_new(req->loader);
+        result->target_width = req->target_width;
+        result->target_height = req->target_height;
+        // Target may have been deleted if the request was cancelled
+        result->target_radius = req->target != NULL ? lv_obj_get_style_radius(req->target, 0) : 0;
+        lv_img_dsc_t *src = &result->src;
+        lv_sdl_img_data_t *data = &result->data;
+        data->type = LV_SDL_IMG_TYPE_TEXTURE;
+        src->header.cf = info->alpha ? LV_IMG_CF_TRUE_COLOR_ALPHA : LV_IMG_CF_TRUE_COLOR;
+        data->rect = info->rect;
+        src->header.w = info->w;
+        src->header.h = info->h;
+        data->data.texture = create_texture(coverloader_renderer(), cached, info->alpha);
+        src->data_size = sizeof(lv_sdl_img_data_t);
+        src->data = (const uint8_t *) data;
+        result->bytes = texture_bytes(data->data.texture, cached);
+        req->loader->stats.bytes += result->bytes;
+        lv_lru_set(req->loader->mem_cache, &key, sizeof(key), result, result->bytes);
+        bytes = cached->pitch * cached->h;
+    }
+    req->src = result;
+    req->finished = true;
+    req->cached = NULL;
+    cover_surface_free(cached);
+    return bytes;
+}
+
 static inline void coverloader_req_free(coverloader_req_t *req) {
     free(req);
 }
 
 static int reqlist_find_by_target(coverloader_req_t *p, const void *v) {
-    return p->target != v;
+    // Cancelled requests may still point to a target that has been handed to a newer one
+    return p->target != v || p->cancelled;
+}
+
+static coverloader_req_t *coverloader_req_new(coverloader_t *loader, const uuidstr_t *uuid, int id,
+                                              lv_coord_t target_width, lv_coord_t target_height) {
+    coverloader_req_t *req = reqlist_new();
+    req->loader = loader;
+    req->server_id = *uuid;
+    req->id = id;
+    req->target_width = target_width;
+    req->target_height = target_height;
+    req->finished = false;
+    loader->reqlist = reqlist_append(loader->reqlist, req);
+    refcounter_ref(&loader->refcounter);
+    return req;
+}
+
+static coverloader_req_t *reqlist_find_same_cover(coverloader_req_t *head, const uuidstr_t *uuid, int id,
+                                                  lv_coord_t target_width, lv_coord_t target_height) {
+    for (coverloader_req_t *cur = head; cur != NULL; cur = cur->next) {
+        if (cur->id == id && !cur->cancelled && uuidstr_t_equals_t(&cur->server_id, uuid) &&
+            cur->target_width == target_width && cur->target_height == target_height) {
+            return cur;
+        }
+    }
+    return NULL;
 }
 
 static void target_deleted_cb(lv_event_t *e) {
@@ -3,6 +3,7 @@
 #include "backend/pcmanager.h"
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "libgamestream/client.h"
 #include "lv_sdl_img.h"
@@ -12,9 +13,30 @@ struct coverloader_t;
 typedef struct app_t app_t;
 typedef struct coverloader_t coverloader_t;
 
+typedef struct coverloader_stats_t {
+    /* Memory cache lookups */
+    unsigned int hits, misses;
+    /* Covers dropped to stay within budget */
+    unsigned int evictions;
+    /* Texture memory in use, and the limit */
+    size_t bytes, budget;
+} coverloader_stats_t;
+
 coverloader_t *coverloader_new(app_t *app);
 
 void coverloader_unref(coverloader_t *loader);
 
 void coverloader_display(coverloader_t *loader, const uuidstr_t *uuid, int id, lv_obj_t *target,
-                         lv_coord_t target_width, lv_coord_t target_height);
\ No newline at end of file
+                         lv_coord_t target_width, lv_coord_t target_height);
+
+/**
+ * Load covers into memory cache ahead of display. They run after every pending coverloader_display() request.
+ * Prefetches of covers not in ids are cancelled, so pass every cover still wanted each time.
+ */
+void coverloader_prefetch(coverloader_t *loader, const uuidstr_t *uuid, const int *ids, int count,
+                          lv_coord_t target_width, lv_coord_t target_height);
+
+/**
+ * Demote display requests whose target has scrolled out of view, and promote those back in view.
+ */
+void coverloader_update_priorities(coverloader_t *loader);
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "app.h"
 #include "app_session.h"
 #include "streaming.controller.h"
+#include "stream/audio/session_audio.h"
 #include "stream/video/session_video.h"
 #include "ui/root.h"
 #include "ui/common/progress_dialog.h"
@@ -40,6 +41,8 @@ static void update_buttons_layout(streaming_controller_t *controller);
 
 static void pin_toggle(lv_event_t *e);
 
+static void set_latency_text(lv_obj_t *label, const latency_histogram_t *histogram);
+
 const lv_fragment_class_t streaming_controller_class = {
         .constructor_cb = constructor,
         .destructor_cb = controller_dtor,
@@ -69,7 +72,9 @@ bool streaming_refresh_stats() {
         return false;
     }
     app_t *app = controller->global;
-    const struct VIDEO_STATS *dst = &vdec_summary_stats;
+    struct VIDEO_STATS summary;
+    vdec_stats_snapshot(&summary);
+    const struct VIDEO_STATS *dst = &summary;
     const struct VIDEO_INFO *info = &vdec_stream_info;
     if (info->width > 0 && info->height > 0) {
         lv_label_set_text_fmt(controller->stats_items.resolution, "%d * %d", info->width, info->height);
@@ -81,6 +86,22 @@ bool streaming_refresh_stats() {
                           SS4S_ModuleInfoGetId(app->ss4s.selection.video_module), vdec_stream_info.format);
     lv_label_set_text_fmt(controller->stats_items.audio, "%s (%s)",
                           SS4S_ModuleInfoGetId(app->ss4s.selection.audio_module), audio_stream_info.format);
+    struct AUDIO_STATS audio_summary;
+    audio_stats_snapshot(&audio_summary);
+    const struct AUDIO_STATS *audio_stats = &audio_summary;
+    if (audio_stats->latencyTargetMs > 0) {
+        lv_label_set_text_fmt(controller->stats_items.audio_queue, "%.1f ms (target %d ms), drift %+.0f ppm",
+                              audio_stats->queueDepthMs, audio_stats->latencyTargetMs, audio_stats->driftPpm);
+    } else {
+        lv_label_set_text(controller->stats_items.audio_queue, "not controlled");
+    }
+    lv_label_set_text_fmt(controller->stats_items.audio_corrections,
+                          "%u concealed, %u dropped, %u underruns, %+d samples", audio_stats->concealedFrames,
+                          audio_stats->droppedFrames, audio_stats->underruns,
+                          (int) audio_stats->insertedSamples - (int) audio_stats->droppedSamples);
+    lv_label_set_text_fmt(controller->stats_items.audio_packets, "%d (max %d), %d dropped",
+                          audio_stats->packetQueueDepth, audio_stats->packetQueueHighWater,
+                          audio_stats->packetQueueOverflows);
     lv_label_set_text_fmt(controller->stats_items.rtt, "%d ms (var. %d ms)", dst->rtt, dst->rttVariance);
     lv_label_set_text_fmt(controller->stats_items.net_fps, "%.2f FPS", dst->receivedFps);
 
@@ -88,8 +109,7 @@ bool streaming_refresh_stats() {
         lv_label_set_text_fmt(controller->stats_items.drop_rate, "%.2f%%",
                               (float) dst->networkDroppedFrames / (float) dst->totalFrames * 100);
         if (vdec_stream_info.has_host_latency) {
-            float avgCapLatency = (float) dst->totalCaptureLatency / (float) dst->submittedFrames / 10.0f;
-            lv_label_set_text_fmt(controller->stats_items.host_latency, "avg %.2f ms", avgCapLatency);
+            set_latency_text(controller->stats_items.host_latency, &dst->captureLatency);
         } else {
             lv_label_set_text_fmt(controller->stats_items.host_latency, "not available");
         }
@@ -100,14 +120,37 @@ bool streaming_refresh_stats() {
         } else {
             lv_label_set_text_fmt(controller->stats_items.vdec_latency, "not available");
         }
+        set_latency_text(controller->stats_items.reassembly_time, &dst->reassemblyTime);
+        set_latency_text(controller->stats_items.submit_time, &dst->submitTime);
+        lv_label_set_text_fmt(controller->stats_items.frame_copies, "%u / %u", dst->copiedFrames,
+                              dst->submittedFrames);
     } else {
         lv_label_set_text(controller->stats_items.drop_rate, "-");
         lv_label_set_text_fmt(controller->stats_items.host_latency, "-");
         lv_label_set_text_fmt(controller->stats_items.vdec_latency, "-");
+        lv_label_set_text(controller->stats_items.reassembly_time, "-");
+        lv_label_set_text(controller->stats_items.submit_time, "-");
+        lv_label_set_text(controller->stats_items.frame_copies, "-");
     }
+    // Frames may be dropped while none gets submitted
+    lv_label_set_text_fmt(controller->stats_items.frame_drops, "%u (%u oversized)", dst->droppedFrames,
+                          dst->oversizedFrames);
     return true;
 }
 
+static void set_latency_text(lv_obj_t *label, const latency_histogram_t *histogram) {
+    if (histogram->count == 0) {
+        lv_label_set_text(label, "-");
+        return;
+    }
+    // Percentiles are bucket bounds, 0.1 ms precision is all they have
+    lv_label_set_text_fmt(label, "p50 %.1f / p95 %.1f / p99 %.1f ms, max %.2f ms",
+                          latency_histogram_percentile(histogram, 50) / 1000.0,
+                          latency_histogram_percentile(histogram, 95) / 1000.0,
+                          latency_histogram_percentile(histogram, 99) / 1000.0,
+                          histogram->max_us / 1000.0);
+}
+
 void streaming_notice_show(const char *message) {
     streaming_controller_t *controller = current_controller;
     if (!controller) { return; }
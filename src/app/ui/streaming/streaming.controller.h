@@ -24,11 +24,18 @@ typedef struct {
         lv_obj_t *resolution;
         lv_obj_t *decoder;
         lv_obj_t *audio;
+        lv_obj_t *audio_queue;
+        lv_obj_t *audio_corrections;
+        lv_obj_t *audio_packets;
         lv_obj_t *rtt;
         lv_obj_t *net_fps;
         lv_obj_t *drop_rate;
         lv_obj_t *host_latency;
+        lv_obj_t *reassembly_time;
+        lv_obj_t *submit_time;
         lv_obj_t *vdec_latency;
+        lv_obj_t *frame_copies;
+        lv_obj_t *frame_drops;
     } stats_items;
     lv_obj_t *stats_pin;
     lv_obj_t *notice, *notice_label;
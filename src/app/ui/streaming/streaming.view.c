@@ -127,12 +127,19 @@ lv_obj_t *streaming_scene_create(lv_fragment_t *self, lv_obj_t *parent) {
     controller->stats_items.resolution = stat_label(stats, "Resolution");
     controller->stats_items.decoder = stat_label(stats, "Decoder");
     controller->stats_items.audio = stat_label(stats, "Audio backend");
+    controller->stats_items.audio_queue = stat_label(stats, "Audio queue");
+    controller->stats_items.audio_corrections = stat_label(stats, "Audio corrections");
+    controller->stats_items.audio_packets = stat_label(stats, "Audio packet queue");
 
     controller->stats_items.rtt = stat_label(stats, "Network RTT");
     controller->stats_items.net_fps = stat_label(stats, "Network framerate");
     controller->stats_items.drop_rate = stat_label(stats, "Network frame drop");
     controller->stats_items.host_latency = stat_label(stats, "Host processing latency");
+    controller->stats_items.reassembly_time = stat_label(stats, "Frame reassembly time");
+    controller->stats_items.submit_time = stat_label(stats, "Frame submit time");
     controller->stats_items.vdec_latency = stat_label(stats, "Decoder latency");
+    controller->stats_items.frame_copies = stat_label(stats, "Copied frames");
+    controller->stats_items.frame_drops = stat_label(stats, "Decoder frame drop");
 
 
     lv_obj_add_flag(overlay, LV_OBJ_FLAG_HIDDEN);
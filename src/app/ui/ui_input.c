@@ -4,8 +4,14 @@
 #include "lvgl/lv_sdl_drv_input.h"
 #include "logging.h"
 
+#define UI_INPUT_IDLE_GRACE_MS 1000
+
 static void app_input_populate_group(app_ui_input_t *input);
 
+static void app_input_set_reading_paused(app_ui_input_t *input, bool paused);
+
+static bool indev_pressed(const lv_indev_t *indev);
+
 static void app_input_apply_text_input_mode(app_ui_input_t *input);
 
 static const lv_point_t button_points_empty[5] = {
@@ -39,6 +45,8 @@ void app_ui_input_init(app_ui_input_t *input, app_ui_t *ui) {
     }
 
     lv_indev_set_button_points(input->button.indev, button_points_empty);
+    input->reading_paused = false;
+    input->last_active = lv_tick_get();
 }
 
 void app_ui_input_deinit(app_ui_input_t *input) {
@@ -55,6 +63,18 @@ void app_ui_input_deinit(app_ui_input_t *input) {
     _lv_ll_clear(&input->modal_groups);
 }
 
+void app_ui_input_update_reading(app_ui_input_t *input, bool events_pending) {
+    if (input->key.indev == NULL) {
+        return;
+    }
+    // Keep reading while keys are held, so long press and repeat still work
+    if (events_pending || indev_pressed(input->key.indev) || indev_pressed(input->pointer.indev) ||
+        indev_pressed(input->button.indev)) {
+        input->last_active = lv_tick_get();
+    }
+    app_input_set_reading_paused(input, lv_tick_elaps(input->last_active) >= UI_INPUT_IDLE_GRACE_MS);
+}
+
 void app_input_set_group(app_ui_input_t *input, lv_group_t *group) {
     input->app_group = group;
     app_input_populate_group(input);
@@ -140,6 +160,27 @@ static void app_input_populate_group(app_ui_input_t *input) {
     }
 }
 
+static void app_input_set_reading_paused(app_ui_input_t *input, bool paused) {
+    if (input->reading_paused == paused) {
+        return;
+    }
+    lv_indev_t *indevs[] = {input->key.indev, input->pointer.indev, input->wheel.indev, input->button.indev};
+    for (size_t i = 0; i < sizeof(indevs) / sizeof(lv_indev_t *); i++) {
+        lv_timer_t *timer = indevs[i]->driver->read_timer;
+        if (paused) {
+            lv_timer_pause(timer);
+        } else {
+            lv_timer_resume(timer);
+            lv_timer_ready(timer);
+        }
+    }
+    input->reading_paused = paused;
+}
+
+static bool indev_pressed(const lv_indev_t *indev) {
+    return indev->proc.state == LV_INDEV_STATE_PRESSED;
+}
+
 static void app_input_apply_text_input_mode(app_ui_input_t *input) {
     if (input->text_input_active == SDL_IsTextInputActive()) {
         return;
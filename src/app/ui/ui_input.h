@@ -35,12 +35,21 @@ struct app_ui_input_t {
     app_ui_input_lv_pair_t button;
     app_ui_input_mode_t mode;
     bool text_input_active;
+    /* Input devices are not read while idle, so the main loop can sleep */
+    bool reading_paused;
+    uint32_t last_active;
 };
 
 void app_ui_input_init(app_ui_input_t *input, app_ui_t *ui);
 
 void app_ui_input_deinit(app_ui_input_t *input);
 
+/**
+ * Pause reading input devices after a while without input, and resume it once events arrive.
+ * @param events_pending there are events in the SDL queue
+ */
+void app_ui_input_update_reading(app_ui_input_t *input, bool events_pending);
+
 void app_input_set_group(app_ui_input_t *input, lv_group_t *group);
 
 void app_input_push_modal_group(app_ui_input_t *input, lv_group_t *group);
@@ -2,20 +2,34 @@
 
 #include <stdbool.h>
 
-#define BUS_INT_EVENT_ACTION 99
+#define BUS_INT_EVENT_WAKEUP 99
 #define BUS_EVENT_START 100
 
 typedef void(*bus_actionfunc)(void *);
 
 typedef struct app_t app_t;
 
+void app_bus_init();
+
+void app_bus_deinit();
+
 bool bus_pushevent(int which, void *data1, void *data2);
 
 bool app_bus_post(app_t *app, bus_actionfunc action, void *data);
 
 bool app_bus_post_sync(app_t *app, bus_actionfunc action, void *data);
 
+/**
+ * Run posted actions. Must be called from the main thread.
+ */
+void app_bus_dispatch();
+
 /**
  * Drain all bus events
  */
-void app_bus_drain();
\ No newline at end of file
+void app_bus_drain();
+
+/**
+ * Log and reset queue latency and depth of posted actions
+ */
+void app_bus_log_stats();
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "app.h"
 #include "img_loader.h"
-#include "executor.h"
+#include "refcounter.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -8,55 +8,98 @@
 
 #include <SDL2/SDL.h>
 
+/*
+ * Worker stages (file cache, fetch) run on the executor and never wait for the main thread. The result is handed
+ * over with a single run_on_main call, where memory cache and callbacks are handled.
+ *
+ * Only max_in_flight tasks are submitted to the executor at a time, the rest wait in per-priority queues. A worker
+ * submits the next pending task as soon as it's done, so throughput doesn't depend on the main thread either.
+ */
+
 struct img_loader_task_t {
     void *request;
-    void *result;
     img_loader_cb_t cb;
     struct img_loader_t *loader;
-    const executor_task_t *task;
+    SDL_atomic_t cancelled;
+    /* Set by the worker when the image is ready to be put into memory cache */
+    bool loaded;
+    int result;
+    img_loader_priority_t priority;
+    /* Executor task while the worker stages run, so cancellation can reach requests in flight */
+    lane_task_id_t executor_task;
+    /* Handed to the executor, otherwise it's in a pending queue */
+    bool submitted;
+    struct img_loader_task_t *prev, *next;
 };
 
+typedef struct task_queue_t {
+    img_loader_task_t *head, *tail;
+} task_queue_t;
+
 struct img_loader_t {
     img_loader_impl_t impl;
-    executor_t *executor;
+    lane_executor_t *executor;
+    executor_lane_t lane;
+    /* Guards pending queues, in_flight and submitted/priority of tasks */
+    SDL_mutex *lock;
+    task_queue_t pending[IMG_LOADER_PRIORITY_COUNT];
+    int in_flight, max_in_flight;
+    refcounter_t refcounter;
+    /* Set on the main thread, workers read it under lock */
     bool destroyed;
 };
 
-typedef struct notify_cb_t {
-    img_loader_fn fn;
-    img_loader_req_t *req;
-    bool notified;
-    SDL_mutex *mutex;
-    SDL_cond *cond;
-    const bool *destroyed;
-} notify_cb_t;
-
 static int task_execute(img_loader_task_t *task);
 
+static int task_run_stages(img_loader_task_t *task);
+
 static bool task_cancelled(img_loader_task_t *task);
 
-static void task_destroy(img_loader_task_t *task, int result);
+static bool loader_destroyed(img_loader_t *loader);
+
+static void task_finalize(img_loader_task_t *task, int result);
 
-static void notify_cb(notify_cb_t *args);
+static void task_finish(img_loader_task_t *task);
 
-static void run_on_main(img_loader_t *loader, img_loader_fn fn, img_loader_req_t *arg1);
+static void img_loader_unref(img_loader_t *loader);
 
-static void img_loader_free(void *arg, int result);
+static void img_loader_pump(img_loader_t *loader);
 
-img_loader_t *img_loader_create(const img_loader_impl_t *impl, executor_t *executor) {
+static void queue_append(task_queue_t *queue, img_loader_task_t *task);
+
+static void queue_remove(task_queue_t *queue, img_loader_task_t *task);
+
+img_loader_t *img_loader_create(const img_loader_impl_t *impl, lane_executor_t *executor, executor_lane_t lane,
+                                int max_in_flight) {
     img_loader_t *loader = SDL_calloc(1, sizeof(img_loader_t));
     loader->impl = *impl;
     loader->executor = executor;
+    loader->lane = lane;
+    loader->lock = SDL_CreateMutex();
+    loader->max_in_flight = max_in_flight > 0 ? max_in_flight : 1;
+    refcounter_init(&loader->refcounter);
     return loader;
 }
 
 void img_loader_destroy(img_loader_t *loader) {
     SDL_assert_release(!loader->destroyed);
+    // Tasks never submitted still hold references, finish them without callbacks
+    SDL_LockMutex(loader->lock);
     loader->destroyed = true;
-    executor_submit(loader->executor, executor_noop, img_loader_free, loader);
+    for (int i = 0; i < IMG_LOADER_PRIORITY_COUNT; i++) {
+        img_loader_task_t *task;
+        while ((task = loader->pending[i].head) != NULL) {
+            queue_remove(&loader->pending[i], task);
+            task->result = ECANCELED;
+            loader->impl.run_on_main(loader, (img_loader_run_on_main_fn) task_finish, task);
+        }
+    }
+    SDL_UnlockMutex(loader->lock);
+    img_loader_unref(loader);
 }
 
-img_loader_task_t *img_loader_load(img_loader_t *loader, img_loader_req_t *request, const img_loader_cb_t *cb) {
+img_loader_task_t *img_loader_load(img_loader_t *loader, img_loader_req_t *request, const img_loader_cb_t *cb,
+                                   img_loader_priority_t priority) {
     SDL_assert_release(!loader->destroyed);
     cb->start_cb(request);
     // Memory cache found, finish loading
@@ -68,77 +111,179 @@ img_loader_task_t *img_loader_load(img_loader_t *loader, img_loader_req_t *reque
     task->loader = loader;
     task->request = request;
     task->cb = *cb;
-    task->task = executor_submit(loader->executor, (executor_action_cb) task_execute,
-                                 (executor_cleanup_cb) task_destroy, task);
+    task->priority = priority;
+    refcounter_ref(&loader->refcounter);
+    SDL_LockMutex(loader->lock);
+    queue_append(&loader->pending[priority], task);
+    SDL_UnlockMutex(loader->lock);
+    img_loader_pump(loader);
     return task;
 }
 
+void img_loader_set_priority(img_loader_t *loader, img_loader_task_t *task, img_loader_priority_t priority) {
+    SDL_assert_release(!loader->destroyed);
+    SDL_LockMutex(loader->lock);
+    if (!task->submitted && task->priority != priority) {
+        queue_remove(&loader->pending[task->priority], task);
+        task->priority = priority;
+        queue_append(&loader->pending[priority], task);
+    }
+    SDL_UnlockMutex(loader->lock);
+}
+
 void img_loader_cancel(img_loader_t *loader, img_loader_task_t *task) {
     SDL_assert_release(!loader->destroyed);
-    executor_cancel(loader->executor, task->task);
+    // Worker checks this between stages, in case it has already started. Only the first cancel does anything else.
+    if (!SDL_AtomicCAS(&task->cancelled, 0, 1)) {
+        return;
+    }
+    SDL_LockMutex(loader->lock);
+    if (task->executor_task != 0) {
+        // Aborts a download in progress, the executor then finalizes the task with ECANCELED
+        lane_executor_cancel(loader->executor, task->executor_task);
+    } else if (!task->submitted) {
+        // Callbacks are always invoked later, never from inside this call
+        queue_remove(&loader->pending[task->priority], task);
+        task->result = ECANCELED;
+        loader->impl.run_on_main(loader, (img_loader_run_on_main_fn) task_finish, task);
+    }
+    SDL_UnlockMutex(loader->lock);
 }
 
 static int task_execute(img_loader_task_t *task) {
+    img_loader_t *loader = task->loader;
+    SDL_LockMutex(loader->lock);
+    task->executor_task = lane_executor_current_task(loader->executor);
+    SDL_UnlockMutex(loader->lock);
+    int result = task_run_stages(task);
+    // Give the slot to the next pending task right away
+    SDL_LockMutex(loader->lock);
+    task->executor_task = 0;
+    loader->in_flight--;
+    SDL_UnlockMutex(loader->lock);
+    img_loader_pump(loader);
+    return result;
+}
+
+static int task_run_stages(img_loader_task_t *task) {
     img_loader_t *loader = task->loader;
     void *request = task->request;
+    if (task_cancelled(task) || loader_destroyed(loader)) {
+        return ECANCELED;
+    }
     if (!loader->impl.filecache_get(request)) {
+        if (task_cancelled(task) || loader_destroyed(loader)) {
+            return ECANCELED;
+        }
         if (!loader->impl.fetch(request)) {
             return EIO;
         }
-        if (loader->destroyed) {
+        // Nobody will use the result, don't touch the file cache of a loader being torn down
+        if (loader_destroyed(loader)) {
             return ECANCELED;
         }
         loader->impl.filecache_put(request);
     }
-    run_on_main(loader, loader->impl.memcache_put, request);
-    return 0;
+    // Loaded image is still useful after cancellation, so it goes into memory cache anyway
+    task->loaded = true;
+    return task_cancelled(task) ? ECANCELED : 0;
+}
+
+/**
+ * Called by the executor when the task is done or cancelled. Hands the task over to the main thread and returns.
+ */
+static void task_finalize(img_loader_task_t *task, int result) {
+    task->result = result;
+    task->loader->impl.run_on_main(task->loader, (img_loader_run_on_main_fn) task_finish, task);
 }
 
-static void task_destroy(img_loader_task_t *task, int result) {
+static void task_finish(img_loader_task_t *task) {
     img_loader_t *loader = task->loader;
     void *request = task->request;
-    if (result == 0) {
-        run_on_main(loader, task->cb.complete_cb, request);
-    } else if (result == ECANCELED) {
-        run_on_main(loader, task->cb.cancel_cb, request);
-    } else {
-        run_on_main(loader, task->cb.fail_cb, request);
+    if (!loader->destroyed) {
+        if (task->loaded) {
+            loader->impl.memcache_put(request);
+        }
+        if (task->result == 0) {
+            task->cb.complete_cb(request);
+        } else if (task->result == ECANCELED) {
+            task->cb.cancel_cb(request);
+        } else {
+            task->cb.fail_cb(request);
+        }
     }
     SDL_free(task);
+    img_loader_unref(loader);
 }
 
 static bool task_cancelled(img_loader_task_t *task) {
-    return executor_task_state(task->loader->executor, task->task);
+    return SDL_AtomicGet(&task->cancelled) != 0;
+}
+
+static bool loader_destroyed(img_loader_t *loader) {
+    SDL_LockMutex(loader->lock);
+    bool destroyed = loader->destroyed;
+    SDL_UnlockMutex(loader->lock);
+    return destroyed;
+}
+
+/**
+ * Submit pending tasks, higher priority first, until max_in_flight is reached
+ */
+static void img_loader_pump(img_loader_t *loader) {
+    for (;;) {
+        img_loader_task_t *task = NULL;
+        SDL_LockMutex(loader->lock);
+        if (loader->in_flight < loader->max_in_flight) {
+            for (int i = 0; i < IMG_LOADER_PRIORITY_COUNT && task == NULL; i++) {
+                task = loader->pending[i].head;
+            }
+        }
+        if (task != NULL) {
+            queue_remove(&loader->pending[task->priority], task);
+            task->submitted = true;
+            loader->in_flight++;
+        }
+        SDL_UnlockMutex(loader->lock);
+        if (task == NULL) {
+            return;
+        }
+        // Not holding the lock, as the executor may have its own
+        lane_executor_submit(loader->executor, loader->lane, (executor_action_cb) task_execute,
+                             (executor_cleanup_cb) task_finalize, task);
+    }
 }
 
-static void run_on_main(img_loader_t *loader, img_loader_fn fn, img_loader_req_t *arg1) {
-    if (loader->destroyed) { return; }
-    notify_cb_t args = {
-            .req = arg1, .fn = fn,
-            .mutex = SDL_CreateMutex(), .cond = SDL_CreateCond(),
-            .destroyed = &loader->destroyed
-    };
-    loader->impl.run_on_main(loader, (img_loader_run_on_main_fn) notify_cb, &args);
-    SDL_LockMutex(args.mutex);
-    while (!args.notified) {
-        SDL_CondWait(args.cond, args.mutex);
+static void queue_append(task_queue_t *queue, img_loader_task_t *task) {
+    task->next = NULL;
+    task->prev = queue->tail;
+    if (queue->tail != NULL) {
+        queue->tail->next = task;
+    } else {
+        queue->head = task;
     }
-    SDL_UnlockMutex(args.mutex);
-    SDL_DestroyMutex(args.mutex);
-    SDL_DestroyCond(args.cond);
+    queue->tail = task;
 }
 
-static void notify_cb(notify_cb_t *args) {
-    SDL_LockMutex(args->mutex);
-    if (!*args->destroyed) {
-        args->fn(args->req);
+static void queue_remove(task_queue_t *queue, img_loader_task_t *task) {
+    if (task->prev != NULL) {
+        task->prev->next = task->next;
+    } else {
+        queue->head = task->next;
+    }
+    if (task->next != NULL) {
+        task->next->prev = task->prev;
+    } else {
+        queue->tail = task->prev;
     }
-    args->notified = true;
-    SDL_CondSignal(args->cond);
-    SDL_UnlockMutex(args->mutex);
+    task->prev = task->next = NULL;
 }
 
-static void img_loader_free(void *arg, int result) {
-    (void) result;
-    free(arg);
-}
\ No newline at end of file
+static void img_loader_unref(img_loader_t *loader) {
+    if (!refcounter_unref(&loader->refcounter)) {
+        return;
+    }
+    refcounter_destroy(&loader->refcounter);
+    SDL_DestroyMutex(loader->lock);
+    SDL_free(loader);
+}
@@ -2,6 +2,8 @@
 
 #include <stdbool.h>
 
+#include "lane_executor.h"
+
 struct img_loader_t;
 struct img_loader_task_t;
 
@@ -15,6 +17,14 @@ typedef bool (*img_loader_get_fn)(img_loader_req_t *req);
 
 typedef void (*img_loader_run_on_main_fn)(void *args);
 
+typedef enum img_loader_priority_t {
+    /* Image is on screen */
+    IMG_LOADER_PRIORITY_VISIBLE = 0,
+    /* Image may be needed soon, only runs when no visible ones are waiting */
+    IMG_LOADER_PRIORITY_PREFETCH,
+    IMG_LOADER_PRIORITY_COUNT,
+} img_loader_priority_t;
+
 typedef struct lv_img_loader_cb_t {
     img_loader_fn start_cb;
 
@@ -36,13 +46,32 @@ typedef struct img_loader_datasource_t {
 
     img_loader_get_fn fetch;
 
+    /**
+     * Schedule fn on the main thread and return immediately. Called from executor threads.
+     */
     void (*run_on_main)(img_loader_t *loader, img_loader_run_on_main_fn fn, void *args);
 } img_loader_impl_t;
 
-img_loader_t *img_loader_create(const img_loader_impl_t *impl, executor_t*executor);
+/**
+ * @param lane Executor lane all tasks are submitted to
+ * @param max_in_flight Tasks submitted to the executor at once. Others wait in the loader, ordered by priority.
+ */
+img_loader_t *img_loader_create(const img_loader_impl_t *impl, lane_executor_t *executor, executor_lane_t lane,
+                                int max_in_flight);
 
 void img_loader_destroy(img_loader_t *loader);
 
-img_loader_task_t *img_loader_load(img_loader_t *loader, img_loader_req_t *request, const img_loader_cb_t *cb);
+img_loader_task_t *img_loader_load(img_loader_t *loader, img_loader_req_t *request, const img_loader_cb_t *cb,
+                                   img_loader_priority_t priority);
+
+/**
+ * Move a task that hasn't been submitted to the executor yet to another priority queue.
+ */
+void img_loader_set_priority(img_loader_t *loader, img_loader_task_t *task, img_loader_priority_t priority);
 
+/**
+ * Cancel a pending task. It stops after the stage in progress, and cancel_cb will be called on the main thread.
+ * A task that already went through all its stages still gets complete_cb or fail_cb.
+ * Cancelling the same task again before its callback is called does nothing.
+ */
 void img_loader_cancel(img_loader_t *loader, img_loader_task_t *task);
\ No newline at end of file
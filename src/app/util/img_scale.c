@@ -0,0 +1,300 @@
+#include "img_scale.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMG_SCALE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IMG_SCALE_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Weights are Q14 fixed point, so pixel * weight fits in int16 multiply-add */
+#define COEF_BITS 14
+#define COEF_ONE (1 << COEF_BITS)
+
+/**
+ * Source taps of each destination pixel along one axis
+ */
+typedef struct scale_axis_t {
+    int *start;
+    int *count;
+    /* max_taps weights for each destination pixel */
+    int16_t *weights;
+    int max_taps;
+} scale_axis_t;
+
+static bool axis_init(scale_axis_t *axis, int src_len, int dst_len, img_scale_filter_t filter);
+
+static void axis_deinit(scale_axis_t *axis);
+
+static void axis_normalize(int16_t *weights, const double *values, int count);
+
+static inline uint32_t load_pixel(const uint8_t *p, int bpp);
+
+static inline void convolve(uint8_t *out, const uint8_t *first, ptrdiff_t step, int bpp, const int16_t *weights,
+                            int count);
+
+int img_scale(const img_scale_src_t *src, uint8_t *dst, int dst_w, int dst_h, int dst_pitch,
+              img_scale_filter_t filter) {
+    const SDL_Rect *rect = &src->rect;
+    if (src->pixels == NULL || dst == NULL || (src->bpp != 3 && src->bpp != 4) || rect->w <= 0 || rect->h <= 0 ||
+        dst_w <= 0 || dst_h <= 0 || dst_pitch < dst_w * 4) {
+        return -1;
+    }
+    if (filter == IMG_SCALE_AUTO) {
+        filter = rect->w >= dst_w && rect->h >= dst_h ? IMG_SCALE_AREA : IMG_SCALE_BILINEAR;
+    }
+    int ret = -1;
+    scale_axis_t horizontal = {0}, vertical = {0};
+    uint8_t *tmp = NULL;
+    bool *rows_used = NULL;
+    if (!axis_init(&horizontal, rect->w, dst_w, filter) || !axis_init(&vertical, rect->h, dst_h, filter)) {
+        goto cleanup;
+    }
+    const size_t tmp_pitch = (size_t) dst_w * 4;
+    tmp = malloc(tmp_pitch * rect->h);
+    rows_used = calloc(rect->h, sizeof(bool));
+    if (tmp == NULL || rows_used == NULL) {
+        goto cleanup;
+    }
+    // Bilinear downscaling skips source rows, don't bother scaling them
+    for (int y = 0; y < dst_h; y++) {
+        for (int k = 0; k < vertical.count[y]; k++) {
+            rows_used[vertical.start[y] + k] = true;
+        }
+    }
+
+    const int bpp = src->bpp;
+    for (int y = 0; y < rect->h; y++) {
+        if (!rows_used[y]) {
+            continue;
+        }
+        const uint8_t *src_row = src->pixels + (size_t) (rect->y + y) * src->pitch + (size_t) rect->x * bpp;
+        uint8_t *tmp_row = tmp + tmp_pitch * y;
+        for (int x = 0; x < dst_w; x++) {
+            convolve(tmp_row + x * 4, src_row + (size_t) horizontal.start[x] * bpp, bpp, bpp,
+                     horizontal.weights + x * horizontal.max_taps, horizontal.count[x]);
+        }
+    }
+    for (int y = 0; y < dst_h; y++) {
+        const uint8_t *tmp_first = tmp + tmp_pitch * vertical.start[y];
+        const int16_t *weights = vertical.weights + y * vertical.max_taps;
+        uint8_t *dst_row = dst + (size_t) y * dst_pitch;
+        for (int x = 0; x < dst_w; x++) {
+            convolve(dst_row + x * 4, tmp_first + x * 4, (ptrdiff_t) tmp_pitch, 4, weights, vertical.count[y]);
+        }
+    }
+    ret = 0;
+
+    cleanup:
+    free(rows_used);
+    free(tmp);
+    axis_deinit(&vertical);
+    axis_deinit(&horizontal);
+    return ret;
+}
+
+SDL_Surface *img_scale_surface(SDL_Surface *surface, const SDL_Rect *rect, int w, int h, img_scale_filter_t filter) {
+    SDL_Surface *converted = NULL, *result = NULL;
+    Uint32 format = surface->format->format;
+    if (surface->format->BytesPerPixel == 3 && (format == SDL_PIXELFORMAT_RGB24 || format == SDL_PIXELFORMAT_BGR24)) {
+        // Keep byte order, and the filled 4th byte becomes alpha
+        format = format == SDL_PIXELFORMAT_RGB24 ? SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_BGRA32;
+    } else if (surface->format->BytesPerPixel != 4 || SDL_ISPIXELFORMAT_FOURCC(format)) {
+        converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        if (converted == NULL) {
+            return NULL;
+        }
+        surface = converted;
+        format = SDL_PIXELFORMAT_ARGB8888;
+    }
+    SDL_Rect full = {0, 0, surface->w, surface->h}, src_rect = full;
+    if (rect != NULL && !SDL_IntersectRect(rect, &full, &src_rect)) {
+        SDL_SetError("Scale source rect is empty");
+        goto cleanup;
+    }
+    result = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+    if (result == NULL) {
+        goto cleanup;
+    }
+    if (SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0) {
+        SDL_FreeSurface(result);
+        result = NULL;
+        goto cleanup;
+    }
+    img_scale_src_t src = {
+            .pixels = surface->pixels,
+            .pitch = surface->pitch,
+            .bpp = surface->format->BytesPerPixel,
+            .rect = src_rect,
+    };
+    int ret = img_scale(&src, result->pixels, w, h, result->pitch, filter);
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_UnlockSurface(surface);
+    }
+    if (ret != 0) {
+        SDL_SetError("Failed to scale %dx%d to %dx%d", src_rect.w, src_rect.h, w, h);
+        SDL_FreeSurface(result);
+        result = NULL;
+    }
+
+    cleanup:
+    if (converted != NULL) {
+        SDL_FreeSurface(converted);
+    }
+    return result;
+}
+
+const char *img_scale_simd_name() {
+#if IMG_SCALE_SSE2
+    return "sse2";
+#elif IMG_SCALE_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+static bool axis_init(scale_axis_t *axis, int src_len, int dst_len, img_scale_filter_t filter) {
+    const double scale = src_len / (double) dst_len;
+    axis->max_taps = filter == IMG_SCALE_AREA ? (int) ceil(scale) + 1 : 2;
+    axis->start = malloc(sizeof(int) * dst_len);
+    axis->count = malloc(sizeof(int) * dst_len);
+    axis->weights = calloc((size_t) dst_len * axis->max_taps, sizeof(int16_t));
+    double *values = malloc(sizeof(double) * axis->max_taps);
+    if (axis->start == NULL || axis->count == NULL || axis->weights == NULL || values == NULL) {
+        free(values);
+        return false;
+    }
+    for (int i = 0; i < dst_len; i++) {
+        int start, count;
+        if (filter == IMG_SCALE_AREA) {
+            double lo = i * scale, hi = (i + 1) * scale;
+            start = (int) floor(lo);
+            int end = (int) ceil(hi);
+            if (end > src_len) {
+                end = src_len;
+            }
+            count = end - start;
+            for (int k = 0; k < count; k++) {
+                double px_lo = start + k, px_hi = start + k + 1;
+                double covered = (hi < px_hi ? hi : px_hi) - (lo > px_lo ? lo : px_lo);
+                values[k] = covered > 0 ? covered / scale : 0;
+            }
+        } else {
+            double center = (i + 0.5) * scale - 0.5;
+            if (center < 0) {
+                center = 0;
+            } else if (center > src_len - 1) {
+                center = src_len - 1;
+            }
+            start = (int) floor(center);
+            double frac = center - start;
+            if (start + 1 < src_len && frac > 0) {
+                count = 2;
+                values[0] = 1 - frac;
+                values[1] = frac;
+            } else {
+                count = 1;
+                values[0] = 1;
+            }
+        }
+        axis->start[i] = start;
+        axis->count[i] = count;
+        axis_normalize(axis->weights + i * axis->max_taps, values, count);
+    }
+    free(values);
+    return true;
+}
+
+static void axis_deinit(scale_axis_t *axis) {
+    free(axis->weights);
+    free(axis->count);
+    free(axis->start);
+}
+
+static void axis_normalize(int16_t *weights, const double *values, int count) {
+    double total = 0;
+    for (int k = 0; k < count; k++) {
+        total += values[k];
+    }
+    int sum = 0, largest = 0;
+    for (int k = 0; k < count; k++) {
+        weights[k] = (int16_t) lround(values[k] / total * COEF_ONE);
+        sum += weights[k];
+        if (weights[k] > weights[largest]) {
+            largest = k;
+        }
+    }
+    // Rounding error goes to the largest tap, so flat colors stay exact
+    weights[largest] = (int16_t) (weights[largest] + COEF_ONE - sum);
+}
+
+static inline uint32_t load_pixel(const uint8_t *p, int bpp) {
+    uint32_t px;
+    if (bpp == 4) {
+        memcpy(&px, p, 4);
+    } else {
+        const uint8_t bytes[4] = {p[0], p[1], p[2], 0xFF};
+        memcpy(&px, bytes, 4);
+    }
+    return px;
+}
+
+static inline void convolve(uint8_t *out, const uint8_t *first, ptrdiff_t step, int bpp, const int16_t *weights,
+                            int count) {
+#if IMG_SCALE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    int k = 0;
+    for (; k + 1 < count; k += 2) {
+        __m128i p = _mm_unpacklo_epi32(_mm_cvtsi32_si128((int) load_pixel(first + k * step, bpp)),
+                                       _mm_cvtsi32_si128((int) load_pixel(first + (k + 1) * step, bpp)));
+        p = _mm_unpacklo_epi8(p, zero);
+        // Interleave channels of both pixels, so one multiply-add sums them
+        p = _mm_unpacklo_epi16(p, _mm_unpackhi_epi64(p, p));
+        const __m128i w = _mm_set1_epi32((int) ((uint16_t) weights[k] | ((uint32_t) (uint16_t) weights[k + 1] << 16)));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(p, w));
+    }
+    if (k < count) {
+        __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) load_pixel(first + k * step, bpp)), zero);
+        p = _mm_unpacklo_epi16(p, zero);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(p, _mm_set1_epi32((uint16_t) weights[k])));
+    }
+    acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << (COEF_BITS - 1))), COEF_BITS);
+    acc = _mm_packs_epi32(acc, acc);
+    acc = _mm_packus_epi16(acc, acc);
+    const uint32_t px = (uint32_t) _mm_cvtsi128_si32(acc);
+    memcpy(out, &px, 4);
+#elif IMG_SCALE_NEON
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int k = 0; k < count; k++) {
+        const uint8x8_t p = vreinterpret_u8_u32(vdup_n_u32(load_pixel(first + k * step, bpp)));
+        acc = vmlal_n_s16(acc, vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(p))), weights[k]);
+    }
+    const int16x4_t narrow = vqrshrn_n_s32(acc, COEF_BITS);
+    const uint8x8_t packed = vqmovun_s16(vcombine_s16(narrow, narrow));
+    const uint32_t px = vget_lane_u32(vreinterpret_u32_u8(packed), 0);
+    memcpy(out, &px, 4);
+#else
+    int32_t acc[4] = {0, 0, 0, 0};
+    for (int k = 0; k < count; k++) {
+        uint8_t p[4];
+        const uint32_t px = load_pixel(first + k * step, bpp);
+        memcpy(p, &px, 4);
+        for (int c = 0; c < 4; c++) {
+            acc[c] += p[c] * weights[k];
+        }
+    }
+    for (int c = 0; c < 4; c++) {
+        const int32_t v = (acc[c] + (1 << (COEF_BITS - 1))) >> COEF_BITS;
+        out[c] = v < 0 ? 0 : v > 255 ? 255 : (uint8_t) v;
+    }
+#endif
+}
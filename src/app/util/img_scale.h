@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <SDL_surface.h>
+
+/*
+ * Crops and resizes 8-bit-per-channel images in a single pass, using SSE2 or NEON when available.
+ * Channel order is kept as is, so the caller decides what the channels mean.
+ */
+
+typedef enum img_scale_filter_t {
+    /* Box filter for downscaling, bilinear for upscaling */
+    IMG_SCALE_AUTO = 0,
+    /* Average of source pixels covered by each destination pixel */
+    IMG_SCALE_AREA,
+    IMG_SCALE_BILINEAR,
+} img_scale_filter_t;
+
+typedef struct img_scale_src_t {
+    const uint8_t *pixels;
+    int pitch;
+    /* 3 or 4. Missing 4th channel is filled with 0xFF */
+    int bpp;
+    /* Region to scale */
+    SDL_Rect rect;
+} img_scale_src_t;
+
+/**
+ * Scale src->rect to fill dst_w x dst_h, 4 bytes per destination pixel.
+ * @return 0 on success, -1 on invalid arguments or out of memory
+ */
+int img_scale(const img_scale_src_t *src, uint8_t *dst, int dst_w, int dst_h, int dst_pitch,
+              img_scale_filter_t filter);
+
+/**
+ * Scale part of a surface into a new 32bpp surface.
+ * 24bpp surfaces become RGBA32/BGRA32, other depths are converted to ARGB8888 first.
+ * @return New surface, or NULL with SDL error set
+ */
+SDL_Surface *img_scale_surface(SDL_Surface *surface, const SDL_Rect *rect, int w, int h, img_scale_filter_t filter);
+
+/**
+ * @return Name of the vector instruction set in use, "scalar" if none
+ */
+const char *img_scale_simd_name();
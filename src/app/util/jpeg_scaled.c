@@ -0,0 +1,106 @@
+#include "jpeg_scaled.h"
+
+#include <stdio.h>
+#include <setjmp.h>
+#include <stdbool.h>
+
+#include <jpeglib.h>
+
+typedef struct jpeg_error_ctx_t {
+    struct jpeg_error_mgr mgr;
+    jmp_buf jmp;
+} jpeg_error_ctx_t;
+
+static void error_exit(j_common_ptr cinfo);
+
+static void output_message(j_common_ptr cinfo);
+
+static bool is_jpeg(FILE *fp);
+
+SDL_Surface *jpeg_decode_scaled(const char *path, int min_width, int min_height, int *full_width, int *full_height) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (!is_jpeg(fp)) {
+        fclose(fp);
+        return NULL;
+    }
+    struct jpeg_decompress_struct cinfo;
+    jpeg_error_ctx_t err;
+    // Modified after setjmp, so it must not live in a register
+    SDL_Surface *volatile surface = NULL;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = error_exit;
+    err.mgr.output_message = output_message;
+    if (setjmp(err.jmp)) {
+        SDL_SetError("Failed to decode JPEG %s", path);
+        if (surface != NULL) {
+            SDL_FreeSurface(surface);
+        }
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return NULL;
+    }
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, fp);
+    jpeg_read_header(&cinfo, TRUE);
+    if (full_width != NULL) {
+        *full_width = (int) cinfo.image_width;
+    }
+    if (full_height != NULL) {
+        *full_height = (int) cinfo.image_height;
+    }
+    // libjpeg can't convert CMYK to RGB
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK) {
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return NULL;
+    }
+    unsigned int denom = 8;
+    while (denom > 1 && ((int) cinfo.image_width < min_width * (int) denom ||
+                         (int) cinfo.image_height < min_height * (int) denom)) {
+        denom /= 2;
+    }
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = denom;
+    cinfo.out_color_space = JCS_RGB;
+    // Result will be scaled down again, so speed matters more than accuracy
+    cinfo.dct_method = JDCT_IFAST;
+    jpeg_start_decompress(&cinfo);
+
+    surface = SDL_CreateRGBSurfaceWithFormat(0, (int) cinfo.output_width, (int) cinfo.output_height, 24,
+                                             SDL_PIXELFORMAT_RGB24);
+    if (surface == NULL) {
+        jpeg_abort_decompress(&cinfo);
+        jpeg_destroy_decompress(&cinfo);
+        fclose(fp);
+        return NULL;
+    }
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = (Uint8 *) surface->pixels + (size_t) cinfo.output_scanline * surface->pitch;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(fp);
+    return surface;
+}
+
+static void error_exit(j_common_ptr cinfo) {
+    jpeg_error_ctx_t *err = (jpeg_error_ctx_t *) cinfo->err;
+    longjmp(err->jmp, 1);
+}
+
+static void output_message(j_common_ptr cinfo) {
+    // Warnings like premature end of data would otherwise be written to stderr
+    (void) cinfo;
+}
+
+static bool is_jpeg(FILE *fp) {
+    unsigned char magic[3];
+    bool result = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+                  magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF;
+    rewind(fp);
+    return result;
+}
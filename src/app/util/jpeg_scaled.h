@@ -0,0 +1,15 @@
+#pragma once
+
+#include <SDL_surface.h>
+
+/*
+ * JPEG decoding with libjpeg DCT scaling, so large images don't have to be decoded at full size only to be shrunk.
+ */
+
+/**
+ * Decode a JPEG file at the smallest scale of 1/8, 1/4, 1/2 or 1/1 that still covers min_width x min_height.
+ * @param full_width Set to the original width, can be NULL
+ * @param full_height Set to the original height, can be NULL
+ * @return RGB24 surface, or NULL if the file is not a JPEG or can't be decoded. Fall back to IMG_Load() then.
+ */
+SDL_Surface *jpeg_decode_scaled(const char *path, int min_width, int min_height, int *full_width, int *full_height);
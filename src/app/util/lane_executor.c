@@ -0,0 +1,464 @@
+#include "lane_executor.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+#include "logging.h"
+
+/*
+ * Every worker has a mutex guarding its queues. Submitting or taking a task only ever holds one of them, so
+ * stealing doesn't serialize the pool. Cancel and state lookups are rare and lock all workers in order, which
+ * guarantees a task is either in a queue or set as a worker's current task while they look.
+ *
+ * Owners and thieves both take the oldest task. These are I/O-bound jobs, so submission order matters more than
+ * cache locality.
+ */
+
+typedef struct lane_task_t lane_task_t;
+
+struct lane_task_t {
+    lane_task_t *prev, *next;
+    lane_task_id_t id;
+    executor_action_cb action;
+    executor_cleanup_cb cleanup;
+    void *arg;
+    executor_lane_t lane;
+    Uint64 submit_time;
+    /* Set by cancel while the task runs, polled by the action and checked once it returns */
+    SDL_atomic_t cancelled;
+};
+
+typedef struct lane_queue_t {
+    lane_task_t *head, *tail;
+} lane_queue_t;
+
+typedef struct lane_worker_t {
+    lane_executor_t *executor;
+    int index;
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    lane_queue_t queues[EXECUTOR_LANE_COUNT];
+    /* Set while holding the lock of the queue the task came from, cleared while holding our own lock */
+    lane_task_t *current;
+} lane_worker_t;
+
+struct lane_executor_t {
+    char *name;
+    int num_workers;
+    lane_worker_t *workers;
+    SDL_TLSID worker_tls;
+    SDL_atomic_t next_worker;
+
+    int limits[EXECUTOR_LANE_COUNT];
+    SDL_atomic_t running[EXECUTOR_LANE_COUNT];
+
+    /* Bumped with idle_lock held whenever there may be new work, so workers don't miss a wakeup */
+    SDL_atomic_t generation;
+    SDL_mutex *idle_lock;
+    SDL_cond *idle_cond;
+    /* Written with idle_lock held */
+    SDL_atomic_t stopping;
+
+    SDL_mutex *stats_lock;
+    lane_executor_stats_t stats[EXECUTOR_LANE_COUNT];
+    /* Guarded by stats_lock */
+    lane_task_id_t last_task_id;
+};
+
+static int worker_run(lane_worker_t *worker);
+
+static lane_task_t *worker_take(lane_worker_t *worker);
+
+static void worker_execute(lane_worker_t *worker, lane_task_t *task);
+
+static bool lane_acquire(lane_executor_t *executor, executor_lane_t lane);
+
+static void lane_release(lane_executor_t *executor, executor_lane_t lane);
+
+static void executor_wake(lane_executor_t *executor);
+
+static void lock_workers(lane_executor_t *executor);
+
+static void unlock_workers(lane_executor_t *executor);
+
+static void queue_push(lane_queue_t *queue, lane_task_t *task);
+
+static lane_task_t *queue_pop(lane_queue_t *queue);
+
+static void queue_remove(lane_queue_t *queue, lane_task_t *task);
+
+static void task_finish(lane_executor_t *executor, lane_task_t *task, int result);
+
+static uint32_t wait_us(Uint64 since);
+
+lane_executor_t *lane_executor_create(const char *name, int num_workers, const int limits[EXECUTOR_LANE_COUNT]) {
+    SDL_assert_release(num_workers > 0);
+    lane_executor_t *executor = SDL_calloc(1, sizeof(lane_executor_t));
+    executor->name = SDL_strdup(name);
+    executor->num_workers = num_workers;
+    executor->worker_tls = SDL_TLSCreate();
+    for (int i = 0; i < EXECUTOR_LANE_COUNT; i++) {
+        executor->limits[i] = limits != NULL ? SDL_max(0, limits[i]) : 0;
+        latency_histogram_reset(&executor->stats[i].wait);
+    }
+    executor->idle_lock = SDL_CreateMutex();
+    executor->idle_cond = SDL_CreateCond();
+    executor->stats_lock = SDL_CreateMutex();
+    executor->workers = SDL_calloc(num_workers, sizeof(lane_worker_t));
+    for (int i = 0; i < num_workers; i++) {
+        lane_worker_t *worker = &executor->workers[i];
+        worker->executor = executor;
+        worker->index = i;
+        worker->lock = SDL_CreateMutex();
+    }
+    for (int i = 0; i < num_workers; i++) {
+        char thread_name[32];
+        SDL_snprintf(thread_name, sizeof(thread_name), "%s-%d", name, i);
+        executor->workers[i].thread = SDL_CreateThread((SDL_ThreadFunction) worker_run, thread_name,
+                                                       &executor->workers[i]);
+    }
+    return executor;
+}
+
+void lane_executor_destroy(lane_executor_t *executor) {
+    SDL_LockMutex(executor->idle_lock);
+    SDL_AtomicSet(&executor->stopping, 1);
+    SDL_CondBroadcast(executor->idle_cond);
+    SDL_UnlockMutex(executor->idle_lock);
+    for (int i = 0; i < executor->num_workers; i++) {
+        SDL_WaitThread(executor->workers[i].thread, NULL);
+    }
+    // Cleanup callbacks may submit more tasks, so keep going until everything is empty
+    for (bool found = true; found;) {
+        found = false;
+        for (int i = 0; i < executor->num_workers; i++) {
+            lane_worker_t *worker = &executor->workers[i];
+            for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+                SDL_LockMutex(worker->lock);
+                lane_task_t *task = queue_pop(&worker->queues[lane]);
+                SDL_UnlockMutex(worker->lock);
+                if (task != NULL) {
+                    found = true;
+                    SDL_LockMutex(executor->stats_lock);
+                    executor->stats[lane].queued--;
+                    SDL_UnlockMutex(executor->stats_lock);
+                    task_finish(executor, task, ECANCELED);
+                }
+            }
+        }
+    }
+    for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+        const lane_executor_stats_t *stats = &executor->stats[lane];
+        if (stats->submitted == 0) {
+            continue;
+        }
+        commons_log_info("Executor", "%s %s lane: %u tasks, %u cancelled, %u stolen, wait avg %u us, "
+                                     "p95 %u us, max %u us", executor->name, lane_executor_lane_name(lane),
+                         stats->submitted, stats->cancelled, stats->stolen, latency_histogram_average(&stats->wait),
+                         latency_histogram_percentile(&stats->wait, 95), stats->wait.max_us);
+    }
+    for (int i = 0; i < executor->num_workers; i++) {
+        SDL_DestroyMutex(executor->workers[i].lock);
+    }
+    SDL_free(executor->workers);
+    SDL_DestroyMutex(executor->stats_lock);
+    SDL_DestroyCond(executor->idle_cond);
+    SDL_DestroyMutex(executor->idle_lock);
+    SDL_free(executor->name);
+    SDL_free(executor);
+}
+
+lane_task_id_t lane_executor_submit(lane_executor_t *executor, executor_lane_t lane, executor_action_cb action,
+                                    executor_cleanup_cb cleanup, void *arg) {
+    SDL_assert_release(lane >= 0 && lane < EXECUTOR_LANE_COUNT);
+    lane_task_t *task = SDL_calloc(1, sizeof(lane_task_t));
+    task->action = action;
+    task->cleanup = cleanup;
+    task->arg = arg;
+    task->lane = lane;
+    task->submit_time = SDL_GetPerformanceCounter();
+
+    // Work spawned by a task stays on its worker, everything else is spread out
+    lane_worker_t *worker = SDL_TLSGet(executor->worker_tls);
+    if (worker == NULL) {
+        int index = (int) ((unsigned int) SDL_AtomicAdd(&executor->next_worker, 1) % executor->num_workers);
+        worker = &executor->workers[index];
+    }
+    SDL_LockMutex(executor->stats_lock);
+    task->id = ++executor->last_task_id;
+    executor->stats[lane].submitted++;
+    executor->stats[lane].queued++;
+    SDL_UnlockMutex(executor->stats_lock);
+    // Task may be done and freed as soon as it's queued
+    lane_task_id_t id = task->id;
+
+    SDL_LockMutex(worker->lock);
+    queue_push(&worker->queues[lane], task);
+    SDL_UnlockMutex(worker->lock);
+    executor_wake(executor);
+    return id;
+}
+
+void lane_executor_cancel(lane_executor_t *executor, lane_task_id_t id) {
+    if (id == 0) {
+        return;
+    }
+    lane_task_t *removed = NULL;
+    lock_workers(executor);
+    for (int i = 0; i < executor->num_workers && removed == NULL; i++) {
+        lane_worker_t *worker = &executor->workers[i];
+        if (worker->current != NULL && worker->current->id == id) {
+            SDL_AtomicSet(&worker->current->cancelled, 1);
+            break;
+        }
+        for (int lane = 0; lane < EXECUTOR_LANE_COUNT && removed == NULL; lane++) {
+            for (lane_task_t *cur = worker->queues[lane].head; cur != NULL; cur = cur->next) {
+                if (cur->id == id) {
+                    queue_remove(&worker->queues[lane], cur);
+                    removed = cur;
+                    break;
+                }
+            }
+        }
+    }
+    unlock_workers(executor);
+    if (removed == NULL) {
+        return;
+    }
+    SDL_LockMutex(executor->stats_lock);
+    executor->stats[removed->lane].queued--;
+    SDL_UnlockMutex(executor->stats_lock);
+    task_finish(executor, removed, ECANCELED);
+}
+
+lane_task_state_t lane_executor_task_state(lane_executor_t *executor, lane_task_id_t id) {
+    if (id == 0) {
+        return LANE_TASK_STATE_NONE;
+    }
+    lane_task_state_t state = LANE_TASK_STATE_NONE;
+    lock_workers(executor);
+    for (int i = 0; i < executor->num_workers && state == LANE_TASK_STATE_NONE; i++) {
+        lane_worker_t *worker = &executor->workers[i];
+        if (worker->current != NULL && worker->current->id == id) {
+            state = LANE_TASK_STATE_ACTIVE;
+            break;
+        }
+        for (int lane = 0; lane < EXECUTOR_LANE_COUNT && state == LANE_TASK_STATE_NONE; lane++) {
+            for (lane_task_t *cur = worker->queues[lane].head; cur != NULL; cur = cur->next) {
+                if (cur->id == id) {
+                    state = LANE_TASK_STATE_PENDING;
+                    break;
+                }
+            }
+        }
+    }
+    unlock_workers(executor);
+    return state;
+}
+
+lane_task_id_t lane_executor_current_task(lane_executor_t *executor) {
+    lane_worker_t *worker = SDL_TLSGet(executor->worker_tls);
+    // Only the worker itself changes its current task
+    return worker != NULL && worker->current != NULL ? worker->current->id : 0;
+}
+
+bool lane_executor_current_cancelled(lane_executor_t *executor) {
+    lane_worker_t *worker = SDL_TLSGet(executor->worker_tls);
+    return worker != NULL && worker->current != NULL && SDL_AtomicGet(&worker->current->cancelled);
+}
+
+void lane_executor_get_stats(lane_executor_t *executor, executor_lane_t lane, lane_executor_stats_t *stats) {
+    SDL_assert_release(lane >= 0 && lane < EXECUTOR_LANE_COUNT);
+    SDL_LockMutex(executor->stats_lock);
+    *stats = executor->stats[lane];
+    SDL_UnlockMutex(executor->stats_lock);
+}
+
+const char *lane_executor_lane_name(executor_lane_t lane) {
+    switch (lane) {
+        case EXECUTOR_LANE_INTERACTIVE:
+            return "interactive";
+        case EXECUTOR_LANE_NORMAL:
+            return "normal";
+        case EXECUTOR_LANE_BACKGROUND:
+            return "background";
+        default:
+            return "unknown";
+    }
+}
+
+static int worker_run(lane_worker_t *worker) {
+    lane_executor_t *executor = worker->executor;
+    SDL_TLSSet(executor->worker_tls, worker, NULL);
+    while (true) {
+        int generation = SDL_AtomicGet(&executor->generation);
+        lane_task_t *task = worker_take(worker);
+        if (task != NULL) {
+            worker_execute(worker, task);
+            continue;
+        }
+        SDL_LockMutex(executor->idle_lock);
+        while (!SDL_AtomicGet(&executor->stopping) && SDL_AtomicGet(&executor->generation) == generation) {
+            SDL_CondWait(executor->idle_cond, executor->idle_lock);
+        }
+        SDL_UnlockMutex(executor->idle_lock);
+        if (SDL_AtomicGet(&executor->stopping)) {
+            break;
+        }
+    }
+    SDL_TLSSet(executor->worker_tls, NULL, NULL);
+    return 0;
+}
+
+/**
+ * Look for the most urgent lane with a free slot, first in our own queue, then in everyone else's.
+ */
+static lane_task_t *worker_take(lane_worker_t *worker) {
+    lane_executor_t *executor = worker->executor;
+    if (SDL_AtomicGet(&executor->stopping)) {
+        return NULL;
+    }
+    for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+        if (!lane_acquire(executor, lane)) {
+            continue;
+        }
+        for (int i = 0; i < executor->num_workers; i++) {
+            lane_worker_t *victim = &executor->workers[(worker->index + i) % executor->num_workers];
+            SDL_LockMutex(victim->lock);
+            lane_task_t *task = queue_pop(&victim->queues[lane]);
+            if (task != NULL) {
+                worker->current = task;
+            }
+            SDL_UnlockMutex(victim->lock);
+            if (task == NULL) {
+                continue;
+            }
+            SDL_LockMutex(executor->stats_lock);
+            lane_executor_stats_t *stats = &executor->stats[lane];
+            stats->queued--;
+            stats->active++;
+            if (victim != worker) {
+                stats->stolen++;
+            }
+            latency_histogram_record(&stats->wait, wait_us(task->submit_time));
+            SDL_UnlockMutex(executor->stats_lock);
+            return task;
+        }
+        lane_release(executor, lane);
+    }
+    return NULL;
+}
+
+static void worker_execute(lane_worker_t *worker, lane_task_t *task) {
+    lane_executor_t *executor = worker->executor;
+    executor_lane_t lane = task->lane;
+    int result = task->action(task->arg);
+    SDL_LockMutex(worker->lock);
+    worker->current = NULL;
+    bool cancelled = SDL_AtomicGet(&task->cancelled);
+    SDL_UnlockMutex(worker->lock);
+    SDL_LockMutex(executor->stats_lock);
+    executor->stats[lane].active--;
+    SDL_UnlockMutex(executor->stats_lock);
+    task_finish(executor, task, cancelled ? ECANCELED : result);
+    // Cleanup still occupies the worker, so the slot is only given back now
+    lane_release(executor, lane);
+    if (executor->limits[lane] > 0) {
+        executor_wake(executor);
+    }
+}
+
+static bool lane_acquire(lane_executor_t *executor, executor_lane_t lane) {
+    int limit = executor->limits[lane];
+    if (limit == 0) {
+        SDL_AtomicIncRef(&executor->running[lane]);
+        return true;
+    }
+    while (true) {
+        int running = SDL_AtomicGet(&executor->running[lane]);
+        if (running >= limit) {
+            return false;
+        }
+        if (SDL_AtomicCAS(&executor->running[lane], running, running + 1)) {
+            return true;
+        }
+    }
+}
+
+static void lane_release(lane_executor_t *executor, executor_lane_t lane) {
+    SDL_AtomicDecRef(&executor->running[lane]);
+}
+
+static void executor_wake(lane_executor_t *executor) {
+    SDL_LockMutex(executor->idle_lock);
+    SDL_AtomicIncRef(&executor->generation);
+    SDL_CondSignal(executor->idle_cond);
+    SDL_UnlockMutex(executor->idle_lock);
+}
+
+static void lock_workers(lane_executor_t *executor) {
+    for (int i = 0; i < executor->num_workers; i++) {
+        SDL_LockMutex(executor->workers[i].lock);
+    }
+}
+
+static void unlock_workers(lane_executor_t *executor) {
+    for (int i = executor->num_workers - 1; i >= 0; i--) {
+        SDL_UnlockMutex(executor->workers[i].lock);
+    }
+}
+
+static void queue_push(lane_queue_t *queue, lane_task_t *task) {
+    task->next = NULL;
+    task->prev = queue->tail;
+    if (queue->tail != NULL) {
+        queue->tail->next = task;
+    } else {
+        queue->head = task;
+    }
+    queue->tail = task;
+}
+
+static lane_task_t *queue_pop(lane_queue_t *queue) {
+    lane_task_t *task = queue->head;
+    if (task != NULL) {
+        queue_remove(queue, task);
+    }
+    return task;
+}
+
+static void queue_remove(lane_queue_t *queue, lane_task_t *task) {
+    if (task->prev != NULL) {
+        task->prev->next = task->next;
+    } else {
+        queue->head = task->next;
+    }
+    if (task->next != NULL) {
+        task->next->prev = task->prev;
+    } else {
+        queue->tail = task->prev;
+    }
+    task->prev = task->next = NULL;
+}
+
+static void task_finish(lane_executor_t *executor, lane_task_t *task, int result) {
+    SDL_LockMutex(executor->stats_lock);
+    if (result == ECANCELED) {
+        executor->stats[task->lane].cancelled++;
+    } else {
+        executor->stats[task->lane].completed++;
+    }
+    SDL_UnlockMutex(executor->stats_lock);
+    if (task->cleanup != NULL) {
+        task->cleanup(task->arg, result);
+    }
+    SDL_free(task);
+}
+
+static uint32_t wait_us(Uint64 since) {
+    Uint64 elapsed = (SDL_GetPerformanceCounter() - since) * 1000000 / SDL_GetPerformanceFrequency();
+    return elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t) elapsed;
+}
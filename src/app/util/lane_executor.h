@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "executor.h"
+#include "latency_histogram.h"
+
+/*
+ * Thread pool with priority lanes. Each worker owns a queue per lane, and idle workers steal from the others.
+ * Workers always look for interactive work first, then normal, then background, so a screen of cover downloads
+ * can't hold back a pairing request. Lanes can be capped, which keeps some workers free for higher lanes.
+ */
+
+typedef enum executor_lane_t {
+    /* User is waiting on the result: pairing, launch, quit */
+    EXECUTOR_LANE_INTERACTIVE = 0,
+    /* Content of the current screen: host status, app list */
+    EXECUTOR_LANE_NORMAL,
+    /* Anything that can wait: covers, discovery, polling */
+    EXECUTOR_LANE_BACKGROUND,
+    EXECUTOR_LANE_COUNT,
+} executor_lane_t;
+
+typedef enum lane_task_state_t {
+    /* Finished, cancelled, or not a task of this executor */
+    LANE_TASK_STATE_NONE = 0,
+    LANE_TASK_STATE_PENDING,
+    LANE_TASK_STATE_ACTIVE,
+} lane_task_state_t;
+
+typedef struct lane_executor_t lane_executor_t;
+
+/**
+ * Identifies a submitted task. Never reused, so a stale id can't match a later task. 0 is not a task.
+ */
+typedef uint64_t lane_task_id_t;
+
+typedef struct lane_executor_stats_t {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t cancelled;
+    /* Tasks run by a worker other than the one they were queued on */
+    uint32_t stolen;
+    int queued;
+    int active;
+    /* Time between submit and start, in microseconds */
+    latency_histogram_t wait;
+} lane_executor_stats_t;
+
+/**
+ * @param limits Max tasks running at once for each lane, 0 for no limit. NULL for no limits at all.
+ */
+lane_executor_t *lane_executor_create(const char *name, int num_workers, const int limits[EXECUTOR_LANE_COUNT]);
+
+/**
+ * Cancel all pending tasks, wait for running ones and stop the workers.
+ */
+void lane_executor_destroy(lane_executor_t *executor);
+
+/**
+ * Safe to call from any thread, including the executor's own workers.
+ * @param cleanup Called once the task is done, with ECANCELED if it was cancelled, otherwise the action's result.
+ * @return Id of the task, for lane_executor_cancel and lane_executor_task_state.
+ */
+lane_task_id_t lane_executor_submit(lane_executor_t *executor, executor_lane_t lane, executor_action_cb action,
+                                    executor_cleanup_cb cleanup, void *arg);
+
+/**
+ * Pending tasks are removed and cleaned up right away. Running tasks see lane_executor_current_cancelled() return
+ * true, and their cleanup gets ECANCELED. Ids of finished tasks are ignored.
+ */
+void lane_executor_cancel(lane_executor_t *executor, lane_task_id_t id);
+
+lane_task_state_t lane_executor_task_state(lane_executor_t *executor, lane_task_id_t id);
+
+/**
+ * @return Task running on the calling thread, 0 if it's not a worker of this executor
+ */
+lane_task_id_t lane_executor_current_task(lane_executor_t *executor);
+
+/**
+ * Lets long actions stop early, e.g. in the middle of a network request.
+ * @return Whether the task running on the calling thread has been cancelled
+ */
+bool lane_executor_current_cancelled(lane_executor_t *executor);
+
+void lane_executor_get_stats(lane_executor_t *executor, executor_lane_t lane, lane_executor_stats_t *stats);
+
+const char *lane_executor_lane_name(executor_lane_t lane);
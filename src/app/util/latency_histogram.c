@@ -0,0 +1,99 @@
+#include "latency_histogram.h"
+
+#include <string.h>
+
+#define FINE_LIMIT_US 10000
+#define FINE_STEP_US 100
+#define MEDIUM_LIMIT_US 100000
+#define MEDIUM_STEP_US 1000
+#define COARSE_LIMIT_US 1000000
+#define COARSE_STEP_US 10000
+
+#define FINE_BUCKETS (FINE_LIMIT_US / FINE_STEP_US)
+#define MEDIUM_BUCKETS ((MEDIUM_LIMIT_US - FINE_LIMIT_US) / MEDIUM_STEP_US)
+#define COARSE_BUCKETS ((COARSE_LIMIT_US - MEDIUM_LIMIT_US) / COARSE_STEP_US)
+
+_Static_assert(FINE_BUCKETS + MEDIUM_BUCKETS + COARSE_BUCKETS + 1 == LATENCY_HISTOGRAM_BUCKETS,
+               "Bucket count mismatch");
+
+static unsigned int bucket_index(uint32_t value_us);
+
+static uint32_t bucket_upper_bound(unsigned int index);
+
+void latency_histogram_reset(latency_histogram_t *histogram) {
+    memset(histogram, 0, sizeof(latency_histogram_t));
+}
+
+void latency_histogram_record(latency_histogram_t *histogram, uint32_t value_us) {
+    histogram->buckets[bucket_index(value_us)]++;
+    histogram->count++;
+    histogram->sum_us += value_us;
+    if (value_us > histogram->max_us) {
+        histogram->max_us = value_us;
+    }
+}
+
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src) {
+    if (src->count == 0) {
+        return;
+    }
+    for (int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    dst->count += src->count;
+    dst->sum_us += src->sum_us;
+    if (src->max_us > dst->max_us) {
+        dst->max_us = src->max_us;
+    }
+}
+
+uint32_t latency_histogram_percentile(const latency_histogram_t *histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    // Rank of the sample at this percentile, 1-based
+    uint64_t rank = (uint64_t) (percentile / 100.0 * histogram->count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    } else if (rank > histogram->count) {
+        rank = histogram->count;
+    }
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint32_t bound = bucket_upper_bound(i);
+            return bound < histogram->max_us ? bound : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+uint32_t latency_histogram_average(const latency_histogram_t *histogram) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    return (uint32_t) (histogram->sum_us / histogram->count);
+}
+
+static unsigned int bucket_index(uint32_t value_us) {
+    if (value_us < FINE_LIMIT_US) {
+        return value_us / FINE_STEP_US;
+    } else if (value_us < MEDIUM_LIMIT_US) {
+        return FINE_BUCKETS + (value_us - FINE_LIMIT_US) / MEDIUM_STEP_US;
+    } else if (value_us < COARSE_LIMIT_US) {
+        return FINE_BUCKETS + MEDIUM_BUCKETS + (value_us - MEDIUM_LIMIT_US) / COARSE_STEP_US;
+    }
+    return LATENCY_HISTOGRAM_BUCKETS - 1;
+}
+
+static uint32_t bucket_upper_bound(unsigned int index) {
+    if (index < FINE_BUCKETS) {
+        return (index + 1) * FINE_STEP_US;
+    } else if (index < FINE_BUCKETS + MEDIUM_BUCKETS) {
+        return FINE_LIMIT_US + (index - FINE_BUCKETS + 1) * MEDIUM_STEP_US;
+    } else if (index < FINE_BUCKETS + MEDIUM_BUCKETS + COARSE_BUCKETS) {
+        return MEDIUM_LIMIT_US + (index - FINE_BUCKETS - MEDIUM_BUCKETS + 1) * COARSE_STEP_US;
+    }
+    return UINT32_MAX;
+}
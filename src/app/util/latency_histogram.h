@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Fixed bucket latency histogram, values are in microseconds.
+ * Buckets are 0.1 ms wide below 10 ms, 1 ms wide below 100 ms, 10 ms wide below 1 s, then one overflow bucket.
+ * Recording never allocates, so it's safe to use from decoder callbacks.
+ */
+#define LATENCY_HISTOGRAM_BUCKETS 281
+
+typedef struct latency_histogram_t {
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_histogram_t;
+
+void latency_histogram_reset(latency_histogram_t *histogram);
+
+void latency_histogram_record(latency_histogram_t *histogram, uint32_t value_us);
+
+void latency_histogram_merge(latency_histogram_t *dst, const latency_histogram_t *src);
+
+/**
+ * @param percentile Between 0 and 100
+ * @return Upper bound of the bucket containing the percentile in microseconds, or the max value if it's smaller.
+ *         0 if nothing was recorded.
+ */
+uint32_t latency_histogram_percentile(const latency_histogram_t *histogram, double percentile);
+
+/**
+ * @return Average in microseconds, 0 if nothing was recorded.
+ */
+uint32_t latency_histogram_average(const latency_histogram_t *histogram);
@@ -0,0 +1,64 @@
+#include "mpsc_queue.h"
+
+#include <stddef.h>
+
+static mpsc_node_t *next_of(mpsc_node_t *node);
+
+static void append(mpsc_queue_t *queue, mpsc_node_t *node);
+
+void mpsc_queue_init(mpsc_queue_t *queue) {
+    queue->stub.next = NULL;
+    queue->tail = &queue->stub;
+    SDL_AtomicSetPtr(&queue->head, &queue->stub);
+    SDL_AtomicSet(&queue->depth, 0);
+}
+
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_node_t *node) {
+    SDL_AtomicIncRef(&queue->depth);
+    append(queue, node);
+}
+
+mpsc_node_t *mpsc_queue_pop(mpsc_queue_t *queue) {
+    mpsc_node_t *tail = queue->tail;
+    mpsc_node_t *next = next_of(tail);
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = next_of(next);
+    }
+    if (next != NULL) {
+        queue->tail = next;
+        SDL_AtomicDecRef(&queue->depth);
+        return tail;
+    }
+    if (tail != SDL_AtomicGetPtr(&queue->head)) {
+        // A producer has swapped head but not linked the node yet
+        return NULL;
+    }
+    // Tail is the last node, put the stub behind it so it can be taken out
+    append(queue, &queue->stub);
+    next = next_of(tail);
+    if (next != NULL) {
+        queue->tail = next;
+        SDL_AtomicDecRef(&queue->depth);
+        return tail;
+    }
+    return NULL;
+}
+
+int mpsc_queue_depth(mpsc_queue_t *queue) {
+    return SDL_AtomicGet(&queue->depth);
+}
+
+static mpsc_node_t *next_of(mpsc_node_t *node) {
+    return SDL_AtomicGetPtr(&node->next);
+}
+
+static void append(mpsc_queue_t *queue, mpsc_node_t *node) {
+    SDL_AtomicSetPtr(&node->next, NULL);
+    mpsc_node_t *prev = SDL_AtomicSetPtr(&queue->head, node);
+    SDL_AtomicSetPtr(&prev->next, node);
+}
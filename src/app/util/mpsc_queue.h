@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <SDL_atomic.h>
+
+/*
+ * Intrusive multi-producer/single-consumer queue (Vyukov). Producers never block each other, and nothing is
+ * allocated by the queue itself. Embed mpsc_node_t in the queued struct.
+ */
+typedef struct mpsc_node_t {
+    void *next;
+} mpsc_node_t;
+
+typedef struct mpsc_queue_t {
+    /* Last pushed node, swapped by producers */
+    void *head;
+    /* Next node to pop, only touched by the consumer */
+    mpsc_node_t *tail;
+    mpsc_node_t stub;
+    SDL_atomic_t depth;
+} mpsc_queue_t;
+
+void mpsc_queue_init(mpsc_queue_t *queue);
+
+/**
+ * Safe to call from any thread.
+ */
+void mpsc_queue_push(mpsc_queue_t *queue, mpsc_node_t *node);
+
+/**
+ * Only call from the consumer thread.
+ * @return Oldest node, or NULL if the queue is empty or a producer is in the middle of pushing it
+ */
+mpsc_node_t *mpsc_queue_pop(mpsc_queue_t *queue);
+
+/**
+ * @return Approximate number of nodes in the queue
+ */
+int mpsc_queue_depth(mpsc_queue_t *queue);
@@ -0,0 +1,197 @@
+#include "thumbcache.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <SDL_thread.h>
+
+#if !__WIN32
+#define THUMBCACHE_MMAP 1
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+#include "logging.h"
+
+#define THUMBCACHE_MAGIC "MLTB"
+#define THUMBCACHE_VERSION 1
+#define THUMBCACHE_FLAG_ALPHA 0x1
+#define THUMBCACHE_FLAG_PLACEHOLDER 0x2
+/* Pixels start at this offset, keeps them aligned */
+#define THUMBCACHE_PIXELS_OFFSET 64
+
+typedef struct thumbcache_header_t {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t format;
+    int32_t width, height, pitch;
+    int32_t display_width, display_height;
+    int32_t rect_x, rect_y, rect_w, rect_h;
+} thumbcache_header_t;
+
+static bool write_file(const char *path, const thumbcache_header_t *header, const SDL_Surface *surface);
+
+static bool header_valid(const thumbcache_header_t *header, size_t file_size);
+
+static SDL_Surface *surface_from_header(const thumbcache_header_t *header, void *pixels);
+
+bool thumbcache_write(const char *path, SDL_Surface *surface, const thumbcache_meta_t *meta) {
+    thumbcache_header_t header = {
+            .version = THUMBCACHE_VERSION,
+            .flags = meta->alpha ? THUMBCACHE_FLAG_ALPHA : 0,
+            .format = surface->format->format,
+            .width = surface->w,
+            .height = surface->h,
+            .pitch = surface->pitch,
+            .display_width = meta->width,
+            .display_height = meta->height,
+            .rect_x = meta->rect.x,
+            .rect_y = meta->rect.y,
+            .rect_w = meta->rect.w,
+            .rect_h = meta->rect.h,
+    };
+    memcpy(header.magic, THUMBCACHE_MAGIC, 4);
+    return write_file(path, &header, surface);
+}
+
+bool thumbcache_write_placeholder(const char *path) {
+    thumbcache_header_t header = {
+            .version = THUMBCACHE_VERSION,
+            .flags = THUMBCACHE_FLAG_PLACEHOLDER,
+    };
+    memcpy(header.magic, THUMBCACHE_MAGIC, 4);
+    return write_file(path, &header, NULL);
+}
+
+thumbcache_result_t thumbcache_read(const char *path, SDL_Surface **surface, thumbcache_meta_t *meta) {
+    thumbcache_header_t header;
+#if THUMBCACHE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return THUMBCACHE_MISS;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(header)) {
+        close(fd);
+        return THUMBCACHE_MISS;
+    }
+    if (read(fd, &header, sizeof(header)) != sizeof(header) || !header_valid(&header, st.st_size)) {
+        close(fd);
+        return THUMBCACHE_MISS;
+    }
+    if (header.flags & THUMBCACHE_FLAG_PLACEHOLDER) {
+        close(fd);
+        return THUMBCACHE_PLACEHOLDER;
+    }
+    size_t map_size = THUMBCACHE_PIXELS_OFFSET + (size_t) header.pitch * header.height;
+    void *map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        commons_log_warn("ThumbCache", "Failed to map %s: %s", path, strerror(errno));
+        return THUMBCACHE_MISS;
+    }
+    SDL_Surface *result = surface_from_header(&header, (uint8_t *) map + THUMBCACHE_PIXELS_OFFSET);
+    if (result == NULL) {
+        munmap(map, map_size);
+        return THUMBCACHE_MISS;
+    }
+#else
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return THUMBCACHE_MISS;
+    }
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (file_size < (long) sizeof(header) || fread(&header, sizeof(header), 1, f) != 1 ||
+        !header_valid(&header, file_size)) {
+        fclose(f);
+        return THUMBCACHE_MISS;
+    }
+    if (header.flags & THUMBCACHE_FLAG_PLACEHOLDER) {
+        fclose(f);
+        return THUMBCACHE_PLACEHOLDER;
+    }
+    SDL_Surface *result = SDL_CreateRGBSurfaceWithFormat(0, header.width, header.height,
+                                                         SDL_BITSPERPIXEL(header.format), header.format);
+    if (result == NULL || result->pitch != header.pitch) {
+        SDL_FreeSurface(result);
+        fclose(f);
+        return THUMBCACHE_MISS;
+    }
+    fseek(f, THUMBCACHE_PIXELS_OFFSET, SEEK_SET);
+    size_t read = fread(result->pixels, header.pitch, header.height, f);
+    fclose(f);
+    if (read != (size_t) header.height) {
+        SDL_FreeSurface(result);
+        return THUMBCACHE_MISS;
+    }
+#endif
+    meta->width = header.display_width;
+    meta->height = header.display_height;
+    meta->rect = (SDL_Rect) {header.rect_x, header.rect_y, header.rect_w, header.rect_h};
+    meta->alpha = (header.flags & THUMBCACHE_FLAG_ALPHA) != 0;
+    *surface = result;
+    return THUMBCACHE_HIT;
+}
+
+void thumbcache_surface_free(SDL_Surface *surface) {
+    if (surface == NULL) {
+        return;
+    }
+#if THUMBCACHE_MMAP
+    if (surface->flags & SDL_PREALLOC) {
+        // Pixels are at a fixed offset from the start of the mapping
+        munmap((uint8_t *) surface->pixels - THUMBCACHE_PIXELS_OFFSET,
+               THUMBCACHE_PIXELS_OFFSET + (size_t) surface->pitch * surface->h);
+    }
+#endif
+    SDL_FreeSurface(surface);
+}
+
+static bool write_file(const char *path, const thumbcache_header_t *header, const SDL_Surface *surface) {
+    char tmp_path[4096];
+    SDL_snprintf(tmp_path, sizeof(tmp_path), "%s.%lu.tmp", path, SDL_ThreadID());
+    FILE *f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    uint8_t padding[THUMBCACHE_PIXELS_OFFSET - sizeof(thumbcache_header_t)] = {0};
+    bool ok = fwrite(header, sizeof(*header), 1, f) == 1 && fwrite(padding, sizeof(padding), 1, f) == 1;
+    if (ok && surface != NULL) {
+        ok = fwrite(surface->pixels, surface->pitch, surface->h, f) == (size_t) surface->h;
+    }
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        commons_log_warn("ThumbCache", "Failed to write %s", path);
+        remove(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+static bool header_valid(const thumbcache_header_t *header, size_t file_size) {
+    if (memcmp(header->magic, THUMBCACHE_MAGIC, 4) != 0 || header->version != THUMBCACHE_VERSION) {
+        return false;
+    }
+    if (header->flags & THUMBCACHE_FLAG_PLACEHOLDER) {
+        return true;
+    }
+    if (header->width <= 0 || header->height <= 0 || SDL_BYTESPERPIXEL(header->format) == 0 ||
+        header->pitch < header->width * SDL_BYTESPERPIXEL(header->format)) {
+        return false;
+    }
+    return file_size >= THUMBCACHE_PIXELS_OFFSET + (size_t) header->pitch * header->height;
+}
+
+static SDL_Surface *surface_from_header(const thumbcache_header_t *header, void *pixels) {
+    return SDL_CreateRGBSurfaceWithFormatFrom(pixels, header->width, header->height, SDL_BITSPERPIXEL(header->format),
+                                              header->pitch, header->format);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <SDL_surface.h>
+
+/*
+ * Pre-scaled thumbnails stored as raw pixels after a small header, so they can be memory mapped and uploaded as is.
+ * Files are in native byte order, they are only a local cache.
+ */
+
+typedef enum thumbcache_result_t {
+    THUMBCACHE_MISS = 0,
+    THUMBCACHE_HIT,
+    /* Source image is known to be a placeholder, don't bother decoding it */
+    THUMBCACHE_PLACEHOLDER,
+} thumbcache_result_t;
+
+typedef struct thumbcache_meta_t {
+    /* Size to display */
+    int width, height;
+    /* Part of the pixels to display */
+    SDL_Rect rect;
+    /* Pixels have meaningful alpha channel */
+    bool alpha;
+} thumbcache_meta_t;
+
+/**
+ * Write thumbnail. The file is replaced atomically, so readers never see partial content.
+ */
+bool thumbcache_write(const char *path, SDL_Surface *surface, const thumbcache_meta_t *meta);
+
+/**
+ * Write a marker meaning the source image is a placeholder.
+ */
+bool thumbcache_write_placeholder(const char *path);
+
+/**
+ * @param surface Set on hit. Pixels may point into a read-only memory map, free it with thumbcache_surface_free()
+ */
+thumbcache_result_t thumbcache_read(const char *path, SDL_Surface **surface, thumbcache_meta_t *meta);
+
+void thumbcache_surface_free(SDL_Surface *surface);
@@ -0,0 +1,245 @@
+/*
+ * Feeds a decode unit recording through the video decoder callbacks without a host.
+ * Recordings are made by setting record_dir in [video] section of moonlight.ini.
+ * The default dummy module needs SS4S_MODULE_BUILD_DUMMY.
+ */
+#include "app.h"
+#include "stream/session_priv.h"
+#include "stream/video/session_video.h"
+#include "stream/video/vdec_recorder.h"
+#include "util/latency_histogram.h"
+
+#include "logging.h"
+#include "logging_ext_ss4s.h"
+#include "ss4s.h"
+#include "ss4s_modules.h"
+
+#include <SDL.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct replay_options_t {
+    const char *module;
+    const char *path;
+    bool original_pace;
+    int loops;
+    int max_frame_size;
+} replay_options_t;
+
+typedef struct replay_result_t {
+    uint32_t frames;
+    uint32_t idr_requests;
+    uint64_t bytes;
+    uint32_t elapsed_ms;
+    latency_histogram_t submit;
+} replay_result_t;
+
+static void usage(const char *name);
+
+static bool parse_options(replay_options_t *options, int argc, char *argv[]);
+
+static int replay_run(session_t *session, vdec_replay_t *replay, const vdec_recording_info_t *info,
+                      const replay_options_t *options, replay_result_t *result);
+
+static void replay_report(const replay_result_t *result);
+
+int main(int argc, char *argv[]) {
+    replay_options_t options = {
+            .module = "dummy",
+            .original_pace = false,
+            .loops = 1,
+            .max_frame_size = 8,
+    };
+    if (!parse_options(&options, argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    commons_logging_init("moonlight-replay");
+    SDL_Init(0);
+
+    vdec_recording_info_t info;
+    vdec_replay_t *replay = vdec_replay_open(options.path, &info);
+    if (replay == NULL) {
+        fprintf(stderr, "Can't open recording %s\n", options.path);
+        SDL_Quit();
+        return 1;
+    }
+
+    // There's no UI, input or host here. Only the parts the video decoder callbacks read are set up,
+    // the same way app_init does, and the rest stays zeroed
+    app_t app;
+    memset(&app, 0, sizeof(app));
+    os_info_get(&app.os_info);
+    SS4S_SetLoggingFunction(commons_ss4s_logf);
+    SS4S_ModulesList(&app.ss4s.modules, &app.os_info);
+    SS4S_ModulePreferences module_preferences = {
+            .audio_module = "auto",
+            .video_module = options.module,
+    };
+    SS4S_ModulesSelect(&app.ss4s.modules, &module_preferences, &app.ss4s.selection, false);
+    const char *video_driver = SS4S_ModuleInfoGetId(app.ss4s.selection.video_module);
+    if (video_driver == NULL || strcmp(video_driver, options.module) != 0) {
+        fprintf(stderr, "Video module %s is not available\n", options.module);
+        vdec_replay_close(replay);
+        SS4S_ModulesListClear(&app.ss4s.modules);
+        os_info_clear(&app.os_info);
+        SDL_Quit();
+        return 1;
+    }
+    SS4S_Config ss4s_config = {
+            .audioDriver = SS4S_ModuleInfoGetId(app.ss4s.selection.audio_module),
+            .videoDriver = video_driver,
+    };
+    SS4S_Init(argc, argv, &ss4s_config);
+    SS4S_PostInit(argc, argv);
+    SS4S_GetVideoCapabilities(&app.ss4s.video_cap);
+    if (app.ss4s.video_cap.transform & SS4S_VIDEO_CAP_TRANSFORM_UI_EXCLUSIVE) {
+        // Decoder setup would wait for the UI to close on the app bus, which isn't running
+        fprintf(stderr, "Video module %s needs exclusive screen, and can't be used for replay\n", options.module);
+        vdec_replay_close(replay);
+        SS4S_Quit();
+        SS4S_ModulesListClear(&app.ss4s.modules);
+        os_info_clear(&app.os_info);
+        SDL_Quit();
+        return 1;
+    }
+
+    session_t session;
+    memset(&session, 0, sizeof(session));
+    session.app = &app;
+    session.config.max_frame_size = (size_t) options.max_frame_size * 1024 * 1024;
+    session.config.sps_fixup = vdec_sps_fixup_flags(video_driver, "auto");
+    // Decoder errors interrupt the session, which would release input otherwise
+    session.config.view_only = true;
+    session.input.session = &session;
+    session.state_lock = SDL_CreateMutex();
+    session.mutex = SDL_CreateMutex();
+    session.cond = SDL_CreateCond();
+    session.player = SS4S_PlayerOpen();
+
+    replay_result_t result;
+    memset(&result, 0, sizeof(result));
+    int ret = replay_run(&session, replay, &info, &options, &result);
+    if (ret == 0) {
+        replay_report(&result);
+    }
+
+    SS4S_PlayerClose(session.player);
+    SDL_DestroyCond(session.cond);
+    SDL_DestroyMutex(session.mutex);
+    SDL_DestroyMutex(session.state_lock);
+    vdec_replay_close(replay);
+    SS4S_Quit();
+    SS4S_ModulesListClear(&app.ss4s.modules);
+    os_info_clear(&app.os_info);
+    SDL_Quit();
+    return ret;
+}
+
+static int replay_run(session_t *session, vdec_replay_t *replay, const vdec_recording_info_t *info,
+                      const replay_options_t *options, replay_result_t *result) {
+    int ret = ss4s_dec_callbacks.setup(info->video_format, info->width, info->height, info->redraw_rate, session, 0);
+    if (ret != 0) {
+        fprintf(stderr, "Failed to setup decoder: %d\n", ret);
+        return 1;
+    }
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    Uint32 start_ticks = SDL_GetTicks();
+    int frame_offset = 0, last_frame = 0;
+    for (int loop = 0; loop < options->loops && !session->interrupted; loop++) {
+        if (loop > 0 && !vdec_replay_rewind(replay)) {
+            break;
+        }
+        uint64_t first_enqueue = 0;
+        Uint32 loop_ticks = SDL_GetTicks();
+        PDECODE_UNIT unit;
+        while (!session->interrupted && (unit = vdec_replay_read(replay)) != NULL) {
+            if (first_enqueue == 0) {
+                first_enqueue = unit->enqueueTimeMs;
+                // Frame numbers must keep increasing across loops, or they'd be counted as network drops
+                frame_offset = loop > 0 ? last_frame + 1 - unit->frameNumber : 0;
+            }
+            if (options->original_pace) {
+                Uint32 due = loop_ticks + (Uint32) (unit->enqueueTimeMs - first_enqueue);
+                Sint32 wait = (Sint32) (due - SDL_GetTicks());
+                if (wait > 0) {
+                    SDL_Delay(wait);
+                }
+            }
+            // Move timestamps to current clock, so submit time is measured the same way as in streaming
+            uint64_t reassembly = unit->enqueueTimeMs - unit->receiveTimeMs;
+            unit->enqueueTimeMs = LiGetMillis();
+            unit->receiveTimeMs = unit->enqueueTimeMs - reassembly;
+            unit->frameNumber += frame_offset;
+            last_frame = unit->frameNumber;
+
+            uint64_t begin = SDL_GetPerformanceCounter();
+            int submit_ret = ss4s_dec_callbacks.submitDecodeUnit(unit);
+            uint64_t elapsed_us = (SDL_GetPerformanceCounter() - begin) * 1000000 / freq;
+            latency_histogram_record(&result->submit, (uint32_t) elapsed_us);
+            result->frames++;
+            result->bytes += unit->fullLength;
+            if (submit_ret == DR_NEED_IDR) {
+                result->idr_requests++;
+            }
+        }
+    }
+    result->elapsed_ms = SDL_GetTicks() - start_ticks;
+    // Logs the pipeline histograms as in a real session
+    ss4s_dec_callbacks.cleanup();
+    if (session->interrupted) {
+        fprintf(stderr, "Replay interrupted by decoder error\n");
+        return 1;
+    }
+    return 0;
+}
+
+static void replay_report(const replay_result_t *result) {
+    double seconds = result->elapsed_ms > 0 ? result->elapsed_ms / 1000.0 : 0.001;
+    printf("Frames: %u in %.2f s, %.2f FPS, %.2f Mbps\n", result->frames, seconds, result->frames / seconds,
+           (double) result->bytes * 8 / seconds / 1000000.0);
+    printf("IDR requests: %u\n", result->idr_requests);
+    printf("Submit call: avg %.3f ms, p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.3f ms\n",
+           latency_histogram_average(&result->submit) / 1000.0,
+           latency_histogram_percentile(&result->submit, 50) / 1000.0,
+           latency_histogram_percentile(&result->submit, 95) / 1000.0,
+           latency_histogram_percentile(&result->submit, 99) / 1000.0,
+           result->submit.max_us / 1000.0);
+}
+
+static bool parse_options(replay_options_t *options, int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "m:n:s:p")) != -1) {
+        switch (opt) {
+            case 'm':
+                options->module = optarg;
+                break;
+            case 'n':
+                options->loops = atoi(optarg);
+                break;
+            case 's':
+                options->max_frame_size = atoi(optarg);
+                break;
+            case 'p':
+                options->original_pace = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (optind != argc - 1 || options->loops < 1 || options->max_frame_size < 1) {
+        return false;
+    }
+    options->path = argv[optind];
+    return true;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s [-m module] [-n loops] [-s max_frame_size_mb] [-p] recording.mldu\n", name);
+    fprintf(stderr, "  -m  SS4S video module, defaults to dummy (null player)\n");
+    fprintf(stderr, "  -n  Play the recording this many times\n");
+    fprintf(stderr, "  -s  Decode buffer cap in MB, as max_frame_size setting\n");
+    fprintf(stderr, "  -p  Keep original pace instead of feeding as fast as possible\n");
+}
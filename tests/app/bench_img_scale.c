@@ -0,0 +1,71 @@
+/*
+ * Compares area average scaling with halving and SDL_BlitScaled, which covers used before.
+ * Not part of ctest, build and run with: cmake --build . --target bench_img_scale
+ */
+#include "util/img_scale.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+
+static SDL_Surface *create_noise(int w, int h, Uint32 format) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+    for (int y = 0; y < h; y++) {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (int x = 0; x < w * 4; x++) {
+            row[x] = rand() & 0xFF;
+        }
+    }
+    return surface;
+}
+
+/**
+ * What coverloader did before: halve until within 1.5x of target, then nearest neighbour scale
+ */
+static SDL_Surface *legacy_scale(SDL_Surface *src, int tw, int th) {
+    int sw = src->w, sh = src->h;
+    while (sw > tw * 1.5 || sh > th * 1.5) {
+        sw /= 2;
+        sh /= 2;
+    }
+    const SDL_PixelFormat *format = src->format;
+    SDL_Surface *result = SDL_CreateRGBSurface(0, sw, sh, format->BitsPerPixel, format->Rmask, format->Gmask,
+                                               format->Bmask, format->Amask);
+    SDL_BlitScaled(src, NULL, result, NULL);
+    return result;
+}
+
+static void benchmark(int sw, int sh, Uint32 format) {
+    const int tw = 200, th = 283, rounds = 10;
+    SDL_Surface *src = create_noise(sw, sh, SDL_PIXELFORMAT_ARGB8888);
+    if (format != src->format->format) {
+        SDL_Surface *converted = SDL_ConvertSurfaceFormat(src, format, 0);
+        SDL_FreeSurface(src);
+        src = converted;
+    }
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < rounds; i++) {
+        SDL_FreeSurface(legacy_scale(src, tw, th));
+    }
+    Uint64 legacy = SDL_GetPerformanceCounter() - start;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < rounds; i++) {
+        SDL_FreeSurface(img_scale_surface(src, NULL, tw, th, IMG_SCALE_AUTO));
+    }
+    Uint64 area = SDL_GetPerformanceCounter() - start;
+    printf("%dx%d %s -> %dx%d: halving + SDL_BlitScaled %.2f ms, area average (%s) %.2f ms\n", sw, sh,
+           SDL_GetPixelFormatName(format), tw, th, legacy * 1000.0 / freq / rounds, img_scale_simd_name(),
+           area * 1000.0 / freq / rounds);
+    SDL_FreeSurface(src);
+}
+
+int main() {
+    benchmark(628, 888, SDL_PIXELFORMAT_ARGB8888);
+    benchmark(628, 888, SDL_PIXELFORMAT_RGB24);
+    // 4K tall box art
+    benchmark(2716, 3840, SDL_PIXELFORMAT_ARGB8888);
+    benchmark(2716, 3840, SDL_PIXELFORMAT_RGB24);
+    return 0;
+}
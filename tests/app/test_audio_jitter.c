@@ -0,0 +1,134 @@
+#include "unity.h"
+#include "stream/audio/audio_jitter.h"
+
+#define SAMPLE_RATE 48000
+#define FRAME_SAMPLES 240
+#define FRAME_US 5000
+#define TARGET_MS 40
+
+static audio_jitter_t jitter;
+
+void setUp() {
+    audio_jitter_init(&jitter, SAMPLE_RATE, TARGET_MS, false);
+}
+
+void tearDown() {
+}
+
+/**
+ * Feed frames arriving every interval_us, and return the last depth in ms
+ */
+static float feed_frames(uint64_t *now_us, int frames, uint64_t interval_us) {
+    for (int i = 0; i < frames; i++) {
+        int silence = 0;
+        audio_jitter_update(&jitter, *now_us, FRAME_SAMPLES, &silence);
+        *now_us += interval_us;
+    }
+    return audio_jitter_depth_ms(&jitter);
+}
+
+void testPrimesToTarget() {
+    int silence = 0;
+    TEST_ASSERT_EQUAL_INT(FRAME_SAMPLES, audio_jitter_update(&jitter, 1000, FRAME_SAMPLES, &silence));
+    TEST_ASSERT_EQUAL_INT(SAMPLE_RATE * TARGET_MS / 1000, silence);
+    uint64_t now = 1000 + FRAME_US;
+    float depth = feed_frames(&now, 1000, FRAME_US);
+    TEST_ASSERT_TRUE(depth > TARGET_MS - 2 && depth < TARGET_MS + 2);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.underruns);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.dropped_samples);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.inserted_samples);
+}
+
+void testFastHostDrift() {
+    uint64_t now = 1000;
+    // Host clock is 0.2% faster, so frames arrive slightly early
+    float depth = feed_frames(&now, 12000, FRAME_US - 10);
+    TEST_ASSERT_TRUE(depth < TARGET_MS * 1.5f);
+    TEST_ASSERT_TRUE(jitter.dropped_samples > 0);
+    TEST_ASSERT_TRUE(jitter.drift_ppm > 1500 && jitter.drift_ppm < 2500);
+}
+
+void testSlowHostDrift() {
+    uint64_t now = 1000;
+    float depth = feed_frames(&now, 12000, FRAME_US + 10);
+    TEST_ASSERT_TRUE(depth > TARGET_MS * 0.5f);
+    TEST_ASSERT_TRUE(jitter.inserted_samples > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.underruns);
+    TEST_ASSERT_TRUE(jitter.drift_ppm < -1500 && jitter.drift_ppm > -2500);
+}
+
+void testDriftCorrectedWithinTolerance() {
+    uint64_t now = 1000;
+    // Drift is measured within seconds, after that it shouldn't push the queue to the tolerance edge at 50 ms
+    float measured = feed_frames(&now, 1000, FRAME_US - 10);
+    TEST_ASSERT_TRUE(jitter.drift_ppm > 1500 && jitter.drift_ppm < 2500);
+    float depth = feed_frames(&now, 11000, FRAME_US - 10);
+    TEST_ASSERT_TRUE(depth < TARGET_MS * 1.2f);
+    TEST_ASSERT_TRUE(depth > measured - 2 && depth < measured + 2);
+    TEST_ASSERT_TRUE(jitter.dropped_samples > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.inserted_samples);
+}
+
+void testBurstDropsFrames() {
+    uint64_t now = 1000;
+    feed_frames(&now, 100, FRAME_US);
+    // 200 ms worth of frames arrive at once after a stall
+    now += 200000;
+    feed_frames(&now, 40, 0);
+    TEST_ASSERT_TRUE(jitter.dropped_frames > 0);
+    feed_frames(&now, 2000, FRAME_US);
+    TEST_ASSERT_TRUE(audio_jitter_depth_ms(&jitter) < TARGET_MS * 1.5f);
+}
+
+void testUnderrun() {
+    uint64_t now = 1000;
+    feed_frames(&now, 100, FRAME_US);
+    now += 100000;
+    int silence = 0;
+    audio_jitter_update(&jitter, now, FRAME_SAMPLES, &silence);
+    TEST_ASSERT_EQUAL_UINT32(1, jitter.underruns);
+    TEST_ASSERT_EQUAL_INT(SAMPLE_RATE * TARGET_MS / 1000, silence);
+}
+
+void testWholeFrames() {
+    audio_jitter_init(&jitter, SAMPLE_RATE, TARGET_MS, true);
+    uint64_t now = 1000;
+    int silence = 0;
+    TEST_ASSERT_EQUAL_INT(FRAME_SAMPLES, audio_jitter_update(&jitter, now, FRAME_SAMPLES, &silence));
+    TEST_ASSERT_EQUAL_INT(0, silence);
+    feed_frames(&now, 100, FRAME_US);
+    now += 200000;
+    feed_frames(&now, 40, 0);
+    TEST_ASSERT_TRUE(jitter.dropped_frames > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.dropped_samples);
+    TEST_ASSERT_EQUAL_UINT32(0, jitter.inserted_samples);
+}
+
+void testResize() {
+    int16_t pcm[2 * 12] = {0, 0, 1, -1, 2, -2, 3, -3, 4, -4, 5, -5, 6, -6, 7, -7, 8, -8, 9, -9};
+    audio_jitter_resize(pcm, 2, 10, 12);
+    // Every channel pair must stay together
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_INT(-pcm[i * 2], pcm[i * 2 + 1]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, pcm[0]);
+    TEST_ASSERT_EQUAL_INT(9, pcm[22]);
+    audio_jitter_resize(pcm, 2, 12, 10);
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(-pcm[i * 2], pcm[i * 2 + 1]);
+        TEST_ASSERT_TRUE(i == 0 || pcm[i * 2] >= pcm[i * 2 - 2]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testPrimesToTarget);
+    RUN_TEST(testFastHostDrift);
+    RUN_TEST(testSlowHostDrift);
+    RUN_TEST(testDriftCorrectedWithinTolerance);
+    RUN_TEST(testBurstDropsFrames);
+    RUN_TEST(testUnderrun);
+    RUN_TEST(testWholeFrames);
+    RUN_TEST(testResize);
+    return UNITY_END();
+}
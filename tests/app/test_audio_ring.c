@@ -0,0 +1,107 @@
+#include <SDL.h>
+#include "unity.h"
+#include "stream/audio/audio_ring.h"
+
+#define PACKETS 100000
+
+static audio_ring_t ring;
+
+void setUp() {
+}
+
+void tearDown() {
+    audio_ring_deinit(&ring);
+}
+
+void testPushPop() {
+    TEST_ASSERT_TRUE(audio_ring_init(&ring, 4, 16, AUDIO_RING_DROP_NEWEST));
+    TEST_ASSERT_TRUE(audio_ring_push(&ring, "abc", 3));
+    TEST_ASSERT_TRUE(audio_ring_push(&ring, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(2, audio_ring_depth(&ring));
+    int length = -1;
+    const unsigned char *packet = audio_ring_peek(&ring, &length);
+    TEST_ASSERT_NOT_NULL(packet);
+    TEST_ASSERT_EQUAL_INT(3, length);
+    TEST_ASSERT_EQUAL_MEMORY("abc", packet, 3);
+    audio_ring_release(&ring);
+    packet = audio_ring_peek(&ring, &length);
+    TEST_ASSERT_NOT_NULL(packet);
+    TEST_ASSERT_EQUAL_INT(0, length);
+    audio_ring_release(&ring);
+    TEST_ASSERT_NULL(audio_ring_peek(&ring, &length));
+}
+
+void testInvalidCapacity() {
+    TEST_ASSERT_FALSE(audio_ring_init(&ring, 6, 16, AUDIO_RING_DROP_NEWEST));
+}
+
+void testOversized() {
+    TEST_ASSERT_TRUE(audio_ring_init(&ring, 4, 4, AUDIO_RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(audio_ring_push(&ring, "abcdef", 6));
+    TEST_ASSERT_EQUAL_INT(1, SDL_AtomicGet(&ring.oversized));
+    TEST_ASSERT_EQUAL_INT(0, audio_ring_depth(&ring));
+}
+
+void testDropNewest() {
+    TEST_ASSERT_TRUE(audio_ring_init(&ring, 4, 4, AUDIO_RING_DROP_NEWEST));
+    for (unsigned char i = 0; i < 6; i++) {
+        audio_ring_push(&ring, &i, 1);
+    }
+    TEST_ASSERT_EQUAL_INT(2, SDL_AtomicGet(&ring.overflows));
+    TEST_ASSERT_EQUAL_INT(4, SDL_AtomicGet(&ring.high_water));
+    int length;
+    TEST_ASSERT_EQUAL_INT(0, *audio_ring_peek(&ring, &length));
+}
+
+void testDropOldest() {
+    TEST_ASSERT_TRUE(audio_ring_init(&ring, 4, 4, AUDIO_RING_DROP_OLDEST));
+    for (unsigned char i = 0; i < 5; i++) {
+        audio_ring_push(&ring, &i, 1);
+    }
+    int length;
+    // Oldest half is discarded, packet 4 was lost on overflow
+    TEST_ASSERT_EQUAL_INT(2, *audio_ring_peek(&ring, &length));
+    TEST_ASSERT_EQUAL_INT(2, SDL_AtomicGet(&ring.discarded));
+    TEST_ASSERT_EQUAL_INT(2, audio_ring_depth(&ring));
+}
+
+static int producer(void *arg) {
+    (void) arg;
+    for (uint32_t i = 0; i < PACKETS; i++) {
+        while (!audio_ring_push(&ring, &i, sizeof(i))) {
+            SDL_Delay(0);
+        }
+    }
+    return 0;
+}
+
+void testConcurrentOrder() {
+    TEST_ASSERT_TRUE(audio_ring_init(&ring, 64, sizeof(uint32_t), AUDIO_RING_DROP_NEWEST));
+    SDL_Thread *thread = SDL_CreateThread(producer, "producer", NULL);
+    uint32_t expected = 0;
+    while (expected < PACKETS) {
+        int length;
+        const unsigned char *packet = audio_ring_peek(&ring, &length);
+        if (packet == NULL) {
+            continue;
+        }
+        uint32_t value;
+        memcpy(&value, packet, sizeof(value));
+        TEST_ASSERT_EQUAL_UINT32(expected, value);
+        audio_ring_release(&ring);
+        expected++;
+    }
+    SDL_WaitThread(thread, NULL);
+    TEST_ASSERT_EQUAL_INT(0, audio_ring_depth(&ring));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testPushPop);
+    RUN_TEST(testInvalidCapacity);
+    RUN_TEST(testOversized);
+    RUN_TEST(testDropNewest);
+    RUN_TEST(testDropOldest);
+    RUN_TEST(testConcurrentOrder);
+    return UNITY_END();
+}
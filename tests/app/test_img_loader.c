@@ -0,0 +1,355 @@
+#include "unity.h"
+#include "util/img_loader.h"
+#include "util/lane_executor.h"
+
+#include <SDL2/SDL.h>
+
+#define COVERS 128
+#define WORKERS 6
+#define MAX_IN_FLIGHT (WORKERS * 2)
+#define FILECACHE_DELAY_MS 2
+#define FETCH_DELAY_MS 5
+/* Simulates a busy UI frame between main loop iterations */
+#define MAIN_FRAME_MS 16
+
+typedef struct img_loader_req_t {
+    int id;
+    bool fail;
+    /* Fetch hangs until the task is cancelled, like a download from an unresponsive host */
+    bool stall;
+    /* Stalled fetch saw the cancellation, rather than giving up on its own */
+    bool stall_cancelled;
+    /* Fetch waits for fetch_gate to open */
+    bool hold;
+    bool loaded;
+    bool in_memcache;
+    bool notified;
+    /* Order of fetch, starting from 1 */
+    int fetch_order;
+} img_loader_req_t;
+
+typedef struct main_action_t {
+    img_loader_run_on_main_fn fn;
+    void *args;
+} main_action_t;
+
+static lane_executor_t *executor;
+static img_loader_t *loader;
+static img_loader_req_t requests[COVERS];
+static SDL_mutex *main_lock;
+static main_action_t main_queue[COVERS * 2];
+static int main_queue_length;
+/* Set on worker threads, where assertions can't be used, and checked on main */
+static bool main_queue_overflow;
+static SDL_atomic_t worker_stages_done, fetch_sequence, fetch_gate, filecache_puts;
+static int completed, failed, cancelled, memcache_puts;
+
+static bool fake_memcache_get(img_loader_req_t *req) {
+    return req->in_memcache;
+}
+
+static void fake_memcache_put(img_loader_req_t *req) {
+    TEST_ASSERT_TRUE(req->loaded);
+    memcache_puts++;
+}
+
+static bool fake_filecache_get(img_loader_req_t *req) {
+    (void) req;
+    SDL_Delay(FILECACHE_DELAY_MS);
+    return false;
+}
+
+static void fake_filecache_put(img_loader_req_t *req) {
+    (void) req;
+    SDL_AtomicIncRef(&filecache_puts);
+}
+
+static bool fake_fetch(img_loader_req_t *req) {
+    req->fetch_order = SDL_AtomicIncRef(&fetch_sequence) + 1;
+    if (req->stall) {
+        Uint32 deadline = SDL_GetTicks() + 5000;
+        while (!lane_executor_current_cancelled(executor) && !SDL_TICKS_PASSED(SDL_GetTicks(), deadline)) {
+            SDL_Delay(1);
+        }
+        req->stall_cancelled = lane_executor_current_cancelled(executor);
+        SDL_AtomicIncRef(&worker_stages_done);
+        return false;
+    }
+    while (req->hold && SDL_AtomicGet(&fetch_gate) == 0) {
+        SDL_Delay(1);
+    }
+    SDL_Delay(FETCH_DELAY_MS);
+    SDL_AtomicIncRef(&worker_stages_done);
+    req->loaded = !req->fail;
+    return req->loaded;
+}
+
+static void fake_run_on_main(img_loader_t *l, img_loader_run_on_main_fn fn, void *args) {
+    (void) l;
+    SDL_LockMutex(main_lock);
+    if (main_queue_length < COVERS * 2) {
+        main_queue[main_queue_length++] = (main_action_t) {.fn = fn, .args = args};
+    } else {
+        main_queue_overflow = true;
+    }
+    SDL_UnlockMutex(main_lock);
+}
+
+static void start_cb(img_loader_req_t *req) {
+    req->notified = false;
+}
+
+static void complete_cb(img_loader_req_t *req) {
+    TEST_ASSERT_FALSE(req->notified);
+    req->notified = true;
+    completed++;
+}
+
+static void fail_cb(img_loader_req_t *req) {
+    TEST_ASSERT_FALSE(req->notified);
+    req->notified = true;
+    failed++;
+}
+
+static void cancel_cb(img_loader_req_t *req) {
+    TEST_ASSERT_FALSE(req->notified);
+    req->notified = true;
+    cancelled++;
+}
+
+static const img_loader_impl_t fake_impl = {
+        .memcache_get = fake_memcache_get,
+        .memcache_put = fake_memcache_put,
+        .filecache_get = fake_filecache_get,
+        .filecache_put = fake_filecache_put,
+        .fetch = fake_fetch,
+        .run_on_main = fake_run_on_main,
+};
+
+static const img_loader_cb_t fake_cb = {
+        .start_cb = start_cb,
+        .complete_cb = complete_cb,
+        .fail_cb = fail_cb,
+        .cancel_cb = cancel_cb,
+};
+
+/**
+ * Run queued main thread actions once
+ */
+static void main_drain() {
+    main_action_t actions[COVERS * 2];
+    SDL_LockMutex(main_lock);
+    int count = main_queue_length;
+    SDL_memcpy(actions, main_queue, count * sizeof(main_action_t));
+    main_queue_length = 0;
+    bool overflow = main_queue_overflow;
+    SDL_UnlockMutex(main_lock);
+    TEST_ASSERT_FALSE(overflow);
+    for (int i = 0; i < count; i++) {
+        actions[i].fn(actions[i].args);
+    }
+}
+
+static void main_wait_notified(int expected) {
+    Uint32 start = SDL_GetTicks();
+    while (completed + failed + cancelled < expected) {
+        TEST_ASSERT_TRUE(SDL_GetTicks() - start < 30000);
+        SDL_Delay(MAIN_FRAME_MS);
+        main_drain();
+    }
+}
+
+void setUp() {
+    executor = lane_executor_create("test-img-loader", WORKERS, NULL);
+    loader = img_loader_create(&fake_impl, executor, EXECUTOR_LANE_BACKGROUND, MAX_IN_FLIGHT);
+    main_lock = SDL_CreateMutex();
+    main_queue_length = 0;
+    main_queue_overflow = false;
+    SDL_AtomicSet(&worker_stages_done, 0);
+    SDL_AtomicSet(&fetch_sequence, 0);
+    SDL_AtomicSet(&fetch_gate, 0);
+    SDL_AtomicSet(&filecache_puts, 0);
+    completed = failed = cancelled = memcache_puts = 0;
+    SDL_memset(requests, 0, sizeof(requests));
+    for (int i = 0; i < COVERS; i++) {
+        requests[i].id = i;
+    }
+}
+
+void tearDown() {
+    lane_executor_destroy(executor);
+    main_drain();
+    SDL_DestroyMutex(main_lock);
+}
+
+void testMemcacheHit() {
+    requests[0].in_memcache = true;
+    TEST_ASSERT_NULL(img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE));
+    TEST_ASSERT_EQUAL_INT(1, completed);
+    img_loader_destroy(loader);
+}
+
+void testCompleteAndFail() {
+    requests[1].fail = true;
+    img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_load(loader, &requests[1], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    main_wait_notified(2);
+    TEST_ASSERT_EQUAL_INT(1, completed);
+    TEST_ASSERT_EQUAL_INT(1, failed);
+    TEST_ASSERT_EQUAL_INT(1, memcache_puts);
+    img_loader_destroy(loader);
+}
+
+void testCancel() {
+    img_loader_task_t *tasks[COVERS];
+    for (int i = 0; i < COVERS; i++) {
+        tasks[i] = img_loader_load(loader, &requests[i], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    }
+    for (int i = 0; i < COVERS; i += 2) {
+        img_loader_cancel(loader, tasks[i]);
+    }
+    main_wait_notified(COVERS);
+    TEST_ASSERT_TRUE(cancelled > 0);
+    TEST_ASSERT_EQUAL_INT(COVERS, completed + cancelled);
+    // Images loaded before cancellation still go to memory cache
+    int loaded = 0;
+    for (int i = 0; i < COVERS; i++) {
+        loaded += requests[i].loaded;
+    }
+    TEST_ASSERT_EQUAL_INT(loaded, memcache_puts);
+    img_loader_destroy(loader);
+}
+
+void testDestroyWithTasksInFlight() {
+    for (int i = 0; i < 8; i++) {
+        img_loader_load(loader, &requests[i], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    }
+    img_loader_destroy(loader);
+    lane_executor_destroy(executor);
+    executor = lane_executor_create("test-img-loader", WORKERS, NULL);
+    main_drain();
+    TEST_ASSERT_EQUAL_INT(0, completed + failed + cancelled);
+}
+
+/**
+ * Downloads finishing after destroy must not write to the file cache
+ */
+void testDestroyDuringFetch() {
+    requests[0].hold = true;
+    img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    while (SDL_AtomicGet(&fetch_sequence) == 0) {
+        SDL_Delay(1);
+    }
+    img_loader_destroy(loader);
+    SDL_AtomicSet(&fetch_gate, 1);
+    lane_executor_destroy(executor);
+    executor = lane_executor_create("test-img-loader", WORKERS, NULL);
+    main_drain();
+    TEST_ASSERT_TRUE(requests[0].loaded);
+    TEST_ASSERT_EQUAL_INT(0, SDL_AtomicGet(&filecache_puts));
+    TEST_ASSERT_EQUAL_INT(0, completed + failed + cancelled);
+}
+
+void testVisibleBeforePrefetch() {
+    img_loader_destroy(loader);
+    loader = img_loader_create(&fake_impl, executor, EXECUTOR_LANE_BACKGROUND, 1);
+    // First one is submitted right away, the rest wait
+    img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_PREFETCH);
+    img_loader_load(loader, &requests[1], &fake_cb, IMG_LOADER_PRIORITY_PREFETCH);
+    img_loader_task_t *demoted = img_loader_load(loader, &requests[2], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_task_t *promoted = img_loader_load(loader, &requests[3], &fake_cb, IMG_LOADER_PRIORITY_PREFETCH);
+    img_loader_load(loader, &requests[4], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_set_priority(loader, demoted, IMG_LOADER_PRIORITY_PREFETCH);
+    img_loader_set_priority(loader, promoted, IMG_LOADER_PRIORITY_VISIBLE);
+    main_wait_notified(5);
+    TEST_ASSERT_EQUAL_INT(5, completed);
+    TEST_ASSERT_EQUAL_INT(1, requests[0].fetch_order);
+    TEST_ASSERT_EQUAL_INT(2, requests[4].fetch_order);
+    TEST_ASSERT_EQUAL_INT(3, requests[3].fetch_order);
+    TEST_ASSERT_EQUAL_INT(4, requests[1].fetch_order);
+    TEST_ASSERT_EQUAL_INT(5, requests[2].fetch_order);
+    img_loader_destroy(loader);
+}
+
+void testCancelPendingNeverRuns() {
+    img_loader_destroy(loader);
+    loader = img_loader_create(&fake_impl, executor, EXECUTOR_LANE_BACKGROUND, 1);
+    img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_task_t *pending = img_loader_load(loader, &requests[1], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_cancel(loader, pending);
+    // Callback is never invoked from inside img_loader_cancel()
+    TEST_ASSERT_EQUAL_INT(0, cancelled);
+    main_wait_notified(2);
+    TEST_ASSERT_EQUAL_INT(1, completed);
+    TEST_ASSERT_EQUAL_INT(1, cancelled);
+    TEST_ASSERT_EQUAL_INT(0, requests[1].fetch_order);
+    img_loader_destroy(loader);
+}
+
+/**
+ * Cancelling again before the callback runs must not touch the pending queue or finish the task twice
+ */
+void testCancelTwice() {
+    img_loader_destroy(loader);
+    loader = img_loader_create(&fake_impl, executor, EXECUTOR_LANE_BACKGROUND, 1);
+    img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_task_t *pending = img_loader_load(loader, &requests[1], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_load(loader, &requests[2], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    img_loader_load(loader, &requests[3], &fake_cb, IMG_LOADER_PRIORITY_PREFETCH);
+    img_loader_cancel(loader, pending);
+    img_loader_cancel(loader, pending);
+    main_wait_notified(4);
+    TEST_ASSERT_EQUAL_INT(3, completed);
+    TEST_ASSERT_EQUAL_INT(1, cancelled);
+    TEST_ASSERT_EQUAL_INT(0, requests[1].fetch_order);
+    // Nothing else is left to be delivered
+    SDL_Delay(MAIN_FRAME_MS);
+    main_drain();
+    TEST_ASSERT_EQUAL_INT(1, cancelled);
+    img_loader_destroy(loader);
+}
+
+/**
+ * Cancelling a task that's already downloading should free its worker right away
+ */
+void testCancelReachesFetchInFlight() {
+    requests[0].stall = true;
+    img_loader_task_t *task = img_loader_load(loader, &requests[0], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    while (SDL_AtomicGet(&fetch_sequence) == 0) {
+        SDL_Delay(1);
+    }
+    img_loader_cancel(loader, task);
+    main_wait_notified(1);
+    TEST_ASSERT_TRUE(requests[0].stall_cancelled);
+    TEST_ASSERT_EQUAL_INT(1, cancelled);
+    TEST_ASSERT_EQUAL_INT(0, failed);
+    img_loader_destroy(loader);
+}
+
+/**
+ * Workers should go through all covers while the main thread is busy, instead of waiting for it on every cover
+ */
+void testAllDeliveredWithBusyMainThread() {
+    for (int i = 0; i < COVERS; i++) {
+        img_loader_load(loader, &requests[i], &fake_cb, IMG_LOADER_PRIORITY_VISIBLE);
+    }
+    main_wait_notified(COVERS);
+    TEST_ASSERT_EQUAL_INT(COVERS, completed);
+    TEST_ASSERT_EQUAL_INT(COVERS, memcache_puts);
+    img_loader_destroy(loader);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testMemcacheHit);
+    RUN_TEST(testCompleteAndFail);
+    RUN_TEST(testCancel);
+    RUN_TEST(testDestroyWithTasksInFlight);
+    RUN_TEST(testDestroyDuringFetch);
+    RUN_TEST(testVisibleBeforePrefetch);
+    RUN_TEST(testCancelPendingNeverRuns);
+    RUN_TEST(testCancelTwice);
+    RUN_TEST(testCancelReachesFetchInFlight);
+    RUN_TEST(testAllDeliveredWithBusyMainThread);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include "unity.h"
+#include "util/img_scale.h"
+
+#include <stdlib.h>
+
+#include <SDL.h>
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static SDL_Surface *create_noise(int w, int h, Uint32 format) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, format);
+    for (int y = 0; y < h; y++) {
+        Uint8 *row = (Uint8 *) surface->pixels + y * surface->pitch;
+        for (int x = 0; x < w * 4; x++) {
+            row[x] = rand() & 0xFF;
+        }
+    }
+    return surface;
+}
+
+static const Uint8 *pixel_at(const SDL_Surface *surface, int x, int y) {
+    return (const Uint8 *) surface->pixels + y * surface->pitch + x * surface->format->BytesPerPixel;
+}
+
+void testSolidColorStaysExact() {
+    SDL_Surface *src = SDL_CreateRGBSurfaceWithFormat(0, 628, 888, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_FillRect(src, NULL, 0xFF336699);
+    SDL_Surface *dst = img_scale_surface(src, NULL, 133, 187, IMG_SCALE_AUTO);
+    TEST_ASSERT_NOT_NULL(dst);
+    TEST_ASSERT_EQUAL_INT(SDL_PIXELFORMAT_ARGB8888, dst->format->format);
+    for (int y = 0; y < dst->h; y++) {
+        for (int x = 0; x < dst->w; x++) {
+            TEST_ASSERT_EQUAL_HEX32(0xFF336699, *(const Uint32 *) pixel_at(dst, x, y));
+        }
+    }
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testAreaAveragesCheckerboard() {
+    SDL_Surface *src = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            ((Uint32 *) ((Uint8 *) src->pixels + y * src->pitch))[x] = (x + y) % 2 ? 0xFFFFFFFF : 0xFF000000;
+        }
+    }
+    SDL_Surface *dst = img_scale_surface(src, NULL, 2, 2, IMG_SCALE_AREA);
+    TEST_ASSERT_NOT_NULL(dst);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 2; x++) {
+            const Uint8 *px = pixel_at(dst, x, y);
+            for (int c = 0; c < 4; c++) {
+                TEST_ASSERT_UINT8_WITHIN(1, c == 3 ? 255 : 128, px[c]);
+            }
+        }
+    }
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testCropsSourceRect() {
+    SDL_Surface *src = SDL_CreateRGBSurfaceWithFormat(0, 64, 32, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Rect left = {0, 0, 32, 32}, right = {32, 0, 32, 32};
+    SDL_FillRect(src, &left, 0xFFFF0000);
+    SDL_FillRect(src, &right, 0xFF0000FF);
+    SDL_Surface *dst = img_scale_surface(src, &right, 10, 10, IMG_SCALE_AUTO);
+    TEST_ASSERT_NOT_NULL(dst);
+    for (int y = 0; y < dst->h; y++) {
+        for (int x = 0; x < dst->w; x++) {
+            TEST_ASSERT_EQUAL_HEX32(0xFF0000FF, *(const Uint32 *) pixel_at(dst, x, y));
+        }
+    }
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testMatchesReferenceAreaAverage() {
+    const int sw = 97, sh = 131, dw = 23, dh = 31;
+    SDL_Surface *src = create_noise(sw, sh, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Surface *dst = img_scale_surface(src, NULL, dw, dh, IMG_SCALE_AREA);
+    TEST_ASSERT_NOT_NULL(dst);
+    const double sx = sw / (double) dw, sy = sh / (double) dh;
+    for (int y = 0; y < dh; y++) {
+        for (int x = 0; x < dw; x++) {
+            double sum[4] = {0, 0, 0, 0};
+            for (int py = 0; py < sh; py++) {
+                double wy = SDL_min(py + 1, (y + 1) * sy) - SDL_max(py, y * sy);
+                if (wy <= 0) { continue; }
+                for (int px = 0; px < sw; px++) {
+                    double wx = SDL_min(px + 1, (x + 1) * sx) - SDL_max(px, x * sx);
+                    if (wx <= 0) { continue; }
+                    for (int c = 0; c < 4; c++) {
+                        sum[c] += pixel_at(src, px, py)[c] * wx * wy;
+                    }
+                }
+            }
+            for (int c = 0; c < 4; c++) {
+                // Intermediate rows are rounded to 8 bits
+                TEST_ASSERT_UINT8_WITHIN(2, (Uint8) (sum[c] / (sx * sy) + 0.5), pixel_at(dst, x, y)[c]);
+            }
+        }
+    }
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testFillsAlphaFor24Bit() {
+    SDL_Surface *src = SDL_CreateRGBSurfaceWithFormat(0, 30, 40, 24, SDL_PIXELFORMAT_RGB24);
+    SDL_FillRect(src, NULL, SDL_MapRGB(src->format, 10, 20, 30));
+    SDL_Surface *dst = img_scale_surface(src, NULL, 9, 12, IMG_SCALE_AUTO);
+    TEST_ASSERT_NOT_NULL(dst);
+    TEST_ASSERT_EQUAL_INT(SDL_PIXELFORMAT_RGBA32, dst->format->format);
+    const Uint8 *px = pixel_at(dst, 4, 5);
+    TEST_ASSERT_EQUAL_UINT8(10, px[0]);
+    TEST_ASSERT_EQUAL_UINT8(20, px[1]);
+    TEST_ASSERT_EQUAL_UINT8(30, px[2]);
+    TEST_ASSERT_EQUAL_UINT8(255, px[3]);
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testBilinearUpscaleIsMonotonic() {
+    SDL_Surface *src = SDL_CreateRGBSurfaceWithFormat(0, 2, 1, 32, SDL_PIXELFORMAT_ARGB8888);
+    ((Uint32 *) src->pixels)[0] = 0xFF000000;
+    ((Uint32 *) src->pixels)[1] = 0xFFFFFFFF;
+    SDL_Surface *dst = img_scale_surface(src, NULL, 8, 1, IMG_SCALE_AUTO);
+    TEST_ASSERT_NOT_NULL(dst);
+    const Uint32 *row = dst->pixels;
+    TEST_ASSERT_EQUAL_HEX32(0xFF000000, row[0]);
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, row[7]);
+    for (int x = 1; x < 8; x++) {
+        TEST_ASSERT_TRUE((row[x] & 0xFF) >= (row[x - 1] & 0xFF));
+    }
+    SDL_FreeSurface(dst);
+    SDL_FreeSurface(src);
+}
+
+void testRejectsInvalidArguments() {
+    Uint8 pixels[16], out[16];
+    img_scale_src_t src = {.pixels = pixels, .pitch = 8, .bpp = 2, .rect = {0, 0, 2, 2}};
+    TEST_ASSERT_EQUAL_INT(-1, img_scale(&src, out, 2, 2, 8, IMG_SCALE_AUTO));
+    src.bpp = 4;
+    TEST_ASSERT_EQUAL_INT(-1, img_scale(&src, out, 2, 2, 4, IMG_SCALE_AUTO));
+    TEST_ASSERT_EQUAL_INT(0, img_scale(&src, out, 2, 2, 8, IMG_SCALE_AUTO));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testSolidColorStaysExact);
+    RUN_TEST(testAreaAveragesCheckerboard);
+    RUN_TEST(testCropsSourceRect);
+    RUN_TEST(testMatchesReferenceAreaAverage);
+    RUN_TEST(testFillsAlphaFor24Bit);
+    RUN_TEST(testBilinearUpscaleIsMonotonic);
+    RUN_TEST(testRejectsInvalidArguments);
+    return UNITY_END();
+}
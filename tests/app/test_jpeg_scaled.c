@@ -0,0 +1,131 @@
+#include "unity.h"
+#include "util/jpeg_scaled.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL.h>
+#include <jpeglib.h>
+
+static char path[64];
+
+void setUp() {
+    snprintf(path, sizeof(path), "/tmp/moonlight-test-%d.jpg", rand());
+}
+
+void tearDown() {
+    remove(path);
+}
+
+static void write_jpeg(int w, int h) {
+    FILE *fp = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error(&err);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, fp);
+    cinfo.image_width = w;
+    cinfo.image_height = h;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    JSAMPLE *row = malloc(w * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        for (int x = 0; x < w; x++) {
+            row[x * 3] = x * 255 / w;
+            row[x * 3 + 1] = cinfo.next_scanline * 255 / h;
+            row[x * 3 + 2] = 128;
+        }
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    free(row);
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(fp);
+}
+
+void testPicksSmallestCoveringScale() {
+    write_jpeg(2716, 3840);
+    int full_w = 0, full_h = 0;
+    SDL_Surface *surface = jpeg_decode_scaled(path, 200, 283, &full_w, &full_h);
+    TEST_ASSERT_NOT_NULL(surface);
+    TEST_ASSERT_EQUAL_INT(2716, full_w);
+    TEST_ASSERT_EQUAL_INT(3840, full_h);
+    TEST_ASSERT_EQUAL_INT(SDL_PIXELFORMAT_RGB24, surface->format->format);
+    // 1/8 is 340x480, still larger than the target
+    TEST_ASSERT_EQUAL_INT(340, surface->w);
+    TEST_ASSERT_EQUAL_INT(480, surface->h);
+    SDL_FreeSurface(surface);
+}
+
+void testKeepsSizeWhenNeeded() {
+    write_jpeg(628, 888);
+    SDL_Surface *surface = jpeg_decode_scaled(path, 300, 400, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(surface);
+    TEST_ASSERT_EQUAL_INT(314, surface->w);
+    TEST_ASSERT_EQUAL_INT(444, surface->h);
+    SDL_FreeSurface(surface);
+
+    surface = jpeg_decode_scaled(path, 400, 400, NULL, NULL);
+    TEST_ASSERT_NOT_NULL(surface);
+    TEST_ASSERT_EQUAL_INT(628, surface->w);
+    TEST_ASSERT_EQUAL_INT(888, surface->h);
+    SDL_FreeSurface(surface);
+}
+
+void testIgnoresNonJpeg() {
+    FILE *fp = fopen(path, "wb");
+    fwrite("\x89PNG\r\n\x1a\n", 1, 8, fp);
+    fclose(fp);
+    TEST_ASSERT_NULL(jpeg_decode_scaled(path, 100, 100, NULL, NULL));
+}
+
+void testFailsOnTruncatedFile() {
+    FILE *fp = fopen(path, "wb");
+    fwrite("\xFF\xD8\xFF\xE0\x00\x10JFIF", 1, 10, fp);
+    fclose(fp);
+    TEST_ASSERT_NULL(jpeg_decode_scaled(path, 100, 100, NULL, NULL));
+}
+
+static void benchmark(int w, int h) {
+    const int tw = 200, th = 283, rounds = 5;
+    write_jpeg(w, h);
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    size_t full_bytes = 0, scaled_bytes = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < rounds; i++) {
+        SDL_Surface *surface = jpeg_decode_scaled(path, w, h, NULL, NULL);
+        TEST_ASSERT_NOT_NULL(surface);
+        full_bytes = surface->pitch * surface->h;
+        SDL_FreeSurface(surface);
+    }
+    Uint64 full = SDL_GetPerformanceCounter() - start;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < rounds; i++) {
+        SDL_Surface *surface = jpeg_decode_scaled(path, tw, th, NULL, NULL);
+        TEST_ASSERT_NOT_NULL(surface);
+        scaled_bytes = surface->pitch * surface->h;
+        SDL_FreeSurface(surface);
+    }
+    Uint64 scaled = SDL_GetPerformanceCounter() - start;
+    printf("%dx%d JPEG for %dx%d: full decode %.2f ms / %zu KB, scaled decode %.2f ms / %zu KB\n", w, h, tw, th,
+           full * 1000.0 / freq / rounds, full_bytes / 1024, scaled * 1000.0 / freq / rounds, scaled_bytes / 1024);
+}
+
+void testBenchmark() {
+    benchmark(628, 888);
+    benchmark(2716, 3840);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testPicksSmallestCoveringScale);
+    RUN_TEST(testKeepsSizeWhenNeeded);
+    RUN_TEST(testIgnoresNonJpeg);
+    RUN_TEST(testFailsOnTruncatedFile);
+    RUN_TEST(testBenchmark);
+    return UNITY_END();
+}
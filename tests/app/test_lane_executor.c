@@ -0,0 +1,299 @@
+#include "unity.h"
+#include "util/lane_executor.h"
+
+#include <errno.h>
+
+#include <SDL2/SDL.h>
+
+#define WORKERS 4
+#define MAX_ORDER 64
+
+static lane_executor_t *executor;
+static SDL_atomic_t gate, running, max_running, finished, sequence;
+static int run_order[MAX_ORDER];
+
+typedef struct test_task_t {
+    int id;
+    int delay_ms;
+    bool wait_gate;
+    bool ran;
+    int result;
+    SDL_atomic_t done;
+} test_task_t;
+
+static int task_action(test_task_t *task) {
+    int now = SDL_AtomicIncRef(&running) + 1;
+    for (int max = SDL_AtomicGet(&max_running); now > max; max = SDL_AtomicGet(&max_running)) {
+        if (SDL_AtomicCAS(&max_running, max, now)) {
+            break;
+        }
+    }
+    int order = SDL_AtomicIncRef(&sequence);
+    if (order < MAX_ORDER) {
+        run_order[order] = task->id;
+    }
+    task->ran = true;
+    while (task->wait_gate && !SDL_AtomicGet(&gate)) {
+        SDL_Delay(1);
+    }
+    if (task->delay_ms > 0) {
+        SDL_Delay(task->delay_ms);
+    }
+    SDL_AtomicDecRef(&running);
+    return 0;
+}
+
+static void task_cleanup(test_task_t *task, int result) {
+    task->result = result;
+    SDL_AtomicSet(&task->done, 1);
+    SDL_AtomicIncRef(&finished);
+}
+
+static lane_task_id_t submit(test_task_t *task, executor_lane_t lane) {
+    return lane_executor_submit(executor, lane, (executor_action_cb) task_action, (executor_cleanup_cb) task_cleanup,
+                                task);
+}
+
+static void wait_finished(int count) {
+    Uint32 deadline = SDL_GetTicks() + 5000;
+    while (SDL_AtomicGet(&finished) < count && !SDL_TICKS_PASSED(SDL_GetTicks(), deadline)) {
+        SDL_Delay(1);
+    }
+    TEST_ASSERT_EQUAL_INT(count, SDL_AtomicGet(&finished));
+}
+
+static void wait_running(int count) {
+    Uint32 deadline = SDL_GetTicks() + 5000;
+    while (SDL_AtomicGet(&running) < count && !SDL_TICKS_PASSED(SDL_GetTicks(), deadline)) {
+        SDL_Delay(1);
+    }
+    TEST_ASSERT_EQUAL_INT(count, SDL_AtomicGet(&running));
+}
+
+void setUp() {
+    SDL_AtomicSet(&gate, 0);
+    SDL_AtomicSet(&running, 0);
+    SDL_AtomicSet(&max_running, 0);
+    SDL_AtomicSet(&finished, 0);
+    SDL_AtomicSet(&sequence, 0);
+    SDL_memset(run_order, 0, sizeof(run_order));
+    executor = NULL;
+}
+
+void tearDown() {
+    SDL_AtomicSet(&gate, 1);
+    if (executor != NULL) {
+        lane_executor_destroy(executor);
+    }
+}
+
+void testRunsEverything() {
+    executor = lane_executor_create("test", WORKERS, NULL);
+    static test_task_t tasks[300];
+    for (int i = 0; i < 300; i++) {
+        tasks[i] = (test_task_t) {.id = i};
+        submit(&tasks[i], i % EXECUTOR_LANE_COUNT);
+    }
+    wait_finished(300);
+    for (int lane = 0; lane < EXECUTOR_LANE_COUNT; lane++) {
+        lane_executor_stats_t stats;
+        lane_executor_get_stats(executor, lane, &stats);
+        TEST_ASSERT_EQUAL_INT(100, stats.submitted);
+        TEST_ASSERT_EQUAL_INT(100, stats.completed);
+        TEST_ASSERT_EQUAL_INT(100, stats.wait.count);
+        TEST_ASSERT_EQUAL_INT(0, stats.queued);
+    }
+    for (int i = 0; i < 300; i++) {
+        TEST_ASSERT_TRUE(tasks[i].ran);
+        TEST_ASSERT_EQUAL_INT(0, tasks[i].result);
+    }
+}
+
+void testInteractiveJumpsQueue() {
+    executor = lane_executor_create("test", 1, NULL);
+    test_task_t blocker = {.id = 100, .wait_gate = true};
+    submit(&blocker, EXECUTOR_LANE_BACKGROUND);
+    wait_running(1);
+    test_task_t background[5], normal = {.id = 50}, interactive = {.id = 10};
+    for (int i = 0; i < 5; i++) {
+        background[i] = (test_task_t) {.id = 200 + i};
+        submit(&background[i], EXECUTOR_LANE_BACKGROUND);
+    }
+    submit(&normal, EXECUTOR_LANE_NORMAL);
+    submit(&interactive, EXECUTOR_LANE_INTERACTIVE);
+    SDL_AtomicSet(&gate, 1);
+    wait_finished(8);
+    TEST_ASSERT_EQUAL_INT(100, run_order[0]);
+    TEST_ASSERT_EQUAL_INT(10, run_order[1]);
+    TEST_ASSERT_EQUAL_INT(50, run_order[2]);
+    // Same lane keeps submission order
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(200 + i, run_order[3 + i]);
+    }
+}
+
+void testLaneLimitKeepsWorkersFree() {
+    const int limits[EXECUTOR_LANE_COUNT] = {0, 0, 1};
+    executor = lane_executor_create("test", WORKERS, limits);
+    test_task_t background[8];
+    for (int i = 0; i < 8; i++) {
+        background[i] = (test_task_t) {.id = i, .wait_gate = true};
+        submit(&background[i], EXECUTOR_LANE_BACKGROUND);
+    }
+    wait_running(1);
+    test_task_t interactive = {.id = 100};
+    submit(&interactive, EXECUTOR_LANE_INTERACTIVE);
+    // Runs on a free worker while the background lane is still stuck at its limit
+    wait_finished(1);
+    TEST_ASSERT_TRUE(SDL_AtomicGet(&interactive.done));
+    lane_executor_stats_t stats;
+    lane_executor_get_stats(executor, EXECUTOR_LANE_BACKGROUND, &stats);
+    TEST_ASSERT_EQUAL_INT(7, stats.queued);
+
+    SDL_AtomicSet(&gate, 1);
+    wait_finished(9);
+    TEST_ASSERT_EQUAL_INT(2, SDL_AtomicGet(&max_running));
+}
+
+static test_task_t spawned[WORKERS * 4];
+
+static int spawn_action(void *arg) {
+    (void) arg;
+    for (int i = 0; i < WORKERS * 4; i++) {
+        spawned[i] = (test_task_t) {.id = i, .delay_ms = 10};
+        submit(&spawned[i], EXECUTOR_LANE_NORMAL);
+    }
+    // Keep our worker busy, so the others have to steal
+    SDL_Delay(50);
+    return 0;
+}
+
+static void spawn_cleanup(void *arg, int result) {
+    (void) arg;
+    (void) result;
+    SDL_AtomicIncRef(&finished);
+}
+
+void testIdleWorkersSteal() {
+    executor = lane_executor_create("test", WORKERS, NULL);
+    lane_executor_submit(executor, EXECUTOR_LANE_NORMAL, spawn_action, spawn_cleanup, NULL);
+    wait_finished(WORKERS * 4 + 1);
+    lane_executor_stats_t stats;
+    lane_executor_get_stats(executor, EXECUTOR_LANE_NORMAL, &stats);
+    TEST_ASSERT_TRUE(stats.stolen >= WORKERS * 2);
+    TEST_ASSERT_TRUE(SDL_AtomicGet(&max_running) > 1);
+}
+
+void testCancelPending() {
+    executor = lane_executor_create("test", 1, NULL);
+    test_task_t blocker = {.id = 1, .wait_gate = true}, pending = {.id = 2};
+    lane_task_id_t blocker_handle = submit(&blocker, EXECUTOR_LANE_NORMAL);
+    wait_running(1);
+    lane_task_id_t handle = submit(&pending, EXECUTOR_LANE_BACKGROUND);
+    TEST_ASSERT_EQUAL_INT(LANE_TASK_STATE_ACTIVE, lane_executor_task_state(executor, blocker_handle));
+    TEST_ASSERT_EQUAL_INT(LANE_TASK_STATE_PENDING, lane_executor_task_state(executor, handle));
+    lane_executor_cancel(executor, handle);
+    // Cleaned up right away, without waiting for a worker
+    TEST_ASSERT_TRUE(SDL_AtomicGet(&pending.done));
+    TEST_ASSERT_EQUAL_INT(ECANCELED, pending.result);
+    TEST_ASSERT_EQUAL_INT(LANE_TASK_STATE_NONE, lane_executor_task_state(executor, handle));
+    SDL_AtomicSet(&gate, 1);
+    wait_finished(2);
+    TEST_ASSERT_FALSE(pending.ran);
+    TEST_ASSERT_EQUAL_INT(0, blocker.result);
+}
+
+void testCancelActive() {
+    executor = lane_executor_create("test", 2, NULL);
+    test_task_t task = {.id = 1, .wait_gate = true};
+    lane_task_id_t handle = submit(&task, EXECUTOR_LANE_INTERACTIVE);
+    wait_running(1);
+    lane_executor_cancel(executor, handle);
+    TEST_ASSERT_FALSE(SDL_AtomicGet(&task.done));
+    SDL_AtomicSet(&gate, 1);
+    wait_finished(1);
+    TEST_ASSERT_EQUAL_INT(ECANCELED, task.result);
+    lane_executor_stats_t stats;
+    lane_executor_get_stats(executor, EXECUTOR_LANE_INTERACTIVE, &stats);
+    TEST_ASSERT_EQUAL_INT(1, stats.cancelled);
+    TEST_ASSERT_EQUAL_INT(0, stats.completed);
+}
+
+/**
+ * Finished task's memory may be reused by the next one, its id must not match it
+ */
+void testFinishedIdIgnored() {
+    executor = lane_executor_create("test", 1, NULL);
+    test_task_t finished_task = {.id = 1}, blocker = {.id = 2, .wait_gate = true};
+    lane_task_id_t finished_handle = submit(&finished_task, EXECUTOR_LANE_NORMAL);
+    wait_finished(1);
+    lane_task_id_t handle = submit(&blocker, EXECUTOR_LANE_NORMAL);
+    wait_running(1);
+    TEST_ASSERT_NOT_EQUAL(finished_handle, handle);
+    TEST_ASSERT_EQUAL_INT(LANE_TASK_STATE_NONE, lane_executor_task_state(executor, finished_handle));
+    lane_executor_cancel(executor, finished_handle);
+    TEST_ASSERT_EQUAL_INT(LANE_TASK_STATE_ACTIVE, lane_executor_task_state(executor, handle));
+    SDL_AtomicSet(&gate, 1);
+    wait_finished(2);
+    TEST_ASSERT_EQUAL_INT(0, blocker.result);
+}
+
+static SDL_atomic_t poll_started;
+
+static int poll_cancelled_action(bool *saw_cancel) {
+    SDL_AtomicSet(&poll_started, 1);
+    Uint32 deadline = SDL_GetTicks() + 5000;
+    while (!lane_executor_current_cancelled(executor) && !SDL_TICKS_PASSED(SDL_GetTicks(), deadline)) {
+        SDL_Delay(1);
+    }
+    // Otherwise it has run into the deadline
+    *saw_cancel = lane_executor_current_cancelled(executor);
+    return 0;
+}
+
+void testActionSeesCancellation() {
+    executor = lane_executor_create("test", 2, NULL);
+    TEST_ASSERT_EQUAL_INT(0, lane_executor_current_task(executor));
+    TEST_ASSERT_FALSE(lane_executor_current_cancelled(executor));
+    SDL_AtomicSet(&poll_started, 0);
+    bool saw_cancel = false;
+    lane_task_id_t handle = lane_executor_submit(executor, EXECUTOR_LANE_NORMAL,
+                                                 (executor_action_cb) poll_cancelled_action, spawn_cleanup,
+                                                 &saw_cancel);
+    while (!SDL_AtomicGet(&poll_started)) {
+        SDL_Delay(1);
+    }
+    lane_executor_cancel(executor, handle);
+    wait_finished(1);
+    TEST_ASSERT_TRUE(saw_cancel);
+}
+
+void testDestroyCancelsPending() {
+    executor = lane_executor_create("test", 1, NULL);
+    test_task_t blocker = {.id = 1, .wait_gate = true}, pending[3];
+    submit(&blocker, EXECUTOR_LANE_NORMAL);
+    wait_running(1);
+    for (int i = 0; i < 3; i++) {
+        pending[i] = (test_task_t) {.id = 2 + i};
+        submit(&pending[i], EXECUTOR_LANE_BACKGROUND);
+    }
+    SDL_AtomicSet(&gate, 1);
+    lane_executor_destroy(executor);
+    executor = NULL;
+    TEST_ASSERT_EQUAL_INT(4, SDL_AtomicGet(&finished));
+    TEST_ASSERT_EQUAL_INT(0, blocker.result);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testRunsEverything);
+    RUN_TEST(testInteractiveJumpsQueue);
+    RUN_TEST(testLaneLimitKeepsWorkersFree);
+    RUN_TEST(testIdleWorkersSteal);
+    RUN_TEST(testCancelPending);
+    RUN_TEST(testCancelActive);
+    RUN_TEST(testFinishedIdIgnored);
+    RUN_TEST(testActionSeesCancellation);
+    RUN_TEST(testDestroyCancelsPending);
+    return UNITY_END();
+}
@@ -0,0 +1,69 @@
+#include "unity.h"
+#include "util/latency_histogram.h"
+
+static latency_histogram_t histogram;
+
+void setUp() {
+    latency_histogram_reset(&histogram);
+}
+
+void tearDown() {
+}
+
+void testEmpty() {
+    TEST_ASSERT_EQUAL_UINT32(0, latency_histogram_percentile(&histogram, 50));
+    TEST_ASSERT_EQUAL_UINT32(0, latency_histogram_average(&histogram));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.max_us);
+}
+
+void testPercentiles() {
+    // 1 ms to 100 ms, one sample each
+    for (uint32_t i = 1; i <= 100; i++) {
+        latency_histogram_record(&histogram, i * 1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, histogram.count);
+    TEST_ASSERT_EQUAL_UINT32(100000, histogram.max_us);
+    TEST_ASSERT_EQUAL_UINT32(50500, latency_histogram_average(&histogram));
+    // Each value sits at the lower bound of its bucket, so percentiles report the next bound
+    TEST_ASSERT_EQUAL_UINT32(51000, latency_histogram_percentile(&histogram, 50));
+    TEST_ASSERT_EQUAL_UINT32(96000, latency_histogram_percentile(&histogram, 95));
+    TEST_ASSERT_EQUAL_UINT32(100000, latency_histogram_percentile(&histogram, 100));
+}
+
+void testFineBuckets() {
+    latency_histogram_record(&histogram, 1230);
+    latency_histogram_record(&histogram, 1250);
+    latency_histogram_record(&histogram, 8000);
+    TEST_ASSERT_EQUAL_UINT32(1300, latency_histogram_percentile(&histogram, 50));
+    // Never report more than the max
+    TEST_ASSERT_EQUAL_UINT32(8000, latency_histogram_percentile(&histogram, 99));
+}
+
+void testOverflow() {
+    latency_histogram_record(&histogram, 5000000);
+    TEST_ASSERT_EQUAL_UINT32(1, histogram.buckets[LATENCY_HISTOGRAM_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL_UINT32(5000000, latency_histogram_percentile(&histogram, 50));
+}
+
+void testMerge() {
+    latency_histogram_t other;
+    latency_histogram_reset(&other);
+    latency_histogram_record(&histogram, 2000);
+    latency_histogram_record(&other, 4000);
+    latency_histogram_record(&other, 30000);
+    latency_histogram_merge(&histogram, &other);
+    TEST_ASSERT_EQUAL_UINT32(3, histogram.count);
+    TEST_ASSERT_EQUAL_UINT32(30000, histogram.max_us);
+    TEST_ASSERT_EQUAL_UINT32(12000, latency_histogram_average(&histogram));
+    TEST_ASSERT_EQUAL_UINT32(4100, latency_histogram_percentile(&histogram, 50));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testEmpty);
+    RUN_TEST(testPercentiles);
+    RUN_TEST(testFineBuckets);
+    RUN_TEST(testOverflow);
+    RUN_TEST(testMerge);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+#include <SDL.h>
+#include "unity.h"
+#include "util/mpsc_queue.h"
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 50000
+
+typedef struct item_t {
+    mpsc_node_t node;
+    int producer;
+    int seq;
+} item_t;
+
+static mpsc_queue_t queue;
+static item_t items[PRODUCERS][ITEMS_PER_PRODUCER];
+static int producer_ids[PRODUCERS];
+
+static int producer_worker(void *arg);
+
+void setUp() {
+    mpsc_queue_init(&queue);
+}
+
+void tearDown() {
+}
+
+void testEmpty() {
+    TEST_ASSERT_NULL(mpsc_queue_pop(&queue));
+    TEST_ASSERT_EQUAL_INT(0, mpsc_queue_depth(&queue));
+}
+
+void testFifo() {
+    for (int i = 0; i < 3; i++) {
+        items[0][i].seq = i;
+        mpsc_queue_push(&queue, &items[0][i].node);
+    }
+    TEST_ASSERT_EQUAL_INT(3, mpsc_queue_depth(&queue));
+    for (int i = 0; i < 3; i++) {
+        item_t *item = (item_t *) mpsc_queue_pop(&queue);
+        TEST_ASSERT_NOT_NULL(item);
+        TEST_ASSERT_EQUAL_INT(i, item->seq);
+    }
+    TEST_ASSERT_NULL(mpsc_queue_pop(&queue));
+    TEST_ASSERT_EQUAL_INT(0, mpsc_queue_depth(&queue));
+}
+
+void testReuseAfterEmpty() {
+    mpsc_queue_push(&queue, &items[0][0].node);
+    TEST_ASSERT_EQUAL_PTR(&items[0][0], mpsc_queue_pop(&queue));
+    TEST_ASSERT_NULL(mpsc_queue_pop(&queue));
+    mpsc_queue_push(&queue, &items[0][0].node);
+    mpsc_queue_push(&queue, &items[0][1].node);
+    TEST_ASSERT_EQUAL_PTR(&items[0][0], mpsc_queue_pop(&queue));
+    TEST_ASSERT_EQUAL_PTR(&items[0][1], mpsc_queue_pop(&queue));
+    TEST_ASSERT_NULL(mpsc_queue_pop(&queue));
+}
+
+void testConcurrentProducers() {
+    SDL_Thread *threads[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        producer_ids[i] = i;
+        threads[i] = SDL_CreateThread(producer_worker, "producer", &producer_ids[i]);
+    }
+    int next_seq[PRODUCERS] = {0};
+    int received = 0;
+    while (received < PRODUCERS * ITEMS_PER_PRODUCER) {
+        item_t *item = (item_t *) mpsc_queue_pop(&queue);
+        if (item == NULL) {
+            continue;
+        }
+        // Items of each producer come out in the order they were pushed
+        TEST_ASSERT_EQUAL_INT(next_seq[item->producer], item->seq);
+        next_seq[item->producer]++;
+        received++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    TEST_ASSERT_NULL(mpsc_queue_pop(&queue));
+    TEST_ASSERT_EQUAL_INT(0, mpsc_queue_depth(&queue));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testEmpty);
+    RUN_TEST(testFifo);
+    RUN_TEST(testReuseAfterEmpty);
+    RUN_TEST(testConcurrentProducers);
+    return UNITY_END();
+}
+
+static int producer_worker(void *arg) {
+    int producer = *(int *) arg;
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        item_t *item = &items[producer][i];
+        item->producer = producer;
+        item->seq = i;
+        mpsc_queue_push(&queue, &item->node);
+    }
+    return 0;
+}
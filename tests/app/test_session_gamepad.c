@@ -0,0 +1,118 @@
+#include "unity.h"
+#include "app.h"
+#include "stream/input/session_input.h"
+
+#include <Limelight.h>
+#include <string.h>
+
+#define INSTANCE_ID 7
+
+typedef struct sent_packet_t {
+    int buttons;
+    short leftStickX, leftStickY;
+} sent_packet_t;
+
+static CONFIGURATION config;
+static app_input_t app_input;
+static stream_input_t input;
+static int packets;
+static sent_packet_t last_packet;
+
+/* Linked with --wrap, so packets are counted instead of sent */
+int __wrap_LiSendMultiControllerEvent(short controllerNumber, short activeGamepadMask, int buttonFlags,
+                                      unsigned char leftTrigger, unsigned char rightTrigger, short leftStickX,
+                                      short leftStickY, short rightStickX, short rightStickY) {
+    (void) controllerNumber;
+    (void) activeGamepadMask;
+    (void) leftTrigger;
+    (void) rightTrigger;
+    (void) rightStickX;
+    (void) rightStickY;
+    packets++;
+    last_packet.buttons = buttonFlags;
+    last_packet.leftStickX = leftStickX;
+    last_packet.leftStickY = leftStickY;
+    return 0;
+}
+
+static void send_axis(SDL_GameControllerAxis axis, Sint16 value) {
+    SDL_ControllerAxisEvent event = {.type = SDL_CONTROLLERAXISMOTION, .which = INSTANCE_ID, .axis = axis,
+            .value = value};
+    stream_input_handle_caxis(&input, &event);
+}
+
+static void send_button(SDL_GameControllerButton button, bool pressed) {
+    SDL_ControllerButtonEvent event = {.type = pressed ? SDL_CONTROLLERBUTTONDOWN : SDL_CONTROLLERBUTTONUP,
+            .which = INSTANCE_ID, .button = button, .state = pressed ? SDL_PRESSED : SDL_RELEASED};
+    stream_input_handle_cbutton(&input, &event);
+}
+
+void setUp() {
+    memset(&config, 0, sizeof(config));
+    app_configuration = &config;
+    memset(&app_input, 0, sizeof(app_input));
+    app_input.max_num_gamepads = 4;
+    for (int i = 0; i < 4; i++) {
+        app_input.gamepads[i].instance_id = -1;
+        app_input.gamepads[i].gs_id = (short) i;
+    }
+    app_input.gamepads[0].instance_id = INSTANCE_ID;
+    app_input.gamepads_count = 1;
+    app_input.activeGamepadMask = 1;
+    memset(&input, 0, sizeof(input));
+    input.input = &app_input;
+    packets = 0;
+    memset(&last_packet, 0, sizeof(last_packet));
+}
+
+void tearDown() {
+    app_configuration = NULL;
+}
+
+void testAxisEventsMergedIntoOnePacket() {
+    send_axis(SDL_CONTROLLER_AXIS_LEFTX, 1000);
+    send_axis(SDL_CONTROLLER_AXIS_LEFTX, 2000);
+    send_axis(SDL_CONTROLLER_AXIS_LEFTY, -3000);
+    TEST_ASSERT_EQUAL_INT(0, packets);
+
+    stream_input_flush_gamepads(&input);
+    TEST_ASSERT_EQUAL_INT(1, packets);
+    TEST_ASSERT_EQUAL_INT(2, input.gamepad_packets_saved);
+    // Packet carries the latest value of every axis
+    TEST_ASSERT_EQUAL_INT(2000, last_packet.leftStickX);
+    TEST_ASSERT_EQUAL_INT(3000, last_packet.leftStickY);
+
+    // Nothing changed since
+    stream_input_flush_gamepads(&input);
+    TEST_ASSERT_EQUAL_INT(1, packets);
+}
+
+void testButtonEdgesSentImmediately() {
+    send_button(SDL_CONTROLLER_BUTTON_A, true);
+    TEST_ASSERT_EQUAL_INT(1, packets);
+    TEST_ASSERT_EQUAL_INT(A_FLAG, last_packet.buttons);
+
+    send_button(SDL_CONTROLLER_BUTTON_A, false);
+    TEST_ASSERT_EQUAL_INT(2, packets);
+    TEST_ASSERT_EQUAL_INT(0, last_packet.buttons);
+}
+
+void testButtonEdgeCarriesPendingAxis() {
+    send_axis(SDL_CONTROLLER_AXIS_LEFTX, 1000);
+    send_button(SDL_CONTROLLER_BUTTON_B, true);
+    TEST_ASSERT_EQUAL_INT(1, packets);
+    TEST_ASSERT_EQUAL_INT(B_FLAG, last_packet.buttons);
+    TEST_ASSERT_EQUAL_INT(1000, last_packet.leftStickX);
+
+    // Axis change went out with the button, so there is nothing left to flush
+    stream_input_flush_gamepads(&input);
+    TEST_ASSERT_EQUAL_INT(1, packets);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testAxisEventsMergedIntoOnePacket);
+    RUN_TEST(testButtonEdgesSentImmediately);
+    RUN_TEST(testButtonEdgeCarriesPendingAxis);
+    return UNITY_END();
+}
@@ -0,0 +1,91 @@
+#include "unity.h"
+#include "util/thumbcache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static char path[64];
+
+void setUp() {
+    snprintf(path, sizeof(path), "/tmp/moonlight-test-%d.thumb", rand());
+}
+
+void tearDown() {
+    remove(path);
+}
+
+static SDL_Surface *create_pattern(int w, int h) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (int y = 0; y < h; y++) {
+        Uint32 *row = (Uint32 *) ((Uint8 *) surface->pixels + y * surface->pitch);
+        for (int x = 0; x < w; x++) {
+            row[x] = 0xFF000000 | (x << 8) | y;
+        }
+    }
+    return surface;
+}
+
+void testRoundTrip() {
+    SDL_Surface *surface = create_pattern(7, 5);
+    thumbcache_meta_t meta = {.width = 14, .height = 10, .rect = {1, 0, 5, 5}, .alpha = false};
+    TEST_ASSERT_TRUE(thumbcache_write(path, surface, &meta));
+
+    SDL_Surface *read = NULL;
+    thumbcache_meta_t read_meta;
+    TEST_ASSERT_EQUAL_INT(THUMBCACHE_HIT, thumbcache_read(path, &read, &read_meta));
+    TEST_ASSERT_NOT_NULL(read);
+    TEST_ASSERT_EQUAL_INT(SDL_PIXELFORMAT_ARGB8888, read->format->format);
+    TEST_ASSERT_EQUAL_INT(7, read->w);
+    TEST_ASSERT_EQUAL_INT(5, read->h);
+    TEST_ASSERT_EQUAL_INT(surface->pitch, read->pitch);
+    TEST_ASSERT_EQUAL_MEMORY(surface->pixels, read->pixels, surface->pitch * surface->h);
+    TEST_ASSERT_EQUAL_INT(14, read_meta.width);
+    TEST_ASSERT_EQUAL_INT(10, read_meta.height);
+    TEST_ASSERT_EQUAL_INT(1, read_meta.rect.x);
+    TEST_ASSERT_EQUAL_INT(5, read_meta.rect.w);
+    TEST_ASSERT_FALSE(read_meta.alpha);
+    thumbcache_surface_free(read);
+    SDL_FreeSurface(surface);
+}
+
+void testPlaceholder() {
+    TEST_ASSERT_TRUE(thumbcache_write_placeholder(path));
+    SDL_Surface *read = NULL;
+    thumbcache_meta_t meta;
+    TEST_ASSERT_EQUAL_INT(THUMBCACHE_PLACEHOLDER, thumbcache_read(path, &read, &meta));
+    TEST_ASSERT_NULL(read);
+}
+
+void testMissing() {
+    SDL_Surface *read = NULL;
+    thumbcache_meta_t meta;
+    TEST_ASSERT_EQUAL_INT(THUMBCACHE_MISS, thumbcache_read(path, &read, &meta));
+}
+
+void testTruncated() {
+    SDL_Surface *surface = create_pattern(16, 16);
+    thumbcache_meta_t meta = {.width = 16, .height = 16, .rect = {0, 0, 16, 16}, .alpha = true};
+    TEST_ASSERT_TRUE(thumbcache_write(path, surface, &meta));
+    SDL_FreeSurface(surface);
+
+    FILE *fp = fopen(path, "rb");
+    char buf[256];
+    size_t length = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    fp = fopen(path, "wb");
+    fwrite(buf, 1, length, fp);
+    fclose(fp);
+
+    SDL_Surface *read = NULL;
+    TEST_ASSERT_EQUAL_INT(THUMBCACHE_MISS, thumbcache_read(path, &read, &meta));
+    TEST_ASSERT_NULL(read);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testPlaceholder);
+    RUN_TEST(testMissing);
+    RUN_TEST(testTruncated);
+    return UNITY_END();
+}
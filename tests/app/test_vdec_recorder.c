@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "stream/video/vdec_recorder.h"
+
+static char path[64];
+
+void setUp() {
+    snprintf(path, sizeof(path), "/tmp/moonlight-test-%d.mldu", rand());
+}
+
+void tearDown() {
+    remove(path);
+}
+
+void testRoundTrip() {
+    char sps[] = {0, 0, 0, 1, 0x67, 0x42};
+    char pps[] = {0, 0, 0, 1, 0x68};
+    char picture[4096];
+    memset(picture, 0x5A, sizeof(picture));
+    LENTRY entries[3] = {
+            {.next = &entries[1], .data = sps, .length = sizeof(sps), .bufferType = BUFFER_TYPE_SPS},
+            {.next = &entries[2], .data = pps, .length = sizeof(pps), .bufferType = BUFFER_TYPE_PPS},
+            {.next = NULL, .data = picture, .length = sizeof(picture), .bufferType = BUFFER_TYPE_PICDATA},
+    };
+    DECODE_UNIT idr = {
+            .frameNumber = 1,
+            .frameType = FRAME_TYPE_IDR,
+            .frameHostProcessingLatency = 42,
+            .receiveTimeMs = 1000,
+            .enqueueTimeMs = 1003,
+            .presentationTimeMs = 16,
+            .fullLength = sizeof(sps) + sizeof(pps) + sizeof(picture),
+            .bufferList = &entries[0],
+    };
+    LENTRY slice = {.next = NULL, .data = picture, .length = 100, .bufferType = BUFFER_TYPE_PICDATA};
+    DECODE_UNIT pframe = {
+            .frameNumber = 2,
+            .frameType = FRAME_TYPE_PFRAME,
+            .receiveTimeMs = 1017,
+            .enqueueTimeMs = 1018,
+            .fullLength = 100,
+            .bufferList = &slice,
+    };
+
+    vdec_recording_info_t info = {.video_format = VIDEO_FORMAT_H264, .width = 1920, .height = 1080, .redraw_rate = 60};
+    vdec_recorder_t *recorder = vdec_recorder_open(path, &info);
+    TEST_ASSERT_NOT_NULL(recorder);
+    TEST_ASSERT_TRUE(vdec_recorder_write(recorder, &idr));
+    TEST_ASSERT_TRUE(vdec_recorder_write(recorder, &pframe));
+    TEST_ASSERT_TRUE(vdec_recorder_close(recorder));
+
+    vdec_recording_info_t read_info;
+    vdec_replay_t *replay = vdec_replay_open(path, &read_info);
+    TEST_ASSERT_NOT_NULL(replay);
+    TEST_ASSERT_EQUAL_MEMORY(&info, &read_info, sizeof(info));
+
+    PDECODE_UNIT unit = vdec_replay_read(replay);
+    TEST_ASSERT_NOT_NULL(unit);
+    TEST_ASSERT_EQUAL_INT(1, unit->frameNumber);
+    TEST_ASSERT_EQUAL_INT(FRAME_TYPE_IDR, unit->frameType);
+    TEST_ASSERT_EQUAL_INT(42, unit->frameHostProcessingLatency);
+    TEST_ASSERT_EQUAL_INT(1000, unit->receiveTimeMs);
+    TEST_ASSERT_EQUAL_INT(1003, unit->enqueueTimeMs);
+    TEST_ASSERT_EQUAL_INT(16, unit->presentationTimeMs);
+    TEST_ASSERT_EQUAL_INT(idr.fullLength, unit->fullLength);
+    PLENTRY entry = unit->bufferList;
+    TEST_ASSERT_EQUAL_INT(BUFFER_TYPE_SPS, entry->bufferType);
+    TEST_ASSERT_EQUAL_INT(sizeof(sps), entry->length);
+    TEST_ASSERT_EQUAL_MEMORY(sps, entry->data, sizeof(sps));
+    entry = entry->next;
+    TEST_ASSERT_EQUAL_INT(BUFFER_TYPE_PPS, entry->bufferType);
+    TEST_ASSERT_EQUAL_MEMORY(pps, entry->data, sizeof(pps));
+    entry = entry->next;
+    TEST_ASSERT_EQUAL_INT(sizeof(picture), entry->length);
+    TEST_ASSERT_EQUAL_MEMORY(picture, entry->data, sizeof(picture));
+    TEST_ASSERT_NULL(entry->next);
+
+    unit = vdec_replay_read(replay);
+    TEST_ASSERT_NOT_NULL(unit);
+    TEST_ASSERT_EQUAL_INT(2, unit->frameNumber);
+    TEST_ASSERT_EQUAL_INT(100, unit->bufferList->length);
+    TEST_ASSERT_NULL(unit->bufferList->next);
+    TEST_ASSERT_NULL(vdec_replay_read(replay));
+
+    TEST_ASSERT_TRUE(vdec_replay_rewind(replay));
+    unit = vdec_replay_read(replay);
+    TEST_ASSERT_NOT_NULL(unit);
+    TEST_ASSERT_EQUAL_INT(1, unit->frameNumber);
+    vdec_replay_close(replay);
+}
+
+void testTruncated() {
+    char picture[64] = {0};
+    LENTRY entry = {.next = NULL, .data = picture, .length = sizeof(picture), .bufferType = BUFFER_TYPE_PICDATA};
+    DECODE_UNIT unit = {.frameNumber = 1, .frameType = FRAME_TYPE_PFRAME, .fullLength = sizeof(picture),
+            .bufferList = &entry};
+    vdec_recording_info_t info = {.video_format = VIDEO_FORMAT_H265, .width = 1280, .height = 720, .redraw_rate = 60};
+    vdec_recorder_t *recorder = vdec_recorder_open(path, &info);
+    TEST_ASSERT_TRUE(vdec_recorder_write(recorder, &unit));
+    TEST_ASSERT_TRUE(vdec_recorder_close(recorder));
+
+    // Cut the frame in the middle of its data
+    char content[256];
+    FILE *fp = fopen(path, "rb");
+    size_t size = fread(content, 1, sizeof(content), fp);
+    fclose(fp);
+    fp = fopen(path, "wb");
+    fwrite(content, 1, size - 10, fp);
+    fclose(fp);
+
+    vdec_replay_t *replay = vdec_replay_open(path, &info);
+    TEST_ASSERT_NOT_NULL(replay);
+    TEST_ASSERT_NULL(vdec_replay_read(replay));
+    vdec_replay_close(replay);
+}
+
+void testFrameLargerThanQueue() {
+    size_t length = 17 * 1024 * 1024;
+    char *picture = calloc(1, length);
+    LENTRY entry = {.next = NULL, .data = picture, .length = (int) length, .bufferType = BUFFER_TYPE_PICDATA};
+    DECODE_UNIT unit = {.frameNumber = 1, .frameType = FRAME_TYPE_IDR, .fullLength = (int) length,
+            .bufferList = &entry};
+    vdec_recording_info_t info = {.video_format = VIDEO_FORMAT_H264, .width = 3840, .height = 2160, .redraw_rate = 60};
+    vdec_recorder_t *recorder = vdec_recorder_open(path, &info);
+    TEST_ASSERT_NOT_NULL(recorder);
+    TEST_ASSERT_FALSE(vdec_recorder_write(recorder, &unit));
+    // Recording stays stopped, even for frames that would fit
+    entry.length = unit.fullLength = 64;
+    TEST_ASSERT_FALSE(vdec_recorder_write(recorder, &unit));
+    TEST_ASSERT_FALSE(vdec_recorder_close(recorder));
+    free(picture);
+
+    vdec_replay_t *replay = vdec_replay_open(path, &info);
+    TEST_ASSERT_NOT_NULL(replay);
+    TEST_ASSERT_NULL(vdec_replay_read(replay));
+    vdec_replay_close(replay);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testTruncated);
+    RUN_TEST(testFrameLargerThanQueue);
+    return UNITY_END();
+}
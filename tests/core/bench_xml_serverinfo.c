@@ -0,0 +1,69 @@
+/*
+ * Compares single pass serverinfo parsing with what parse_server_status used to do.
+ * Not part of ctest, build and run with: cmake --build . --target bench_xml_serverinfo
+ */
+#include "libgamestream/xml.h"
+#include "libgamestream/errors.h"
+#include "xml_fixture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCHMARK_ITERATIONS 2000
+
+static const char *const field_names[SERVERINFO_FIELD_COUNT] = {
+        "uniqueid", "mac", "hostname", "currentgame", "PairStatus", "appversion", "state",
+        "ServerCodecModeSupport", "gputype", "GsVersion", "GfeVersion", "HttpsPort", "ExternalPort",
+};
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end);
+
+int main() {
+    size_t size;
+    char *data = fixture_read(FIXTURES_PATH_PREFIX "serverinfo_gfe.xml", &size);
+    if (data == NULL) {
+        fprintf(stderr, "Can't read fixture\n");
+        return 1;
+    }
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        // One parser per field, plus status and display modes
+        xml_status(data, size);
+        for (int j = 0; j < SERVERINFO_FIELD_COUNT; j++) {
+            char *value = NULL;
+            xml_search(data, size, field_names[j], &value);
+            free(value);
+        }
+        PDISPLAY_MODE modes = NULL;
+        xml_modelist(data, size, &modes);
+        modes_free(modes);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double legacy_us = elapsed_us(&start, &end) / BENCHMARK_ITERATIONS;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        SERVERINFO_XML info;
+        if (xml_serverinfo(data, size, &info) != GS_OK) {
+            fprintf(stderr, "Failed to parse fixture\n");
+            free(data);
+            return 1;
+        }
+        xml_serverinfo_clear(&info);
+        modes_free(info.modes);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double single_us = elapsed_us(&start, &end) / BENCHMARK_ITERATIONS;
+
+    printf("serverinfo parse: legacy %.2f us, single pass %.2f us (%.1fx)\n", legacy_us, single_us,
+           legacy_us / single_us);
+    free(data);
+    return 0;
+}
+
+static double elapsed_us(const struct timespec *start, const struct timespec *end) {
+    return (double) (end->tv_sec - start->tv_sec) * 1e6 + (double) (end->tv_nsec - start->tv_nsec) / 1e3;
+}
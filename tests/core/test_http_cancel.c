@@ -0,0 +1,240 @@
+#include "unity.h"
+#include "libgamestream/http.h"
+#include "libgamestream/errors.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+/**
+ * Accepts one connection, optionally answers it, then waits for the client to close it.
+ */
+typedef struct test_server_t {
+    int fd;
+    unsigned short port;
+    const char *response;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool accepted;
+    bool closed;
+} test_server_t;
+
+typedef struct test_request_t {
+    HTTP *http;
+    char url[64];
+    int result;
+} test_request_t;
+
+static test_server_t server;
+static pthread_mutex_t cancel_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool cancelled;
+
+static bool is_cancelled(void *userdata) {
+    (void) userdata;
+    pthread_mutex_lock(&cancel_lock);
+    bool result = cancelled;
+    pthread_mutex_unlock(&cancel_lock);
+    return result;
+}
+
+static void set_cancelled(bool value) {
+    pthread_mutex_lock(&cancel_lock);
+    cancelled = value;
+    pthread_mutex_unlock(&cancel_lock);
+}
+
+static void *server_run(void *arg) {
+    (void) arg;
+    int conn = accept(server.fd, NULL, NULL);
+    if (conn < 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&server.lock);
+    server.accepted = true;
+    pthread_cond_broadcast(&server.cond);
+    pthread_mutex_unlock(&server.lock);
+    char buf[1024];
+    if (server.response != NULL) {
+        if (recv(conn, buf, sizeof(buf), 0) > 0) {
+            send(conn, server.response, strlen(server.response), 0);
+        }
+    }
+    while (recv(conn, buf, sizeof(buf), 0) > 0) {
+    }
+    pthread_mutex_lock(&server.lock);
+    server.closed = true;
+    pthread_cond_broadcast(&server.cond);
+    pthread_mutex_unlock(&server.lock);
+    close(conn);
+    return NULL;
+}
+
+static void server_start(const char *response) {
+    memset(&server, 0, sizeof(server));
+    server.response = response;
+    pthread_mutex_init(&server.lock, NULL);
+    pthread_cond_init(&server.cond, NULL);
+    server.fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    TEST_ASSERT_EQUAL_INT(0, bind(server.fd, (struct sockaddr *) &addr, sizeof(addr)));
+    TEST_ASSERT_EQUAL_INT(0, listen(server.fd, 1));
+    socklen_t len = sizeof(addr);
+    getsockname(server.fd, (struct sockaddr *) &addr, &len);
+    server.port = ntohs(addr.sin_port);
+    pthread_create(&server.thread, NULL, server_run, NULL);
+}
+
+static void *request_run(test_request_t *req) {
+    HTTP_DATA *data = http_data_alloc();
+    req->result = http_request(req->http, req->url, data, true);
+    http_data_free(data);
+    return NULL;
+}
+
+static void request_init(test_request_t *req) {
+    req->http = http_create("/tmp");
+    TEST_ASSERT_NOT_NULL(req->http);
+    // Long enough that a request ending with GS_CANCELLED can only have been aborted by the cancel check
+    http_set_timeout(req->http, 30);
+    http_set_cancel(req->http, is_cancelled, NULL);
+    snprintf(req->url, sizeof(req->url), "http://127.0.0.1:%u/serverinfo", server.port);
+}
+
+void setUp() {
+    set_cancelled(false);
+}
+
+void tearDown() {
+    shutdown(server.fd, SHUT_RDWR);
+    close(server.fd);
+    pthread_join(server.thread, NULL);
+    pthread_cond_destroy(&server.cond);
+    pthread_mutex_destroy(&server.lock);
+}
+
+static bool server_wait_closed() {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+    pthread_mutex_lock(&server.lock);
+    while (!server.closed && pthread_cond_timedwait(&server.cond, &server.lock, &deadline) == 0) {
+    }
+    bool closed = server.closed;
+    pthread_mutex_unlock(&server.lock);
+    return closed;
+}
+
+void testCompletesWhenNotCancelled() {
+    server_start("HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello");
+    test_request_t req;
+    request_init(&req);
+    HTTP_DATA *data = http_data_alloc();
+    TEST_ASSERT_EQUAL_INT(GS_OK, http_request(req.http, req.url, data, true));
+    TEST_ASSERT_EQUAL_INT(5, data->size);
+    TEST_ASSERT_EQUAL_STRING("hello", data->memory);
+    http_data_free(data);
+    http_destroy(req.http);
+}
+
+void testCancelledBeforeStart() {
+    server_start(NULL);
+    test_request_t req;
+    request_init(&req);
+    set_cancelled(true);
+    request_run(&req);
+    TEST_ASSERT_EQUAL_INT(GS_CANCELLED, req.result);
+    http_destroy(req.http);
+}
+
+void testCancelInFlight() {
+    // Host accepts the connection but never answers, like a busy GFE
+    server_start(NULL);
+    test_request_t req;
+    request_init(&req);
+    pthread_t thread;
+    pthread_create(&thread, NULL, (void *(*)(void *)) request_run, &req);
+
+    pthread_mutex_lock(&server.lock);
+    while (!server.accepted) {
+        pthread_cond_wait(&server.cond, &server.lock);
+    }
+    pthread_mutex_unlock(&server.lock);
+    usleep(200 * 1000);
+
+    set_cancelled(true);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_INT(GS_CANCELLED, req.result);
+
+    // Connection must not stay open in the pool
+    TEST_ASSERT_TRUE(server_wait_closed());
+    http_destroy(req.http);
+}
+
+void testInvalidateClosesPooledConnection() {
+    server_start("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello");
+    test_request_t req;
+    request_init(&req);
+    HTTP_DATA *data = http_data_alloc();
+    TEST_ASSERT_EQUAL_INT(GS_OK, http_request(req.http, req.url, data, true));
+    http_data_free(data);
+
+    // Kept alive in the pool until the pool is dropped
+    pthread_mutex_lock(&server.lock);
+    bool closed = server.closed;
+    pthread_mutex_unlock(&server.lock);
+    TEST_ASSERT_FALSE(closed);
+
+    http_pool_invalidate("127.0.0.1", server.port);
+    TEST_ASSERT_TRUE(server_wait_closed());
+    http_destroy(req.http);
+}
+
+static int async_result = 1, async_error = 1;
+
+static void async_cb(int result, HTTP_DATA *data, void *userdata) {
+    (void) data;
+    (void) userdata;
+    async_result = result;
+    // Error state is per thread, this is the one set for this request
+    async_error = gs_get_error(NULL);
+}
+
+/**
+ * Must run last, the async engine can't be started again
+ */
+void testAsyncShutdownAbortsInFlight() {
+    server_start(NULL);
+    test_request_t req;
+    request_init(&req);
+    TEST_ASSERT_EQUAL_INT(GS_OK, http_request_async(req.http, req.url, true, async_cb, NULL));
+    pthread_mutex_lock(&server.lock);
+    while (!server.accepted) {
+        pthread_cond_wait(&server.cond, &server.lock);
+    }
+    pthread_mutex_unlock(&server.lock);
+
+    http_async_shutdown();
+    TEST_ASSERT_EQUAL_INT(GS_CANCELLED, async_result);
+    TEST_ASSERT_EQUAL_INT(GS_CANCELLED, async_error);
+    TEST_ASSERT_NOT_EQUAL(GS_OK, http_request_async(req.http, req.url, true, async_cb, NULL));
+    // Called again on exit, must be a no-op
+    http_async_shutdown();
+    http_destroy(req.http);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testCompletesWhenNotCancelled);
+    RUN_TEST(testCancelledBeforeStart);
+    RUN_TEST(testCancelInFlight);
+    RUN_TEST(testInvalidateClosesPooledConnection);
+    RUN_TEST(testAsyncShutdownAbortsInFlight);
+    return UNITY_END();
+}
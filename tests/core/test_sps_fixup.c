@@ -0,0 +1,69 @@
+#include "unity.h"
+#include "sps.h"
+#include "h264_stream.h"
+
+#include <string.h>
+
+// SPS of a 1080p H.264 stream, without bitstream restriction
+static const unsigned char sps_1080p[] = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x2a, 0xac, 0x2b, 0x40, 0x3c, 0x01, 0x13, 0xf2, 0xe0,
+        0x22, 0x00, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x03, 0x00, 0x79, 0x08,
+};
+
+static h264_stream_t *h264_stream;
+
+void setUp() {
+    h264_stream = h264_new();
+}
+
+void tearDown() {
+    h264_free(h264_stream);
+}
+
+void testBitstreamFixup() {
+    GS_SPS_FIXER fixer = gs_sps_fixer_new(VIDEO_FORMAT_H264, 1920, 1080, GS_SPS_BITSTREAM_FIXUP);
+    TEST_ASSERT_NOT_NULL(fixer);
+    LENTRY entry = {.data = (char *) sps_1080p, .length = sizeof(sps_1080p), .bufferType = BUFFER_TYPE_SPS};
+    unsigned char out[256];
+    size_t length = gs_sps_fix(fixer, &entry, out, sizeof(out));
+    TEST_ASSERT_TRUE(length > 4);
+    TEST_ASSERT_TRUE(length <= sizeof(sps_1080p) + GS_SPS_MAX_GROWTH);
+    TEST_ASSERT_EQUAL_MEMORY(sps_1080p, out, 4);
+
+    TEST_ASSERT_TRUE(read_nal_unit(h264_stream, out + 4, (int) length - 4) >= 0);
+    TEST_ASSERT_EQUAL(NAL_UNIT_TYPE_SPS, h264_stream->nal->nal_unit_type);
+    TEST_ASSERT_EQUAL(42, h264_stream->sps->level_idc);
+    TEST_ASSERT_EQUAL(1, h264_stream->sps->num_ref_frames);
+    TEST_ASSERT_EQUAL(1, h264_stream->sps->vui.bitstream_restriction_flag);
+    TEST_ASSERT_EQUAL(1, h264_stream->sps->vui.max_dec_frame_buffering);
+    TEST_ASSERT_EQUAL(0, h264_stream->sps->vui.num_reorder_frames);
+    gs_sps_fixer_free(fixer);
+}
+
+void testFixersAreIndependent() {
+    GS_SPS_FIXER fixer1 = gs_sps_fixer_new(VIDEO_FORMAT_H264, 1280, 720, GS_SPS_BITSTREAM_FIXUP);
+    GS_SPS_FIXER fixer2 = gs_sps_fixer_new(VIDEO_FORMAT_H264, 1920, 1080, GS_SPS_BITSTREAM_FIXUP);
+    LENTRY entry = {.data = (char *) sps_1080p, .length = sizeof(sps_1080p), .bufferType = BUFFER_TYPE_SPS};
+    unsigned char out1[256], out2[256];
+    size_t length1 = gs_sps_fix(fixer1, &entry, out1, sizeof(out1));
+    size_t length2 = gs_sps_fix(fixer2, &entry, out2, sizeof(out2));
+
+    TEST_ASSERT_TRUE(read_nal_unit(h264_stream, out1 + 4, (int) length1 - 4) >= 0);
+    TEST_ASSERT_EQUAL(32, h264_stream->sps->level_idc);
+    TEST_ASSERT_TRUE(read_nal_unit(h264_stream, out2 + 4, (int) length2 - 4) >= 0);
+    TEST_ASSERT_EQUAL(42, h264_stream->sps->level_idc);
+    gs_sps_fixer_free(fixer1);
+    gs_sps_fixer_free(fixer2);
+}
+
+void testUnsupportedFormat() {
+    TEST_ASSERT_NULL(gs_sps_fixer_new(VIDEO_FORMAT_H265, 1920, 1080, GS_SPS_BITSTREAM_FIXUP));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testBitstreamFixup);
+    RUN_TEST(testFixersAreIndependent);
+    RUN_TEST(testUnsupportedFormat);
+    return UNITY_END();
+}
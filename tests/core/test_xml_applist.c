@@ -0,0 +1,94 @@
+#include "unity.h"
+#include "libgamestream/xml.h"
+#include "libgamestream/errors.h"
+#include "xml_fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct test_item_t {
+    APP_LIST base;
+    int extra;
+} test_item_t;
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+void testParseApplist() {
+    size_t size;
+    char *data = fixture_read(FIXTURES_PATH_PREFIX "applist.xml", &size);
+    TEST_ASSERT_NOT_NULL(data);
+    PAPP_ARRAY apps = NULL;
+    TEST_ASSERT_EQUAL(GS_OK, xml_applist(data, size, sizeof(test_item_t), &apps));
+    TEST_ASSERT_EQUAL(4, apps->count);
+    TEST_ASSERT_EQUAL(sizeof(test_item_t), apps->item_size);
+
+    test_item_t *items = apps->items;
+    TEST_ASSERT_EQUAL_STRING("Desktop", items[0].base.name);
+    TEST_ASSERT_EQUAL(881448767, items[0].base.id);
+    TEST_ASSERT_EQUAL(0, items[0].base.hdr);
+    TEST_ASSERT_EQUAL_STRING("Tom Clancy's Rainbow Six\xC2\xAE Siege", items[1].base.name);
+    TEST_ASSERT_EQUAL(1093255277, items[1].base.id);
+    TEST_ASSERT_EQUAL(1, items[1].base.hdr);
+    // App without title gets an empty name instead of NULL
+    TEST_ASSERT_EQUAL_STRING("", items[2].base.name);
+    TEST_ASSERT_EQUAL(1531374587, items[2].base.id);
+    TEST_ASSERT_EQUAL_STRING("Steam Big Picture", items[3].base.name);
+    for (int i = 0; i < apps->count; i++) {
+        TEST_ASSERT_NULL(items[i].base.next);
+        TEST_ASSERT_EQUAL(0, items[i].extra);
+        TEST_ASSERT_TRUE(APP_ARRAY_ITEM(apps, i) == &items[i].base);
+    }
+    free(apps);
+    free(data);
+}
+
+void testLargeApplist() {
+    const int count = 5000;
+    size_t capacity = 128 + count * 128;
+    char *data = malloc(capacity);
+    size_t size = snprintf(data, capacity, "<root status_code=\"200\">");
+    for (int i = 0; i < count; i++) {
+        size += snprintf(data + size, capacity - size, "<App><AppTitle>Game &amp; %d</AppTitle><ID>%d</ID></App>",
+                         i, i + 1);
+    }
+    size += snprintf(data + size, capacity - size, "</root>");
+
+    PAPP_ARRAY apps = NULL;
+    TEST_ASSERT_EQUAL(GS_OK, xml_applist(data, size, sizeof(APP_LIST), &apps));
+    TEST_ASSERT_EQUAL(count, apps->count);
+    char expected[32];
+    for (int i = 0; i < count; i++) {
+        snprintf(expected, sizeof(expected), "Game & %d", i);
+        TEST_ASSERT_EQUAL_STRING(expected, APP_ARRAY_ITEM(apps, i)->name);
+        TEST_ASSERT_EQUAL(i + 1, APP_ARRAY_ITEM(apps, i)->id);
+    }
+    free(apps);
+    free(data);
+}
+
+void testBadStatus() {
+    char data[] = "<root status_code=\"401\" status_message=\"The client is not authorized\"></root>";
+    PAPP_ARRAY apps = NULL;
+    TEST_ASSERT_EQUAL(GS_ERROR, xml_applist(data, strlen(data), sizeof(APP_LIST), &apps));
+    TEST_ASSERT_NULL(apps);
+}
+
+void testMalformed() {
+    char data[] = "<root status_code=\"200\"><App><AppTitle>Broken</App></root>";
+    PAPP_ARRAY apps = NULL;
+    TEST_ASSERT_EQUAL(GS_INVALID, xml_applist(data, strlen(data), sizeof(APP_LIST), &apps));
+    TEST_ASSERT_NULL(apps);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testParseApplist);
+    RUN_TEST(testLargeApplist);
+    RUN_TEST(testBadStatus);
+    RUN_TEST(testMalformed);
+    return UNITY_END();
+}
@@ -0,0 +1,103 @@
+#include "unity.h"
+#include "libgamestream/xml.h"
+#include "libgamestream/errors.h"
+#include "xml_fixture.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void fields_legacy(char *data, size_t size, char *fields[SERVERINFO_FIELD_COUNT], PDISPLAY_MODE *modes);
+
+static void fields_free(char *fields[SERVERINFO_FIELD_COUNT]);
+
+static const char *const field_names[SERVERINFO_FIELD_COUNT] = {
+        "uniqueid", "mac", "hostname", "currentgame", "PairStatus", "appversion", "state",
+        "ServerCodecModeSupport", "gputype", "GsVersion", "GfeVersion", "HttpsPort", "ExternalPort",
+};
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+static void assert_same_as_legacy(const char *path, const char *hostname) {
+    size_t size;
+    char *data = fixture_read(path, &size);
+    TEST_ASSERT_NOT_NULL(data);
+
+    char *expected[SERVERINFO_FIELD_COUNT];
+    PDISPLAY_MODE expected_modes;
+    fields_legacy(data, size, expected, &expected_modes);
+
+    SERVERINFO_XML info;
+    TEST_ASSERT_EQUAL(GS_OK, xml_serverinfo(data, size, &info));
+    TEST_ASSERT_EQUAL_STRING(hostname, info.fields[SERVERINFO_HOSTNAME]);
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected[i], info.fields[i], field_names[i]);
+    }
+    PDISPLAY_MODE mode = info.modes, expected_mode = expected_modes;
+    for (; mode != NULL && expected_mode != NULL; mode = mode->next, expected_mode = expected_mode->next) {
+        TEST_ASSERT_EQUAL(expected_mode->width, mode->width);
+        TEST_ASSERT_EQUAL(expected_mode->height, mode->height);
+        TEST_ASSERT_EQUAL(expected_mode->refresh, mode->refresh);
+    }
+    TEST_ASSERT_NULL(mode);
+    TEST_ASSERT_NULL(expected_mode);
+
+    xml_serverinfo_clear(&info);
+    modes_free(info.modes);
+    fields_free(expected);
+    modes_free(expected_modes);
+    free(data);
+}
+
+void testParseGfe() {
+    assert_same_as_legacy(FIXTURES_PATH_PREFIX "serverinfo_gfe.xml", "DESKTOP-GFE");
+}
+
+void testParseSunshine() {
+    assert_same_as_legacy(FIXTURES_PATH_PREFIX "serverinfo_sunshine.xml", "sunshine-host");
+}
+
+void testBadStatus() {
+    char data[] = "<root status_code=\"401\" status_message=\"The client is not authorized\"></root>";
+    SERVERINFO_XML info;
+    TEST_ASSERT_EQUAL(GS_ERROR, xml_serverinfo(data, strlen(data), &info));
+    TEST_ASSERT_NULL(info.modes);
+}
+
+void testMalformed() {
+    char data[] = "<root status_code=\"200\"><hostname>broken</root>";
+    SERVERINFO_XML info;
+    TEST_ASSERT_EQUAL(GS_INVALID, xml_serverinfo(data, strlen(data), &info));
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        TEST_ASSERT_NULL(info.fields[i]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testParseGfe);
+    RUN_TEST(testParseSunshine);
+    RUN_TEST(testBadStatus);
+    RUN_TEST(testMalformed);
+    return UNITY_END();
+}
+
+/**
+ * What parse_server_status used to do: one parser per field, plus status and display modes.
+ */
+static void fields_legacy(char *data, size_t size, char *fields[SERVERINFO_FIELD_COUNT], PDISPLAY_MODE *modes) {
+    TEST_ASSERT_EQUAL(GS_OK, xml_status(data, size));
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        TEST_ASSERT_EQUAL(GS_OK, xml_search(data, size, field_names[i], &fields[i]));
+    }
+    TEST_ASSERT_EQUAL(GS_OK, xml_modelist(data, size, modes));
+}
+
+static void fields_free(char *fields[SERVERINFO_FIELD_COUNT]) {
+    for (int i = 0; i < SERVERINFO_FIELD_COUNT; i++) {
+        free(fields[i]);
+    }
+}
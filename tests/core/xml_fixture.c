@@ -0,0 +1,26 @@
+#include "xml_fixture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+char *fixture_read(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(len);
+    *size = fread(data, 1, len, f);
+    fclose(f);
+    return data;
+}
+
+void modes_free(PDISPLAY_MODE modes) {
+    while (modes != NULL) {
+        PDISPLAY_MODE next = modes->next;
+        free(modes);
+        modes = next;
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+
+#include "libgamestream/xml.h"
+
+#ifndef FIXTURES_PATH_PREFIX
+#define FIXTURES_PATH_PREFIX "./"
+#endif
+
+/**
+ * Read a whole fixture file. Returns NULL if it can't be opened, otherwise the caller frees the result.
+ */
+char *fixture_read(const char *path, size_t *size);
+
+void modes_free(PDISPLAY_MODE modes);